@@ -18,9 +18,14 @@
  * along with this program.  If not, see <https://www.gnu.org/licenses/>.
  */
 
+#ifdef __linux__
+#define _GNU_SOURCE             /* tee, splice and F_SETPIPE_SZ */
+#else
 #define _POSIX_C_SOURCE 200809L
+#endif
 
 #include <stdio.h>
+#include <stdarg.h>
 #include <stdlib.h>
 #include <string.h>
 #include <errno.h>
@@ -28,222 +33,4566 @@
 #include <unistd.h>
 #include <getopt.h>
 #include <stdint.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdatomic.h>
+#include <sys/stat.h>
+#include <sys/xattr.h>
+#include <dirent.h>
+#include <inttypes.h>
+#include <time.h>
+#include <sys/mman.h>
+#include <sys/ioctl.h>
+#ifdef __linux__
+#include <linux/fs.h>
+#endif
 
 #include "checksum.h"
+#include "checksum_kernels.h"
+
+/* Smallest byte range worth handing to a worker thread */
+#define PARALLEL_MIN_CHUNK  (4 * 1024 * 1024)
+/* Per-worker pread buffer */
+#define PARALLEL_BUF_SIZE   (1024 * 1024)
+#define MAX_JOBS            1024
+/* read() buffer for whole-file hashing, one per thread */
+#define READ_BUF_SIZE       (256 * 1024)
+/* Files a multi-file worker may finish ahead of the output cursor */
+#define REORDER_WINDOW      4096
+/* Most algorithms one run may compute side by side */
+#define MAX_ALGOS           8
+/* Each algorithm gets this much of a buffer before the next one runs, so
+ * the slice is still in L1/L2 when the following algorithm reads it */
+#define MULTI_SLICE         (32 * 1024)
+/* Mapped BLAKE3 input handed to the worker threads at a time */
+#define MAPPED_SLICE        (64 * 1024 * 1024)
+/* Buffers in flight between the reader and per-algorithm threads */
+#define RING_SLOTS          8
+/* Cached digests are stored as "user.checksum.<algo>" extended attributes */
+#define CACHE_XATTR_PREFIX  "user.checksum."
+/* Files modified this recently may change again within the same mtime
+ * tick, so their digests are not cached */
+#define CACHE_RACY_SECONDS  2
+/* --progress refresh interval on a terminal, and when logging to a file */
+#define PROGRESS_TTY_MS     500
+#define PROGRESS_LOG_MS     10000
+/* Hashing threads whose current file can be shown */
+#define PROGRESS_SLOTS      64
+/* Pipe buffer requested for standard input and --tee (the default
+ * unprivileged pipe-max-size), and the matching read size */
+#define STDIN_PIPE_SIZE     (1024 * 1024)
 
 static const char *program_name = "checksum";
-static checksum_type_t checksum_type = CHECKSUM_CRC32;
 
-static void print_usage(void) {
-    printf("Usage: %s [OPTIONS] [FILE...]\n\n", program_name);
-    printf("Calculate checksums for files\n\n");
-    printf("Options:\n");
-    printf("  -c, --crc32        calculate CRC32 checksum (default)\n");
-    printf("  -s, --sum          calculate BSD sum checksum\n");
-    printf("  -a, --adler32      calculate Adler-32 checksum\n");
-    printf("  -v, --verify FILE  verify checksums from FILE\n");
-    printf("  -q, --quiet        don't print filenames\n");
-    printf("  -h, --help         display this help and exit\n");
-    printf("  --version          output version information and exit\n\n");
-    printf("If no FILE is specified, read from standard input.\n");
+enum {
+    CACHE_OFF = CHECKSUM_CACHE_OFF,
+    CACHE_USE = CHECKSUM_CACHE_USE,
+    CACHE_REFRESH = CHECKSUM_CACHE_REFRESH
+};
+
+/*
+ * Progress counters for --progress and SIGUSR1. Readers only add to
+ * relaxed atomics after each buffer; a reporter thread samples them, so
+ * the hashing hot path never formats, locks or writes anything. Each
+ * hashing thread owns a slot naming its current file; the slot lock is
+ * only taken when a file starts or ends.
+ */
+typedef struct {
+    atomic_int ready;               /* lock initialized by the owning thread */
+    pthread_mutex_t lock;
+    const char *name;               /* current file, NULL if idle; under lock */
+    uint64_t size;                  /* 0 if unknown; under lock */
+    uint64_t start_ns;              /* under lock */
+    _Atomic uint64_t done;
+} progress_slot_t;
+
+static struct {
+    int track;                      /* --progress: stat files for their sizes */
+    _Atomic uint64_t bytes;
+    _Atomic uint64_t files;
+    _Atomic uint64_t total_bytes;   /* expected, 0 if unknown */
+    _Atomic uint64_t total_files;
+    atomic_uint next_slot;
+    progress_slot_t slots[PROGRESS_SLOTS];
+} progress;
+
+static _Thread_local progress_slot_t *progress_slot;
+
+static uint64_t monotonic_ns(void) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+static void progress_add(uint64_t len) {
+    atomic_fetch_add_explicit(&progress.bytes, len, memory_order_relaxed);
+    if (progress_slot) {
+        atomic_fetch_add_explicit(&progress_slot->done, len, memory_order_relaxed);
+    }
+}
+
+/* Show fd's file as this thread's current one until progress_file_end() */
+static void progress_file_begin(const char *name, int fd) {
+    static _Thread_local progress_slot_t *owned;
+    struct stat st;
+    uint64_t size = 0;
+
+    if (!owned) {
+        unsigned int i = atomic_fetch_add_explicit(&progress.next_slot, 1, memory_order_relaxed);
+
+        if (i >= PROGRESS_SLOTS) {
+            return;     /* counted in the totals only */
+        }
+        owned = &progress.slots[i];
+        pthread_mutex_init(&owned->lock, NULL);
+        atomic_store_explicit(&owned->ready, 1, memory_order_release);
+    }
+    if (progress.track && fstat(fd, &st) == 0 && S_ISREG(st.st_mode)) {
+        size = (uint64_t)st.st_size;
+    }
+
+    pthread_mutex_lock(&owned->lock);
+    owned->name = name;
+    owned->size = size;
+    owned->start_ns = monotonic_ns();
+    atomic_store_explicit(&owned->done, 0, memory_order_relaxed);
+    pthread_mutex_unlock(&owned->lock);
+    progress_slot = owned;
+}
+
+static void progress_file_end(void) {
+    atomic_fetch_add_explicit(&progress.files, 1, memory_order_relaxed);
+    if (progress_slot) {
+        pthread_mutex_lock(&progress_slot->lock);
+        progress_slot->name = NULL;
+        pthread_mutex_unlock(&progress_slot->lock);
+        progress_slot = NULL;
+    }
+}
+
+/*
+ * What a hashing run computes, and which process-wide state it may use:
+ * the xattr cache and the --progress counters are the CLI's, never a
+ * library caller's.
+ */
+typedef struct {
+    const checksum_type_t *types;   /* at most MAX_ALGOS, in result order */
+    size_t count;
+    int cache;                      /* CACHE_OFF, CACHE_USE or CACHE_REFRESH */
+    int progress;                   /* count bytes and files for --progress */
+} hash_spec_t;
+
+/*
+ * One context per selected algorithm, all fed from the same reads.
+ * Results are stored in hash_spec_t order.
+ */
+typedef struct {
+    checksum_ctx_t ctx[MAX_ALGOS];
+    size_t count;
+    int progress;
+} multi_ctx_t;
+
+static void multi_init(multi_ctx_t *multi, hash_spec_t spec) {
+    multi->count = spec.count;
+    multi->progress = spec.progress;
+    for (size_t i = 0; i < spec.count; i++) {
+        checksum_init(&multi->ctx[i], spec.types[i]);
+    }
+}
+
+static void multi_update(multi_ctx_t *multi, const unsigned char *data, size_t len) {
+    if (multi->progress) {
+        progress_add(len);
+    }
+    while (len > 0) {
+        size_t n = len < MULTI_SLICE ? len : MULTI_SLICE;
+
+        for (size_t i = 0; i < multi->count; i++) {
+            checksum_update(&multi->ctx[i], data, n);
+        }
+        data += n;
+        len -= n;
+    }
+}
+
+static void multi_final(const multi_ctx_t *multi, checksum_result_t *results) {
+    for (size_t i = 0; i < multi->count; i++) {
+        checksum_final(&multi->ctx[i], &results[i]);
+    }
+}
+
+static void multi_zeros(multi_ctx_t *multi, uint64_t len) {
+    if (multi->progress) {
+        progress_add(len);
+    }
+    for (size_t i = 0; i < multi->count; i++) {
+        checksum_update_zeros(&multi->ctx[i], len);
+    }
+}
+
+/*
+ * Hash bytes [pos, end) of a regular file with pread. Holes reported by
+ * SEEK_DATA/SEEK_HOLE are folded in with checksum_update_zeros() instead
+ * of being read; filesystems without hole support report one data extent.
+ * Returns 0 on success or an errno value.
+ */
+static int hash_range(multi_ctx_t *multi, int fd, unsigned char *buf, size_t bufsize,
+                      off_t pos, off_t end) {
+    int sparse = 1;
+
+    while (pos < end) {
+        off_t extent_end = end;
+
+        if (sparse) {
+            off_t data = lseek(fd, pos, SEEK_DATA);
+
+            if (data < 0 && errno == ENXIO) {
+                data = end;     /* only a hole remains */
+            } else if (data < 0) {
+                sparse = 0;     /* no hole support: read everything */
+                data = pos;
+            }
+            if (data > end) {
+                data = end;
+            }
+            if (data > pos) {
+                multi_zeros(multi, (uint64_t)(data - pos));
+                pos = data;
+                continue;
+            }
+            if (sparse) {
+                off_t hole = lseek(fd, pos, SEEK_HOLE);
+
+                if (hole > pos && hole < end) {
+                    extent_end = hole;
+                }
+            }
+        }
+
+        while (pos < extent_end) {
+            size_t want = extent_end - pos < (off_t)bufsize ? (size_t)(extent_end - pos) : bufsize;
+            ssize_t got = pread(fd, buf, want, pos);
+
+            if (got < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                return errno;
+            }
+            if (got == 0) {
+                return EIO;     /* file shrank underneath us */
+            }
+            multi_update(multi, buf, (size_t)got);
+            pos += got;
+        }
+    }
+    return 0;
+}
+
+/*
+ * Hash everything readable from fd with plain read() into the caller's
+ * buffer. Returns 0 on success or an errno value.
+ */
+static int hash_fd(int fd, hash_spec_t spec, unsigned char *buf, size_t bufsize,
+                   checksum_result_t *results) {
+    multi_ctx_t multi;
+    struct stat st;
+    ssize_t got;
+
+    multi_init(&multi, spec);
+    posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+
+    /* Files with fewer blocks than their size have holes to skip */
+    if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode) &&
+        (uint64_t)st.st_blocks * 512 < (uint64_t)st.st_size) {
+        off_t pos = lseek(fd, 0, SEEK_CUR);
+
+        if (pos >= 0 && pos <= st.st_size) {
+            int err = hash_range(&multi, fd, buf, bufsize, pos, st.st_size);
+
+            if (err != 0) {
+                return err;
+            }
+            multi_final(&multi, results);
+            return 0;
+        }
+    }
+
+    for (;;) {
+        got = read(fd, buf, bufsize);
+        if (got > 0) {
+            multi_update(&multi, buf, (size_t)got);
+        } else if (got == 0) {
+            break;
+        } else if (errno != EINTR) {
+            return errno;
+        }
+    }
+
+    multi_final(&multi, results);
+    return 0;
+}
+
+/*
+ * Digest cache. Each algorithm's digest is kept in its own xattr as
+ * "MTIME_SEC.MTIME_NSEC SIZE INODE HEX" and is only trusted while the
+ * file's mtime, size and inode still match. Files on filesystems without
+ * user xattrs, or that we may not write, are simply hashed every time.
+ */
+static int parse_hex(const char *p, unsigned char *out, size_t size);
+
+static void cache_attr_name(checksum_type_t type, char *name, size_t size) {
+    const char *algo = checksum_name(type);
+    size_t n = strlen(CACHE_XATTR_PREFIX);
+
+    snprintf(name, size, "%s%s", CACHE_XATTR_PREFIX, algo);
+    for (char *p = name + n; *p; p++) {
+        if (*p >= 'A' && *p <= 'Z') {
+            *p = (char)(*p - 'A' + 'a');
+        }
+    }
+}
+
+/*
+ * Stat fd into st and, in CACHE_USE mode, fill results from the cached
+ * digests. Returns 1 only if every selected algorithm had a valid entry.
+ * If fstat fails st is zeroed, which cache_save() takes as not a regular
+ * file, so nothing is cached from it.
+ */
+static int cache_load(int fd, hash_spec_t spec, struct stat *st, checksum_result_t *results) {
+    if (fstat(fd, st) != 0) {
+        memset(st, 0, sizeof(*st));
+        return 0;
+    }
+    if (!S_ISREG(st->st_mode)) {
+        return 0;
+    }
+    if (spec.cache != CACHE_USE) {
+        return 0;
+    }
+
+    for (size_t i = 0; i < spec.count; i++) {
+        char name[64], value[128], hex[2 * CHECKSUM_MAX_DIGEST + 1];
+        size_t digest_len = checksum_digest_size(spec.types[i]);
+        long long sec;
+        long nsec;
+        unsigned long long size, ino;
+        ssize_t got;
+
+        cache_attr_name(spec.types[i], name, sizeof(name));
+        got = fgetxattr(fd, name, value, sizeof(value) - 1);
+        if (got <= 0) {
+            return 0;
+        }
+        value[got] = '\0';
+
+        if (sscanf(value, "%lld.%ld %llu %llu %64s", &sec, &nsec, &size, &ino, hex) != 5 ||
+            sec != (long long)st->st_mtim.tv_sec || nsec != st->st_mtim.tv_nsec ||
+            size != (unsigned long long)st->st_size || ino != (unsigned long long)st->st_ino ||
+            strlen(hex) != 2 * digest_len ||
+            parse_hex(hex, results[i].digest, digest_len) != 0) {
+            return 0;
+        }
+
+        results[i].type = spec.types[i];
+        results[i].bytes_processed = (size_t)st->st_size;
+        results[i].digest_len = digest_len;
+        results[i].value = ((uint32_t)results[i].digest[0] << 24) |
+                           ((uint32_t)results[i].digest[1] << 16) |
+                           ((uint32_t)results[i].digest[2] << 8) | results[i].digest[3];
+    }
+    return 1;
+}
+
+/* Record fresh digests, unless the file changed since cache_load() */
+static void cache_save(int fd, hash_spec_t spec, const struct stat *before,
+                       const checksum_result_t *results) {
+    struct stat st;
+    struct timespec now;
+
+    if (spec.cache == CACHE_OFF || !S_ISREG(before->st_mode) || fstat(fd, &st) != 0 ||
+        st.st_mtim.tv_sec != before->st_mtim.tv_sec ||
+        st.st_mtim.tv_nsec != before->st_mtim.tv_nsec ||
+        st.st_size != before->st_size || st.st_ino != before->st_ino) {
+        return;
+    }
+    if (clock_gettime(CLOCK_REALTIME, &now) == 0 &&
+        st.st_mtim.tv_sec > now.tv_sec - CACHE_RACY_SECONDS) {
+        return;
+    }
+
+    for (size_t i = 0; i < spec.count; i++) {
+        char name[64], value[128];
+        int len = snprintf(value, sizeof(value), "%lld.%09ld %llu %llu ",
+                           (long long)st.st_mtim.tv_sec, (long)st.st_mtim.tv_nsec,
+                           (unsigned long long)st.st_size, (unsigned long long)st.st_ino);
+
+        for (size_t b = 0; b < results[i].digest_len; b++) {
+            len += snprintf(value + len, sizeof(value) - (size_t)len, "%02x", results[i].digest[b]);
+        }
+        cache_attr_name(spec.types[i], name, sizeof(name));
+        if (fsetxattr(fd, name, value, (size_t)len, 0) != 0) {
+            return;     /* read-only, not ours, or no xattr support */
+        }
+    }
+}
+
+static int hash_path(const char *filename, hash_spec_t spec, unsigned char *buf, size_t bufsize,
+                     checksum_result_t *results) {
+    struct stat st;
+    int fd, err;
+
+    fd = open(filename, O_RDONLY);
+    if (fd == -1) {
+        return errno;
+    }
+
+    if (spec.progress) {
+        progress_file_begin(filename, fd);
+    }
+    if (spec.cache != CACHE_OFF && cache_load(fd, spec, &st, results)) {
+        if (spec.progress) {
+            progress_add((uint64_t)st.st_size);
+        }
+        err = 0;
+    } else {
+        err = hash_fd(fd, spec, buf, bufsize, results);
+        if (err == 0 && spec.cache != CACHE_OFF) {
+            cache_save(fd, spec, &st, results);
+        }
+    }
+    if (spec.progress) {
+        progress_file_end();
+    }
+    close(fd);
+    return err;
+}
+
+/*
+ * Multi-file mode: a pool of workers claims files in list order and parks
+ * results in a ring of REORDER_WINDOW slots; the calling thread hands them
+ * to an emit callback strictly in order as they complete.
+ */
+typedef struct {
+    checksum_result_t results[MAX_ALGOS];
+    int error;
+    int done;
+} file_slot_t;
+
+/* Called in list order; a nonzero return stops the run early */
+typedef int (*emit_fn)(size_t index, const file_slot_t *result, void *ctx);
+
+typedef struct {
+    char **files;
+    size_t count;
+    hash_spec_t spec;
+    size_t next;        /* next file to claim */
+    size_t printed;     /* files [0, printed) have been emitted */
+    size_t prefetch;    /* readahead distance in files, 0 to disable */
+    int stop;
+    file_slot_t *slots;
+    pthread_mutex_t lock;
+    pthread_cond_t ready;   /* a slot was filled */
+    pthread_cond_t space;   /* the output cursor advanced */
+} file_pool_t;
+
+/* Start readahead for a file that will be hashed soon */
+static void prefetch_path(const char *filename) {
+    int fd = open(filename, O_RDONLY);
+
+    if (fd != -1) {
+        posix_fadvise(fd, 0, 0, POSIX_FADV_WILLNEED);
+        close(fd);
+    }
+}
+
+static void *file_worker(void *arg) {
+    file_pool_t *pool = arg;
+    unsigned char *buf = malloc(READ_BUF_SIZE);
+
+    for (;;) {
+        file_slot_t result = {.done = 1};
+        size_t i, ahead;
+
+        pthread_mutex_lock(&pool->lock);
+        while (!pool->stop && pool->next < pool->count &&
+               pool->next >= pool->printed + REORDER_WINDOW) {
+            pthread_cond_wait(&pool->space, &pool->lock);
+        }
+        if (pool->stop || pool->next >= pool->count) {
+            pthread_mutex_unlock(&pool->lock);
+            break;
+        }
+        i = pool->next++;
+        pthread_mutex_unlock(&pool->lock);
+
+        ahead = i + pool->prefetch;
+        if (pool->prefetch && ahead < pool->count) {
+            prefetch_path(pool->files[ahead]);
+        }
+
+        result.error = buf ? hash_path(pool->files[i], pool->spec, buf, READ_BUF_SIZE,
+                                       result.results)
+                           : ENOMEM;
+
+        pthread_mutex_lock(&pool->lock);
+        pool->slots[i % REORDER_WINDOW] = result;
+        if (i == pool->printed) {
+            pthread_cond_signal(&pool->ready);
+        }
+        pthread_mutex_unlock(&pool->lock);
+    }
+
+    free(buf);
+    return NULL;
+}
+
+/*
+ * Hash files on up to `jobs` threads, emitting results in list order.
+ * Returns 0 when all files were emitted, 1 if the callback stopped the
+ * run, or -1 if no worker could be started.
+ */
+static int run_file_pool(char **files, size_t count, hash_spec_t spec, long jobs, size_t prefetch,
+                         emit_fn emit, void *ctx) {
+    file_pool_t pool;
+    pthread_t *threads;
+    long nworkers = jobs < (long)count ? jobs : (long)count;
+    long started = 0;
+    int result = 0;
+
+    memset(&pool, 0, sizeof(pool));
+    pool.files = files;
+    pool.count = count;
+    pool.spec = spec;
+    pool.prefetch = prefetch;
+    pool.slots = calloc(REORDER_WINDOW, sizeof(*pool.slots));
+    threads = calloc(nworkers, sizeof(*threads));
+    if (!pool.slots || !threads) {
+        free(pool.slots);
+        free(threads);
+        return -1;
+    }
+
+    pthread_mutex_init(&pool.lock, NULL);
+    pthread_cond_init(&pool.ready, NULL);
+    pthread_cond_init(&pool.space, NULL);
+
+    for (long i = 0; i < nworkers; i++) {
+        if (pthread_create(&threads[started], NULL, file_worker, &pool) == 0) {
+            started++;
+        }
+    }
+    if (started == 0) {
+        result = -1;
+        goto cleanup;
+    }
+
+    for (size_t i = 0; i < count; i++) {
+        file_slot_t *slot = &pool.slots[i % REORDER_WINDOW];
+        file_slot_t done;
+        int stop;
+
+        pthread_mutex_lock(&pool.lock);
+        while (!slot->done) {
+            pthread_cond_wait(&pool.ready, &pool.lock);
+        }
+        done = *slot;
+        slot->done = 0;
+        pool.printed = i + 1;
+        pthread_cond_broadcast(&pool.space);
+        pthread_mutex_unlock(&pool.lock);
+
+        stop = emit(i, &done, ctx);
+        if (stop) {
+            pthread_mutex_lock(&pool.lock);
+            pool.stop = 1;
+            pthread_cond_broadcast(&pool.space);
+            pthread_mutex_unlock(&pool.lock);
+            result = 1;
+            break;
+        }
+    }
+
+    for (long i = 0; i < started; i++) {
+        pthread_join(threads[i], NULL);
+    }
+
+cleanup:
+    pthread_cond_destroy(&pool.space);
+    pthread_cond_destroy(&pool.ready);
+    pthread_mutex_destroy(&pool.lock);
+    free(pool.slots);
+    free(threads);
+    return result;
+}
+
+/*
+ * Result lines. With millions of small files, one printf per digest is
+ * what limits throughput, so lines are assembled in a large buffer, hex
+ * comes from a byte-pair table, and the buffer goes out with write(2)
+ * when it fills, after each line on a terminal, and at exit. Anything
+ * else writing to stdout between result lines calls out_flush() first.
+ */
+#define OUT_BUF_SIZE  (256 * 1024)
+
+typedef struct {
+    char data[OUT_BUF_SIZE];
+    size_t used;
+    int line_flush;     /* stdout is a terminal */
+    int zero;           /* -z: end lines with NUL and leave names unescaped */
+    int failed;         /* a write failed and was reported */
+} out_t;
+
+static void out_flush(out_t *out) {
+    size_t done = 0;
+
+    while (done < out->used && !out->failed) {
+        ssize_t n = write(STDOUT_FILENO, out->data + done, out->used - done);
+
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            fprintf(stderr, "%s: write error: %s\n", program_name, strerror(errno));
+            out->failed = 1;
+            break;
+        }
+        done += (size_t)n;
+    }
+    out->used = 0;
+}
+
+static void out_bytes(out_t *out, const char *data, size_t len) {
+    while (len > 0) {
+        size_t room = OUT_BUF_SIZE - out->used;
+        size_t n = len < room ? len : room;
+
+        memcpy(out->data + out->used, data, n);
+        out->used += n;
+        data += n;
+        len -= n;
+        if (out->used == OUT_BUF_SIZE) {
+            out_flush(out);
+        }
+    }
+}
+
+static void out_char(out_t *out, char c) {
+    if (out->used == OUT_BUF_SIZE) {
+        out_flush(out);
+    }
+    out->data[out->used++] = c;
+}
+
+static void out_str(out_t *out, const char *text) {
+    out_bytes(out, text, strlen(text));
+}
+
+/* End a result line with a newline, or with NUL for -z */
+static void out_end_line(out_t *out) {
+    out_char(out, out->zero ? '\0' : '\n');
+    if (out->line_flush) {
+        out_flush(out);
+    }
+}
+
+/*
+ * sha256sum's convention for names with a backslash or newline: the line
+ * starts with a backslash and those characters are escaped. With -z names
+ * are written verbatim, as NUL cannot occur in them.
+ */
+static int name_needs_escape(const out_t *out, const char *name) {
+    return !out->zero && name[strcspn(name, "\\\n")] != '\0';
+}
+
+static void put_name(out_t *out, const char *name) {
+    if (!name_needs_escape(out, name)) {
+        out_str(out, name);
+        return;
+    }
+    for (const char *p = name; *p; p++) {
+        if (*p == '\\') {
+            out_bytes(out, "\\\\", 2);
+        } else if (*p == '\n') {
+            out_bytes(out, "\\n", 2);
+        } else {
+            out_char(out, *p);
+        }
+    }
+}
+
+/*
+ * Verify mode. The manifest is mapped privately and parsed in place:
+ * every entry points into the mapping, and names are NUL-terminated by
+ * overwriting their line terminator, so nothing is copied. Names that
+ * sha256sum escaped (line starts with a backslash) are unescaped in place.
+ */
+typedef struct {
+    char **names;
+    unsigned char *expected;    /* `stride` digest bytes per entry */
+    size_t stride;
+    size_t count;
+    size_t capacity;
+    size_t malformed;
+} manifest_t;
+
+typedef struct {
+    const manifest_t *manifest;
+    hash_spec_t spec;
+    out_t *out;
+    int quiet;
+    int fail_fast;
+    size_t ok;
+    size_t mismatched;
+    size_t missing;
+    size_t unreadable;
+} verify_ctx_t;
+
+static int hex_value(int c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+static int manifest_add(manifest_t *m, char *name, const unsigned char *expected) {
+    if (m->count == m->capacity) {
+        size_t capacity = m->capacity ? m->capacity * 2 : 1024;
+        char **names = realloc(m->names, capacity * sizeof(*names));
+        unsigned char *values;
+
+        if (!names) {
+            return -1;
+        }
+        m->names = names;
+        values = realloc(m->expected, capacity * m->stride);
+        if (!values) {
+            return -1;
+        }
+        m->expected = values;
+        m->capacity = capacity;
+    }
+
+    m->names[m->count] = name;
+    memcpy(&m->expected[m->count * m->stride], expected, m->stride);
+    m->count++;
+    return 0;
+}
+
+/* Decode exactly 2 * size hex digits */
+static int parse_hex(const char *p, unsigned char *out, size_t size) {
+    for (size_t i = 0; i < size; i++) {
+        int hi = hex_value((unsigned char)p[2 * i]);
+        int lo = hi < 0 ? -1 : hex_value((unsigned char)p[2 * i + 1]);
+
+        if (lo < 0) {
+            return -1;
+        }
+        out[i] = (unsigned char)(hi << 4 | lo);
+    }
+    return 0;
+}
+
+/* Undo sha256sum's "\\" and "\n" name escapes in place */
+static int unescape_name(char *name) {
+    char *out = name;
+
+    for (char *p = name; *p; p++) {
+        if (*p != '\\') {
+            *out++ = *p;
+            continue;
+        }
+        if (p[1] == '\\') {
+            *out++ = '\\';
+        } else if (p[1] == 'n') {
+            *out++ = '\n';
+        } else {
+            return -1;
+        }
+        p++;
+    }
+    *out = '\0';
+    return 0;
+}
+
+/*
+ * Match a BSD-style "ALGO (NAME) = HEX" line (after any escape marker) for
+ * type; returns the name, NUL-terminated in place,
+ * or NULL if the line has another form
+ */
+static char *manifest_tag(char *p, checksum_type_t type, unsigned char *value) {
+    const char *algo = checksum_name(type);
+    size_t algo_len = strlen(algo);
+    size_t size = checksum_digest_size(type);
+    size_t len = strlen(p);
+    char *tail;
+
+    if (len <= algo_len + 2 + 4 + 2 * size || strncmp(p, algo, algo_len) != 0 ||
+        p[algo_len] != ' ' || p[algo_len + 1] != '(') {
+        return NULL;
+    }
+    tail = p + len - 2 * size - 4;
+    if (memcmp(tail, ") = ", 4) != 0 || parse_hex(tail + 4, value, size) != 0) {
+        return NULL;
+    }
+    *tail = '\0';
+    return p + algo_len + 2;
+}
+
+/*
+ * Parse "HEX  NAME" / "HEX *NAME" lines, with one space-separated HEX
+ * column per algorithm in spec, or with a single algorithm also the
+ * "ALGO (NAME) = HEX" lines of --tag; returns -1 on allocation failure
+ */
+static int manifest_parse(manifest_t *m, hash_spec_t spec, char *data, size_t size) {
+    char *end = data + size;
+    char *line = data;
+
+    m->stride = 0;
+    for (size_t i = 0; i < spec.count; i++) {
+        m->stride += checksum_digest_size(spec.types[i]);
+    }
+
+    while (line < end) {
+        char *eol = memchr(line, '\n', end - line);
+        char *p = line;
+        unsigned char values[MAX_ALGOS * CHECKSUM_MAX_DIGEST];
+        unsigned char *value = values;
+        size_t columns;
+        char *name;
+        int escaped;
+
+        if (!eol) {
+            eol = end;   /* the caller leaves a spare byte after the data */
+        }
+        *eol = '\0';
+        if (eol > line && eol[-1] == '\r') {
+            eol[-1] = '\0';
+        }
+
+        if (*p == '\0' || *p == '#') {
+            line = eol + 1;
+            continue;
+        }
+
+        escaped = *p == '\\';
+        p += escaped;
+        if (spec.count == 1 && (name = manifest_tag(p, spec.types[0], values)) != NULL) {
+            if (escaped && unescape_name(name) != 0) {
+                m->malformed++;
+            } else if (manifest_add(m, name, values) != 0) {
+                return -1;
+            }
+            line = eol + 1;
+            continue;
+        }
+        for (columns = 0; columns < spec.count; columns++) {
+            size_t size = checksum_digest_size(spec.types[columns]);
+
+            if (columns > 0 && *p++ != ' ') {
+                break;
+            }
+            if (parse_hex(p, value, size) != 0) {
+                break;
+            }
+            p += 2 * size;
+            value += size;
+        }
+
+        /* Separator: two spaces, or a space and the binary-mode '*' */
+        if (columns != spec.count || p[0] != ' ' || (p[1] != ' ' && p[1] != '*') || p[2] == '\0' ||
+            (escaped && unescape_name(p + 2) != 0)) {
+            m->malformed++;
+        } else if (manifest_add(m, p + 2, values) != 0) {
+            return -1;
+        }
+
+        line = eol + 1;
+    }
+
+    return 0;
+}
+
+static void verify_report(verify_ctx_t *ctx, size_t index, const char *status) {
+    const char *name = ctx->manifest->names[index];
+
+    if (!ctx->quiet || strcmp(status, "OK") != 0) {
+        if (name_needs_escape(ctx->out, name)) {
+            out_char(ctx->out, '\\');
+        }
+        put_name(ctx->out, name);
+        out_bytes(ctx->out, ": ", 2);
+        out_str(ctx->out, status);
+        out_end_line(ctx->out);
+    }
+}
+
+static int emit_verify(size_t index, const file_slot_t *result, void *arg) {
+    verify_ctx_t *ctx = arg;
+    const unsigned char *expected = &ctx->manifest->expected[index * ctx->manifest->stride];
+    size_t matched = 0;
+
+    while (result->error == 0 && matched < ctx->spec.count &&
+           memcmp(result->results[matched].digest, expected,
+                  result->results[matched].digest_len) == 0) {
+        expected += result->results[matched].digest_len;
+        matched++;
+    }
+
+    if (result->error == ENOENT) {
+        verify_report(ctx, index, "MISSING");
+        ctx->missing++;
+    } else if (result->error != 0) {
+        fprintf(stderr, "%s: %s: %s\n", program_name, ctx->manifest->names[index],
+                strerror(result->error));
+        verify_report(ctx, index, "FAILED open or read");
+        ctx->unreadable++;
+    } else if (matched != ctx->spec.count) {
+        verify_report(ctx, index, "FAILED");
+        ctx->mismatched++;
+    } else {
+        verify_report(ctx, index, "OK");
+        ctx->ok++;
+        return 0;
+    }
+
+    return ctx->fail_fast;
+}
+
+/* Read a whole non-mappable stream into a malloc'd buffer with a spare byte */
+static char *slurp_fd(int fd, size_t *size) {
+    size_t capacity = 64 * 1024, used = 0;
+    char *data = malloc(capacity + 1);
+
+    while (data) {
+        ssize_t got = read(fd, data + used, capacity - used);
+
+        if (got < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            free(data);
+            return NULL;
+        }
+        if (got == 0) {
+            *size = used;
+            return data;
+        }
+        used += got;
+        if (used == capacity) {
+            char *grown = realloc(data, capacity * 2 + 1);
+            if (!grown) {
+                free(data);
+                errno = ENOMEM;
+                return NULL;
+            }
+            data = grown;
+            capacity *= 2;
+        }
+    }
+
+    errno = ENOMEM;
+    return NULL;
+}
+
+/* checksum_verify_file(), optionally feeding the CLI's --progress counters */
+static int verify_run(const char *checksum_file, const checksum_verify_options_t *options,
+                      int progress) {
+    static const checksum_type_t default_algo = CHECKSUM_CRC32;
+    const checksum_verify_options_t defaults = {.algos = &default_algo, .nalgos = 1};
+    manifest_t manifest = {0};
+    verify_ctx_t ctx = {0};
+    struct stat st;
+    char *data = NULL;
+    unsigned char *buffer = NULL;
+    size_t size = 0, map_size = 0;
+    int fd, mapped = 0, result = 0;
+    const char *label = checksum_file;
+    long workers;
+
+    if (!options) {
+        options = &defaults;
+    }
+    if (!checksum_file || !options->algos || options->nalgos == 0 ||
+        options->nalgos > MAX_ALGOS || options->cache < CACHE_OFF ||
+        options->cache > CACHE_REFRESH) {
+        return CHECKSUM_ERROR_ARG;
+    }
+    for (size_t i = 0; i < options->nalgos; i++) {
+        if (checksum_digest_size(options->algos[i]) == 0) {
+            return CHECKSUM_ERROR_ARG;
+        }
+    }
+    ctx.spec.types = options->algos;
+    ctx.spec.count = options->nalgos;
+    ctx.spec.cache = options->cache;
+    ctx.spec.progress = progress;
+    ctx.quiet = options->quiet;
+    ctx.fail_fast = options->fail_fast;
+    workers = options->jobs < MAX_JOBS ? (long)options->jobs : MAX_JOBS;
+
+    if (strcmp(checksum_file, "-") == 0) {
+        fd = STDIN_FILENO;
+        label = "(standard input)";
+    } else {
+        fd = open(checksum_file, O_RDONLY);
+        if (fd == -1) {
+            fprintf(stderr, "%s: %s: %s\n", program_name, checksum_file, strerror(errno));
+            return 1;
+        }
+    }
+
+    if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0) {
+        /* One spare byte past EOF: the page tail is zero-filled when the
+         * size isn't page-aligned, otherwise fall back to reading */
+        long page = sysconf(_SC_PAGESIZE);
+
+        size = (size_t)st.st_size;
+        if (page > 0 && size % (size_t)page != 0) {
+            map_size = size;
+            data = mmap(NULL, map_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+            if (data == MAP_FAILED) {
+                data = NULL;
+            } else {
+                mapped = 1;
+                posix_madvise(data, map_size, POSIX_MADV_SEQUENTIAL);
+            }
+        }
+    }
+    if (!data) {
+        data = slurp_fd(fd, &size);
+    }
+    if (fd != STDIN_FILENO) {
+        close(fd);
+    }
+    if (!data) {
+        fprintf(stderr, "%s: %s: %s\n", program_name, label, strerror(errno));
+        return 1;
+    }
+
+    fflush(stdout);     /* the caller's output goes first */
+    ctx.out = calloc(1, sizeof(*ctx.out));
+    if (!ctx.out || manifest_parse(&manifest, ctx.spec, data, size) != 0) {
+        fprintf(stderr, "%s: %s: %s\n", program_name, label, strerror(ENOMEM));
+        result = 1;
+        goto cleanup;
+    }
+    ctx.out->line_flush = isatty(STDOUT_FILENO);
+    ctx.out->zero = options->zero;
+    ctx.manifest = &manifest;
+
+    if (manifest.count == 0) {
+        fprintf(stderr, "%s: %s: no properly formatted checksum lines found\n",
+                program_name, label);
+        result = 1;
+        goto cleanup;
+    }
+
+    if (workers < 2 || manifest.count < 2 ||
+        run_file_pool(manifest.names, manifest.count, ctx.spec, workers, (size_t)workers,
+                      emit_verify, &ctx) < 0) {
+        buffer = malloc(READ_BUF_SIZE);
+        if (!buffer) {
+            fprintf(stderr, "%s: %s\n", program_name, strerror(ENOMEM));
+            result = 1;
+            goto cleanup;
+        }
+        for (size_t i = 0; i < manifest.count; i++) {
+            file_slot_t slot = {.done = 1};
+
+            if (i + 1 < manifest.count) {
+                prefetch_path(manifest.names[i + 1]);
+            }
+            slot.error = hash_path(manifest.names[i], ctx.spec, buffer, READ_BUF_SIZE,
+                                   slot.results);
+            if (emit_verify(i, &slot, &ctx)) {
+                break;
+            }
+        }
+    }
+
+    out_flush(ctx.out);
+    if (manifest.malformed) {
+        fprintf(stderr, "%s: WARNING: %zu line%s improperly formatted\n", program_name,
+                manifest.malformed, manifest.malformed == 1 ? " is" : "s are");
+    }
+    if (ctx.missing) {
+        fprintf(stderr, "%s: WARNING: %zu listed file%s missing\n", program_name,
+                ctx.missing, ctx.missing == 1 ? " is" : "s are");
+    }
+    if (ctx.unreadable) {
+        fprintf(stderr, "%s: WARNING: %zu listed file%s could not be read\n", program_name,
+                ctx.unreadable, ctx.unreadable == 1 ? "" : "s");
+    }
+    if (ctx.mismatched) {
+        fprintf(stderr, "%s: WARNING: %zu computed checksum%s did NOT match\n", program_name,
+                ctx.mismatched, ctx.mismatched == 1 ? "" : "s");
+    }
+    if (!ctx.quiet) {
+        size_t checked = ctx.ok + ctx.mismatched + ctx.missing + ctx.unreadable;
+
+        fprintf(stderr, "%s: %zu of %zu file%s verified OK", program_name,
+                ctx.ok, manifest.count, manifest.count == 1 ? "" : "s");
+        if (checked < manifest.count) {
+            fprintf(stderr, " (stopped after %zu)", checked);
+        }
+        fputc('\n', stderr);
+    }
+
+    if (ctx.mismatched || ctx.missing || ctx.unreadable) {
+        result = 1;
+    }
+
+cleanup:
+    free(ctx.out);
+    free(buffer);
+    free(manifest.names);
+    free(manifest.expected);
+    if (mapped) {
+        munmap(data, map_size);
+    } else {
+        free(data);
+    }
+    return result;
+}
+
+int checksum_verify_file(const char *checksum_file, const checksum_verify_options_t *options) {
+    return verify_run(checksum_file, options, 0);
+}
+
+#ifndef CHECKSUM_LIB_ONLY
+static checksum_type_t algos[MAX_ALGOS] = {CHECKSUM_CRC32};
+static size_t nalgos = 1;
+static long jobs = 1;
+static int cache_mode = CACHE_OFF;
+/* --tag: BSD-style "ALGO (NAME) = HEX" lines */
+static int output_tag = 0;
+/* -z: end output lines with NUL and leave names unescaped */
+static int output_zero = 0;
+/* Result lines on standard output */
+static out_t out;
+
+/* The algorithms chosen on the command line, with --cache and --progress */
+static hash_spec_t cli_spec(void) {
+    return (hash_spec_t){algos, nalgos, cache_mode, 1};
+}
+
+static void print_usage(void) {
+    printf("Usage: %s [OPTIONS] [FILE...]\n\n", program_name);
+    printf("Calculate checksums for files\n\n");
+    printf("Options:\n");
+    printf("  -c, --crc32        calculate CRC32 checksum (default)\n");
+    printf("      --crc32c       calculate CRC32C (Castagnoli) checksum\n");
+    printf("  -s, --sum          calculate BSD sum checksum\n");
+    printf("  -a, --adler32      calculate Adler-32 checksum\n");
+    printf("      --sha256       calculate SHA-256 digest (sha256sum format)\n");
+    printf("      --sha1         calculate SHA-1 digest (sha1sum format)\n");
+    printf("      --blake3       calculate BLAKE3 digest (b3sum format)\n");
+    printf("      --xxh64        calculate XXH64 hash (non-cryptographic)\n");
+    printf("      --xxh3         calculate XXH3 64-bit hash (non-cryptographic)\n");
+    printf("      --xxh128       calculate XXH3 128-bit hash (non-cryptographic)\n");
+    printf("  -A, --algorithms LIST\n");
+    printf("                     calculate every algorithm in the comma-separated LIST\n");
+    printf("                     (crc32, crc32c, adler32, sum, sha256, sha1, blake3,\n");
+    printf("                     xxh64, xxh3, xxh128)\n");
+    printf("                     in one pass\n");
+    printf("  -j, --jobs N       use N threads across files, within a large file,\n");
+    printf("                     or one per algorithm (0 = all CPUs)\n");
+    printf("  -v, --verify FILE  verify checksums listed in FILE ('-' for stdin)\n");
+    printf("      --fail-fast    stop verifying at the first failure\n");
+    printf("  -r, --recursive    hash every file under each directory FILE (default .)\n");
+    printf("      --tree         print one Merkle digest per FILE over its sorted\n");
+    printf("                     entries; with -r, print the digest of every subtree\n");
+    printf("      --blocks SIZE  print a map of per-block digests (K, M, G suffixes)\n");
+    printf("      --compare MAP  compare block map MAP with each FILE, itself a block\n");
+    printf("                     map or a file to map, and print differing byte ranges\n");
+    printf("      --signature BASE\n");
+    printf("                     write an rsync-style block signature of BASE\n");
+    printf("      --delta SIG    write a delta turning SIG's base into FILE\n");
+    printf("      --patch DELTA  rebuild the new file from base FILE and DELTA\n");
+    printf("                     (block size for --signature set by --blocks)\n");
+    printf("      --cdc[=AVG|MIN,AVG,MAX]\n");
+    printf("                     split FILEs (with -r, trees) into content-defined\n");
+    printf("                     chunks (default 2K,8K,64K) and report unique bytes;\n");
+    printf("                     chunks are hashed with --xxh128 (default), --xxh3\n");
+    printf("                     or --blake3\n");
+    printf("      --crc=NAME     calculate the catalog CRC NAME (e.g. CRC-16/ARC,\n");
+    printf("                     CRC-64/XZ); --crc=list shows the catalog\n");
+    printf("      --offset N     hash each FILE from byte N (K, M, G suffixes)\n");
+    printf("      --length N     hash only N bytes (default: to the end of FILE)\n");
+    printf("      --ranges LIST  hash each OFFSET[+LENGTH] in the comma-separated\n");
+    printf("                     LIST (or read from @FILE) in parallel, printing\n");
+    printf("                     NAME@OFFSET+LENGTH\n");
+    printf("      --find-dups    list groups of identical files under each directory\n");
+    printf("                     FILE, comparing sizes, then head and tail samples,\n");
+    printf("                     then full digests (BLAKE3 unless chosen)\n");
+    printf("      --link=hard|reflink\n");
+    printf("                     with --find-dups, replace each duplicate with a hard\n");
+    printf("                     link to, or a reflinked copy of, the first file\n");
+    printf("      --cache        reuse digests cached in user.checksum.* xattrs while\n");
+    printf("                     the file's mtime, size and inode are unchanged, and\n");
+    printf("                     cache new ones\n");
+    printf("      --refresh      recompute and re-cache digests, ignoring the cache\n");
+    printf("      --progress     report bytes done, MB/s and ETA for the current file\n");
+    printf("                     and overall on standard error (also on SIGUSR1)\n");
+    printf("      --tee FILE     copy standard input to FILE while hashing it\n");
+    printf("      --tag          print BSD-style 'ALGO (FILE) = HEX' lines\n");
+    printf("  -z, --zero         end each output line with NUL, not newline, and\n");
+    printf("                     don't escape filenames\n");
+    printf("  -q, --quiet        don't print filenames\n");
+    printf("  -h, --help         display this help and exit\n");
+    printf("  --version          output version information and exit\n\n");
+    printf("If no FILE is specified, read from standard input.\n");
+}
+
+static void print_version(void) {
+    printf("%s (dev-utils) 1.0.0\n", program_name);
+    printf("Copyright (C) 2025 AnmiTaliDev\n");
+    printf("License GPLv3+: GNU GPL version 3 or later <https://gnu.org/licenses/gpl.html>.\n");
+    printf("This is free software: you are free to change and redistribute it.\n");
+    printf("There is NO WARRANTY, to the extent permitted by law.\n");
+}
+
+/*
+ * Progress reporter. SIGUSR1 is blocked in every thread and collected here
+ * with sigtimedwait(), so a status dump needs no signal handler; with
+ * --progress the same wait doubles as the refresh timer.
+ */
+static struct {
+    pthread_t thread;
+    int running;
+    int enabled;                    /* --progress */
+    int tty;                        /* redraw one line in place */
+    int clear_stdout;               /* stdout shares that terminal */
+    uint64_t start_ns;
+    atomic_int stop;
+} reporter;
+
+static size_t append(char *buf, size_t size, size_t pos, const char *fmt, ...) {
+    va_list ap;
+    int n;
+
+    if (pos >= size) {
+        return pos;
+    }
+    va_start(ap, fmt);
+    n = vsnprintf(buf + pos, size - pos, fmt, ap);
+    va_end(ap);
+    if (n < 0) {
+        return pos;
+    }
+    return pos + (size_t)n < size ? pos + (size_t)n : size - 1;
+}
+
+static size_t append_bytes(char *buf, size_t size, size_t pos, uint64_t bytes) {
+    static const char *const units[] = {"KiB", "MiB", "GiB", "TiB", "PiB"};
+    double value = (double)bytes / 1024;
+    int unit = 0;
+
+    if (bytes < 1024) {
+        return append(buf, size, pos, "%" PRIu64 " B", bytes);
+    }
+    while (value >= 1024 && unit < 4) {
+        value /= 1024;
+        unit++;
+    }
+    return append(buf, size, pos, "%.1f %s", value, units[unit]);
+}
+
+/* "DONE[/TOTAL PCT%] RATE[ ETA]" for bytes done over elapsed_ns */
+static size_t append_progress(char *buf, size_t size, size_t pos, uint64_t done, uint64_t total,
+                              uint64_t elapsed_ns) {
+    double rate = elapsed_ns ? (double)done / ((double)elapsed_ns / 1e9) : 0;
+
+    pos = append_bytes(buf, size, pos, done);
+    if (total > 0 && total >= done) {
+        uint64_t eta = rate > 0 ? (uint64_t)((double)(total - done) / rate + 0.5) : 0;
+
+        pos = append(buf, size, pos, "/");
+        pos = append_bytes(buf, size, pos, total);
+        pos = append(buf, size, pos, " %3.0f%% %.1f MB/s", 100.0 * (double)done / (double)total,
+                     rate / 1e6);
+        if (rate <= 0) {
+            return append(buf, size, pos, " ETA --:--");
+        }
+        if (eta >= 3600) {
+            return append(buf, size, pos, " ETA %" PRIu64 ":%02u:%02u", eta / 3600,
+                          (unsigned int)(eta / 60 % 60), (unsigned int)(eta % 60));
+        }
+        return append(buf, size, pos, " ETA %u:%02u", (unsigned int)(eta / 60),
+                      (unsigned int)(eta % 60));
+    }
+    return append(buf, size, pos, " %.1f MB/s", rate / 1e6);
+}
+
+/* The longest-running file in progress, then the overall totals */
+static size_t progress_status(char *line, size_t size) {
+    unsigned int nslots = atomic_load_explicit(&progress.next_slot, memory_order_relaxed);
+    uint64_t now = monotonic_ns(), file_size = 0, file_start = 0, file_done = 0;
+    uint64_t files = atomic_load_explicit(&progress.files, memory_order_relaxed);
+    uint64_t total_files = atomic_load_explicit(&progress.total_files, memory_order_relaxed);
+    char name[64] = "";
+    size_t pos;
+
+    for (unsigned int i = 0; i < nslots && i < PROGRESS_SLOTS; i++) {
+        progress_slot_t *slot = &progress.slots[i];
+
+        if (!atomic_load_explicit(&slot->ready, memory_order_acquire)) {
+            continue;
+        }
+        pthread_mutex_lock(&slot->lock);
+        if (slot->name && (!name[0] || slot->start_ns < file_start)) {
+            size_t len = strlen(slot->name);
+
+            /* Keep the end of long paths, where the file name is */
+            if (len >= sizeof(name)) {
+                snprintf(name, sizeof(name), "...%s", slot->name + len - (sizeof(name) - 4));
+            } else {
+                memcpy(name, slot->name, len + 1);
+            }
+            file_size = slot->size;
+            file_start = slot->start_ns;
+            file_done = atomic_load_explicit(&slot->done, memory_order_relaxed);
+        }
+        pthread_mutex_unlock(&slot->lock);
+    }
+
+    pos = append(line, size, 0, "%s: ", program_name);
+    if (name[0]) {
+        pos = append(line, size, pos, "%s ", name);
+        pos = append_progress(line, size, pos, file_done, file_size, now - file_start);
+        pos = append(line, size, pos, " | ");
+    }
+    pos = append(line, size, pos, "total ");
+    pos = append_progress(line, size, pos,
+                          atomic_load_explicit(&progress.bytes, memory_order_relaxed),
+                          atomic_load_explicit(&progress.total_bytes, memory_order_relaxed),
+                          now - reporter.start_ns);
+    if (total_files > 0 && total_files >= files) {
+        return append(line, size, pos, ", %" PRIu64 "/%" PRIu64 " files", files, total_files);
+    }
+    return append(line, size, pos, ", %" PRIu64 " files", files);
+}
+
+static void progress_print(int dump) {
+    char line[512];
+    size_t len = 0;
+    int redraw = reporter.enabled && reporter.tty;
+
+    if (redraw) {
+        line[len++] = '\r';
+    }
+    len = progress_status(line + len, sizeof(line) - 8) + len;
+    if (redraw) {
+        memcpy(line + len, "\033[K", 3);
+        len += 3;
+    }
+    if (!redraw || dump) {
+        line[len++] = '\n';
+    }
+    if (write(STDERR_FILENO, line, len) < 0) {
+        /* nothing useful to do about a failed status line */
+    }
+}
+
+static void *progress_main(void *arg) {
+    long ms = reporter.tty ? PROGRESS_TTY_MS : PROGRESS_LOG_MS;
+    sigset_t set;
+
+    (void)arg;
+    sigemptyset(&set);
+    sigaddset(&set, SIGUSR1);
+
+    for (;;) {
+        struct timespec wait = {ms / 1000, (ms % 1000) * 1000000L};
+        int sig = reporter.enabled ? sigtimedwait(&set, NULL, &wait) : sigwaitinfo(&set, NULL);
+
+        if (atomic_load(&reporter.stop)) {
+            break;
+        }
+        if (sig == SIGUSR1) {
+            progress_print(1);
+        } else if (sig < 0 && errno == EAGAIN) {
+            progress_print(0);
+        }
+    }
+    return NULL;
+}
+
+static void progress_stop(void) {
+    uint64_t elapsed, files;
+    char line[256];
+    size_t len;
+
+    if (!reporter.running) {
+        return;
+    }
+    fflush(stdout);     /* results first, then the summary */
+    out_flush(&out);
+    atomic_store(&reporter.stop, 1);
+    pthread_kill(reporter.thread, SIGUSR1);
+    pthread_join(reporter.thread, NULL);
+    reporter.running = 0;
+    if (!reporter.enabled) {
+        return;
+    }
+
+    elapsed = monotonic_ns() - reporter.start_ns;
+    files = atomic_load_explicit(&progress.files, memory_order_relaxed);
+    len = append(line, sizeof(line), 0, "%s%s: %" PRIu64 " file%s, ", reporter.tty ? "\r" : "",
+                 program_name, files, files == 1 ? "" : "s");
+    len = append_bytes(line, sizeof(line), len,
+                       atomic_load_explicit(&progress.bytes, memory_order_relaxed));
+    len = append(line, sizeof(line), len, " in %.1f s (%.1f MB/s)%s\n", (double)elapsed / 1e9,
+                 (double)atomic_load(&progress.bytes) / 1e6 / ((double)elapsed / 1e9),
+                 reporter.tty ? "\033[K" : "");
+    if (write(STDERR_FILENO, line, len) < 0) {
+        /* as above */
+    }
+}
+
+/* Start the reporter; SIGUSR1 must be blocked before any other thread starts */
+static void progress_start(int enabled) {
+    sigset_t set;
+
+    reporter.enabled = enabled;
+    reporter.tty = isatty(STDERR_FILENO);
+    reporter.clear_stdout = enabled && reporter.tty && isatty(STDOUT_FILENO);
+    reporter.start_ns = monotonic_ns();
+    progress.track = enabled;
+
+    sigemptyset(&set);
+    sigaddset(&set, SIGUSR1);
+    if (pthread_sigmask(SIG_BLOCK, &set, NULL) != 0) {
+        return;
+    }
+    if (pthread_create(&reporter.thread, NULL, progress_main, NULL) != 0) {
+        pthread_sigmask(SIG_UNBLOCK, &set, NULL);
+        return;
+    }
+    reporter.running = 1;
+    atexit(progress_stop);
+}
+
+/* Add to the work expected for the ETA */
+static void progress_expect(uint64_t bytes, uint64_t files) {
+    atomic_fetch_add_explicit(&progress.total_bytes, bytes, memory_order_relaxed);
+    atomic_fetch_add_explicit(&progress.total_files, files, memory_order_relaxed);
+}
+
+/* Combine adjacent finalized checksums; only valid for combinable types */
+static uint32_t combine_sums(checksum_type_t type, uint32_t sum1, uint32_t sum2, uint64_t len2) {
+    switch (type) {
+        case CHECKSUM_CRC32:
+            return checksum_crc32_combine(sum1, sum2, len2);
+        case CHECKSUM_CRC32C:
+            return checksum_crc32c_combine(sum1, sum2, len2);
+        case CHECKSUM_ADLER32:
+            return checksum_adler32_combine(sum1, sum2, len2);
+        default:
+            return 0;
+    }
+}
+
+static int is_combinable(checksum_type_t type) {
+    return type == CHECKSUM_CRC32 || type == CHECKSUM_CRC32C || type == CHECKSUM_ADLER32;
+}
+
+typedef struct {
+    int fd;
+    off_t offset;
+    off_t length;
+    checksum_result_t results[MAX_ALGOS];
+    int error;
+    int running;     /* owned by the spawning thread */
+    progress_slot_t *progress;  /* the spawning thread's, for per-file progress */
+} chunk_job_t;
+
+static void *chunk_worker(void *arg) {
+    chunk_job_t *job = arg;
+    unsigned char *buf = malloc(PARALLEL_BUF_SIZE);
+    multi_ctx_t multi;
+
+    if (!buf) {
+        job->error = ENOMEM;
+        return NULL;
+    }
+
+    progress_slot = job->progress;
+    multi_init(&multi, cli_spec());
+    posix_fadvise(job->fd, job->offset, job->length, POSIX_FADV_SEQUENTIAL);
+    job->error = hash_range(&multi, job->fd, buf, PARALLEL_BUF_SIZE, job->offset,
+                            job->offset + job->length);
+
+    multi_final(&multi, job->results);
+    free(buf);
+    return NULL;
+}
+
+/*
+ * BLAKE3 of one regular file: map it and let the library hash subtrees of
+ * the chunk tree on `jobs` threads with the widest SIMD kernel. Returns 0
+ * on success or -1 if the file should be read serially instead.
+ */
+static int checksum_file_mapped(const char *filename, checksum_result_t *results) {
+    checksum_ctx_t ctx;
+    struct stat st;
+    void *map;
+    int fd;
+
+    if (nalgos != 1 || algos[0] != CHECKSUM_BLAKE3) {
+        return -1;
+    }
+
+    fd = open(filename, O_RDONLY);
+    if (fd == -1) {
+        return -1;   /* let the serial path report the error */
+    }
+    if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode) || st.st_size == 0 ||
+        (uintmax_t)st.st_size > SIZE_MAX) {
+        close(fd);
+        return -1;
+    }
+
+    map = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        return -1;
+    }
+    posix_madvise(map, (size_t)st.st_size, POSIX_MADV_WILLNEED);
+
+    /* Whole slices keep the chunk tree parallel and progress moving */
+    checksum_init(&ctx, CHECKSUM_BLAKE3);
+    for (size_t pos = 0; pos < (size_t)st.st_size; pos += MAPPED_SLICE) {
+        size_t len = (size_t)st.st_size - pos < MAPPED_SLICE ? (size_t)st.st_size - pos
+                                                            : MAPPED_SLICE;
+
+        checksum_update_parallel(&ctx, (const unsigned char *)map + pos, len,
+                                 (unsigned int)jobs);
+        progress_add(len);
+    }
+    checksum_final(&ctx, &results[0]);
+
+    munmap(map, (size_t)st.st_size);
+    return 0;
+}
+
+/*
+ * Hash one regular file as contiguous ranges on worker threads and combine
+ * the per-range checksums in order. The result is identical to a serial
+ * pass. Returns 0 on success, 1 on error, or -1 if the file should be
+ * hashed serially instead.
+ */
+static int checksum_file_parallel(const char *filename, checksum_result_t *results) {
+    chunk_job_t *work;
+    pthread_t *threads;
+    struct stat st;
+    long nworkers;
+    off_t chunk;
+    int fd, result = 0;
+
+    if (jobs < 2) {
+        return -1;
+    }
+    for (size_t a = 0; a < nalgos; a++) {
+        if (!is_combinable(algos[a])) {
+            return -1;
+        }
+    }
+
+    fd = open(filename, O_RDONLY);
+    if (fd == -1) {
+        return -1;   /* let the serial path report the error */
+    }
+
+    if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode) || st.st_size < 2 * PARALLEL_MIN_CHUNK) {
+        close(fd);
+        return -1;
+    }
+
+    nworkers = st.st_size / PARALLEL_MIN_CHUNK;
+    if (nworkers > jobs) {
+        nworkers = jobs;
+    }
+    chunk = st.st_size / nworkers;
+
+    work = calloc(nworkers, sizeof(*work));
+    threads = calloc(nworkers, sizeof(*threads));
+    if (!work || !threads) {
+        free(work);
+        free(threads);
+        close(fd);
+        return -1;
+    }
+
+    for (long i = 0; i < nworkers; i++) {
+        work[i].fd = fd;
+        work[i].offset = i * chunk;
+        work[i].length = (i == nworkers - 1) ? st.st_size - i * chunk : chunk;
+        work[i].progress = progress_slot;
+
+        if (pthread_create(&threads[i], NULL, chunk_worker, &work[i]) == 0) {
+            work[i].running = 1;
+        } else {
+            /* Out of threads: hash the range on this one instead */
+            chunk_worker(&work[i]);
+        }
+    }
+
+    for (long i = 0; i < nworkers; i++) {
+        if (work[i].running) {
+            pthread_join(threads[i], NULL);
+        }
+    }
+
+    memcpy(results, work[0].results, nalgos * sizeof(*results));
+    for (long i = 0; i < nworkers; i++) {
+        if (work[i].error != 0) {
+            fprintf(stderr, "%s: %s: %s\n", program_name, filename, strerror(work[i].error));
+            result = 1;
+            break;
+        }
+        for (size_t a = 0; i > 0 && a < nalgos; a++) {
+            uint32_t value = combine_sums(algos[a], results[a].value, work[i].results[a].value,
+                                          (uint64_t)work[i].length);
+
+            results[a].value = value;
+            results[a].digest[0] = (unsigned char)(value >> 24);
+            results[a].digest[1] = (unsigned char)(value >> 16);
+            results[a].digest[2] = (unsigned char)(value >> 8);
+            results[a].digest[3] = (unsigned char)value;
+            results[a].bytes_processed += work[i].results[a].bytes_processed;
+        }
+    }
+
+    free(work);
+    free(threads);
+    close(fd);
+    return result;
+}
+
+/*
+ * Multi-algorithm pipeline for a single input: the calling thread reads
+ * into a ring of buffers and each algorithm runs on its own thread, so
+ * the slowest algorithm rather than the sum of all of them bounds the
+ * pass. A buffer is reused once every algorithm has consumed it.
+ */
+typedef struct {
+    unsigned char *data;            /* RING_SLOTS buffers of READ_BUF_SIZE */
+    size_t lengths[RING_SLOTS];
+    size_t filled;                  /* buffers produced so far */
+    size_t consumed[MAX_ALGOS];     /* buffers each algorithm has finished */
+    int eof;
+    pthread_mutex_t lock;
+    pthread_cond_t more;            /* a buffer was filled, or EOF */
+    pthread_cond_t room;            /* an algorithm released a buffer */
+} ring_t;
+
+typedef struct {
+    ring_t *ring;
+    size_t index;
+    checksum_ctx_t ctx;
+} ring_reader_t;
+
+static void *ring_worker(void *arg) {
+    ring_reader_t *reader = arg;
+    ring_t *ring = reader->ring;
+
+    for (;;) {
+        size_t slot;
+
+        pthread_mutex_lock(&ring->lock);
+        while (ring->consumed[reader->index] == ring->filled && !ring->eof) {
+            pthread_cond_wait(&ring->more, &ring->lock);
+        }
+        if (ring->consumed[reader->index] == ring->filled) {
+            pthread_mutex_unlock(&ring->lock);
+            break;
+        }
+        slot = ring->consumed[reader->index] % RING_SLOTS;
+        pthread_mutex_unlock(&ring->lock);
+
+        checksum_update(&reader->ctx, ring->data + slot * READ_BUF_SIZE, ring->lengths[slot]);
+
+        pthread_mutex_lock(&ring->lock);
+        ring->consumed[reader->index]++;
+        pthread_cond_signal(&ring->room);
+        pthread_mutex_unlock(&ring->lock);
+    }
+
+    return NULL;
+}
+
+/* Buffers every algorithm has finished with */
+static size_t ring_released(const ring_t *ring) {
+    size_t least = ring->consumed[0];
+
+    for (size_t i = 1; i < nalgos; i++) {
+        if (ring->consumed[i] < least) {
+            least = ring->consumed[i];
+        }
+    }
+    return least;
+}
+
+/*
+ * Returns 0 on success, an errno value on a read error, or -1 if the
+ * threads could not be set up and nothing has been read yet.
+ */
+static int hash_fd_threaded(int fd, checksum_result_t *results) {
+    ring_t ring;
+    ring_reader_t readers[MAX_ALGOS];
+    pthread_t threads[MAX_ALGOS];
+    size_t started = 0;
+    int err = 0;
+
+    memset(&ring, 0, sizeof(ring));
+    ring.data = malloc((size_t)RING_SLOTS * READ_BUF_SIZE);
+    if (!ring.data) {
+        return -1;
+    }
+
+    pthread_mutex_init(&ring.lock, NULL);
+    pthread_cond_init(&ring.more, NULL);
+    pthread_cond_init(&ring.room, NULL);
+
+    for (size_t i = 0; i < nalgos; i++) {
+        readers[i].ring = &ring;
+        readers[i].index = i;
+        checksum_init(&readers[i].ctx, algos[i]);
+        if (pthread_create(&threads[i], NULL, ring_worker, &readers[i]) != 0) {
+            err = -1;
+            break;
+        }
+        started++;
+    }
+
+    posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+
+    while (err == 0) {
+        size_t slot;
+        ssize_t got;
+
+        pthread_mutex_lock(&ring.lock);
+        while (ring.filled - ring_released(&ring) == RING_SLOTS) {
+            pthread_cond_wait(&ring.room, &ring.lock);
+        }
+        slot = ring.filled % RING_SLOTS;
+        pthread_mutex_unlock(&ring.lock);
+
+        got = read(fd, ring.data + slot * READ_BUF_SIZE, READ_BUF_SIZE);
+        if (got == 0) {
+            break;
+        }
+        if (got < 0) {
+            if (errno != EINTR) {
+                err = errno;
+            }
+            continue;
+        }
+        progress_add((uint64_t)got);
+
+        pthread_mutex_lock(&ring.lock);
+        ring.lengths[slot] = (size_t)got;
+        ring.filled++;
+        pthread_cond_broadcast(&ring.more);
+        pthread_mutex_unlock(&ring.lock);
+    }
+
+    pthread_mutex_lock(&ring.lock);
+    ring.eof = 1;
+    pthread_cond_broadcast(&ring.more);
+    pthread_mutex_unlock(&ring.lock);
+
+    for (size_t i = 0; i < started; i++) {
+        pthread_join(threads[i], NULL);
+    }
+    if (err == 0) {
+        for (size_t i = 0; i < nalgos; i++) {
+            checksum_final(&readers[i].ctx, &results[i]);
+        }
+    }
+
+    pthread_cond_destroy(&ring.room);
+    pthread_cond_destroy(&ring.more);
+    pthread_mutex_destroy(&ring.lock);
+    free(ring.data);
+    return err;
+}
+
+/* Byte-pair hex table for result lines */
+static char out_hex_pairs[256][2];
+
+static void out_flush_stdout(void) {
+    out_flush(&out);
+}
+
+static void out_init(void) {
+    static const char digits[] = "0123456789abcdef";
+
+    for (int i = 0; i < 256; i++) {
+        out_hex_pairs[i][0] = digits[i >> 4];
+        out_hex_pairs[i][1] = digits[i & 0xf];
+    }
+    out.line_flush = isatty(STDOUT_FILENO);
+    out.zero = output_zero;
+    atexit(out_flush_stdout);
+}
+
+static void out_hex(const unsigned char *digest, size_t len) {
+    if (out.used + 2 * len > OUT_BUF_SIZE) {
+        out_flush(&out);
+    }
+    for (size_t i = 0; i < len; i++) {
+        memcpy(out.data + out.used, out_hex_pairs[digest[i]], 2);
+        out.used += 2;
+    }
+}
+
+/* The low `digits` hex digits of value, for CRCs whose width isn't whole bytes */
+static void out_hex_value(uint64_t value, int digits) {
+    static const char hex[] = "0123456789abcdef";
+
+    while (digits-- > 0) {
+        out_char(&out, hex[(value >> (4 * digits)) & 0xf]);
+    }
+}
+
+/* Formatted text for the few result lines that need it */
+static void out_printf(const char *fmt, ...) {
+    char line[256];
+    va_list ap;
+    int n;
+
+    va_start(ap, fmt);
+    n = vsnprintf(line, sizeof(line), fmt, ap);
+    va_end(ap);
+    if (n > 0) {
+        out_bytes(&out, line, (size_t)n < sizeof(line) ? (size_t)n : sizeof(line) - 1);
+    }
+}
+
+/* Start a "NAME: " status line, escaped the way -v reports names */
+static void put_status_name(const char *name) {
+    if (name_needs_escape(&out, name)) {
+        out_char(&out, '\\');
+    }
+    put_name(&out, name);
+    out_bytes(&out, ": ", 2);
+}
+
+/* Start a BSD-style "ALGO (NAME) = HEX" line, up to the digest */
+static void put_tag(const char *algo, const char *name) {
+    if (name_needs_escape(&out, name)) {
+        out_char(&out, '\\');
+    }
+    out_str(&out, algo);
+    out_bytes(&out, " (", 2);
+    put_name(&out, name);
+    out_bytes(&out, ") = ", 4);
+}
+
+/*
+ * Print "HEX  NAME" as sha256sum does, escaping names where needed, or
+ * with --tag one "ALGO (NAME) = HEX" line per algorithm
+ */
+static void print_checksum(const checksum_result_t *results, const char *filename, int quiet) {
+    if (reporter.clear_stdout) {
+        out_bytes(&out, "\r\033[K", 4);     /* over the --progress line */
+    }
+    if (output_tag && !quiet) {
+        for (size_t i = 0; i < nalgos; i++) {
+            put_tag(checksum_name(results[i].type), filename);
+            out_hex(results[i].digest, results[i].digest_len);
+            out_end_line(&out);
+        }
+        return;
+    }
+    if (!quiet && name_needs_escape(&out, filename)) {
+        out_char(&out, '\\');
+    }
+    for (size_t i = 0; i < nalgos; i++) {
+        if (i > 0) {
+            out_char(&out, ' ');
+        }
+        out_hex(results[i].digest, results[i].digest_len);
+    }
+    if (!quiet) {
+        out_bytes(&out, "  ", 2);
+        put_name(&out, filename);
+    }
+    out_end_line(&out);
+}
+
+/* A larger pipe lets the writer queue more per wakeup; failure is harmless */
+static void pipe_grow(int fd) {
+#ifdef F_SETPIPE_SZ
+    struct stat st;
+
+    if (fstat(fd, &st) == 0 && S_ISFIFO(st.st_mode)) {
+        fcntl(fd, F_SETPIPE_SZ, STDIN_PIPE_SIZE);
+    }
+#else
+    (void)fd;
+#endif
+}
+
+static int write_all(int fd, const unsigned char *data, size_t len) {
+    while (len > 0) {
+        ssize_t n = write(fd, data, len);
+
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return errno;
+        }
+        data += n;
+        len -= (size_t)n;
+    }
+    return 0;
+}
+
+/*
+ * Hash standard input while copying it to out_fd, for --tee. Read errors
+ * come back as a positive errno and write errors as a negative one.
+ *
+ * When stdin is a pipe, tee(2) duplicates whatever is queued to out_fd
+ * without copying it, straight into out_fd if that is a pipe too, or into
+ * a private relay pipe that splice(2) empties into the file. The read(2)
+ * that then consumes the same bytes feeds the hash, so the stream crosses
+ * into user space once. Otherwise it is read, hashed and written.
+ */
+static int tee_stdin(int out_fd, unsigned char *buf, size_t bufsize,
+                     checksum_result_t *results) {
+    multi_ctx_t multi;
+    ssize_t got;
+    int err = 0;
+
+    multi_init(&multi, cli_spec());
+
+#ifdef __linux__
+    struct stat in_st, out_st;
+
+    if (fstat(STDIN_FILENO, &in_st) == 0 && S_ISFIFO(in_st.st_mode) &&
+        fstat(out_fd, &out_st) == 0) {
+        int relay[2] = {-1, -1};
+        int target = out_fd;
+        int use_splice = 1;
+        ssize_t dup;
+
+        if (!S_ISFIFO(out_st.st_mode)) {
+            if (pipe(relay) != 0) {
+                goto copy;
+            }
+            target = relay[1];
+        }
+        pipe_grow(STDIN_FILENO);
+        pipe_grow(target);
+
+        while ((dup = tee(STDIN_FILENO, target, bufsize, 0)) != 0) {
+            if (dup < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                err = errno == EPIPE ? -EPIPE : errno;
+                break;
+            }
+
+            /* Empty the relay into the file; copy if it can't take splice */
+            for (size_t left = (size_t)dup; relay[0] != -1 && left > 0 && err == 0;) {
+                ssize_t n = use_splice ? splice(relay[0], NULL, out_fd, NULL, left, SPLICE_F_MOVE)
+                                       : read(relay[0], buf, left < bufsize ? left : bufsize);
+
+                if (n < 0 && errno == EINTR) {
+                    continue;
+                }
+                if (n < 0 && use_splice && errno == EINVAL) {
+                    use_splice = 0;
+                    continue;
+                }
+                if (n <= 0) {
+                    err = -(n < 0 ? errno : EIO);
+                } else if (!use_splice) {
+                    err = -write_all(out_fd, buf, (size_t)n);
+                }
+                left -= n > 0 ? (size_t)n : 0;
+            }
+
+            /* Consume the duplicated bytes from stdin and hash them */
+            for (size_t left = (size_t)dup; left > 0 && err == 0;) {
+                got = read(STDIN_FILENO, buf, left < bufsize ? left : bufsize);
+                if (got < 0 && errno == EINTR) {
+                    continue;
+                }
+                if (got <= 0) {
+                    err = got < 0 ? errno : EIO;
+                    break;
+                }
+                multi_update(&multi, buf, (size_t)got);
+                left -= (size_t)got;
+            }
+            if (err != 0) {
+                break;
+            }
+        }
+
+        if (relay[0] != -1) {
+            close(relay[0]);
+            close(relay[1]);
+        }
+        if (err == 0) {
+            multi_final(&multi, results);
+        }
+        return err;
+    }
+copy:
+#endif
+    pipe_grow(STDIN_FILENO);
+    while ((got = read(STDIN_FILENO, buf, bufsize)) != 0) {
+        if (got < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return errno;
+        }
+        multi_update(&multi, buf, (size_t)got);
+        err = write_all(out_fd, buf, (size_t)got);
+        if (err != 0) {
+            return -err;
+        }
+    }
+
+    multi_final(&multi, results);
+    return 0;
+}
+
+static int checksum_tee(const char *path, int quiet) {
+    static unsigned char buffer[STDIN_PIPE_SIZE];
+    checksum_result_t results[MAX_ALGOS];
+    const char *name = "(standard input)";
+    int out_fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0666);
+    int err;
+
+    if (out_fd == -1) {
+        fprintf(stderr, "%s: %s: %s\n", program_name, path, strerror(errno));
+        return 1;
+    }
+
+    progress_file_begin(name, STDIN_FILENO);
+    err = tee_stdin(out_fd, buffer, sizeof(buffer), results);
+    progress_file_end();
+    if (close(out_fd) != 0 && err == 0) {
+        err = -errno;
+    }
+
+    if (err != 0) {
+        fprintf(stderr, "%s: %s: %s\n", program_name, err < 0 ? path : name,
+                strerror(err < 0 ? -err : err));
+        return 1;
+    }
+    print_checksum(results, name, quiet);
+    return 0;
+}
+
+static int checksum_file(const char *filename, int quiet) {
+    static unsigned char buffer[READ_BUF_SIZE];
+    checksum_result_t results[MAX_ALGOS];
+    struct stat st;
+    int fd = STDIN_FILENO;
+    int err = -1;
+    
+    if (!filename) {
+        filename = "(standard input)";
+        pipe_grow(fd);
+        progress_file_begin(filename, fd);
+    } else {
+        int parallel;
+        
+        fd = open(filename, O_RDONLY);
+        if (fd == -1) {
+            fprintf(stderr, "%s: %s: %s\n", program_name, filename, strerror(errno));
+            return 1;
+        }
+        progress_file_begin(filename, fd);
+        if (cache_mode != CACHE_OFF && cache_load(fd, cli_spec(), &st, results)) {
+            progress_add((uint64_t)st.st_size);
+            progress_file_end();
+            close(fd);
+            print_checksum(results, filename, quiet);
+            return 0;
+        }
+        
+        parallel = checksum_file_mapped(filename, results);
+        if (parallel < 0) {
+            parallel = checksum_file_parallel(filename, results);
+        }
+        
+        if (parallel >= 0) {
+            progress_file_end();
+            if (parallel == 0) {
+                if (cache_mode != CACHE_OFF) {
+                    cache_save(fd, cli_spec(), &st, results);
+                }
+                print_checksum(results, filename, quiet);
+            }
+            close(fd);
+            return parallel;
+        }
+    }
+    
+    if (nalgos > 1 && jobs > 1) {
+        err = hash_fd_threaded(fd, results);
+    }
+    if (err == -1) {
+        err = hash_fd(fd, cli_spec(), buffer, sizeof(buffer), results);
+    }
+    progress_file_end();
+    if (err == 0 && fd != STDIN_FILENO && cache_mode != CACHE_OFF) {
+        cache_save(fd, cli_spec(), &st, results);
+    }
+    if (fd != STDIN_FILENO) {
+        close(fd);
+    }
+    
+    if (err != 0) {
+        fprintf(stderr, "%s: %s: %s\n", program_name, filename, strerror(err));
+        return 1;
+    }
+    
+    print_checksum(results, filename, quiet);
+    return 0;
+}
+
+typedef struct {
+    char **files;
+    int quiet;
+    int failed;
+} print_ctx_t;
+
+static int emit_print(size_t index, const file_slot_t *result, void *arg) {
+    print_ctx_t *ctx = arg;
+
+    if (result->error != 0) {
+        fprintf(stderr, "%s: %s: %s\n", program_name, ctx->files[index], strerror(result->error));
+        ctx->failed = 1;
+    } else {
+        print_checksum(result->results, ctx->files[index], ctx->quiet);
+    }
+    return 0;
+}
+
+/*
+ * Tree mode. A directory's digest covers its entries sorted by name, each
+ * serialized as "MODE SIZE NAME\0" (octal st_mode including the type bits;
+ * size 0 for directories) followed by the entry's own digest: the file
+ * contents, the symlink target, or the subdirectory's tree digest. Other
+ * file types contribute the digest of no input. The root's own name is not
+ * covered, so identical trees at different paths have identical digests.
+ */
+typedef struct tree_node {
+    char *path;
+    const char *name;           /* last component, within path */
+    mode_t mode;
+    uint64_t size;
+    struct tree_node *children; /* sorted by name */
+    size_t nchildren;
+    checksum_result_t results[MAX_ALGOS];
+    int error;                  /* errno for this entry, -1 if a descendant failed */
+} tree_node_t;
+
+typedef struct {
+    tree_node_t **files;        /* regular files to hash, in walk order */
+    char **paths;
+    size_t count;
+    size_t capacity;
+} tree_walk_t;
+
+static int tree_compare(const void *a, const void *b) {
+    return strcmp(((const tree_node_t *)a)->name, ((const tree_node_t *)b)->name);
+}
+
+static void tree_hash_bytes(tree_node_t *node, const void *data, size_t len) {
+    for (size_t i = 0; i < nalgos; i++) {
+        checksum_ctx_t ctx;
+
+        checksum_init(&ctx, algos[i]);
+        checksum_update(&ctx, data, len);
+        checksum_final(&ctx, &node->results[i]);
+    }
+}
+
+static int tree_add_file(tree_walk_t *walk, tree_node_t *node) {
+    if (walk->count == walk->capacity) {
+        size_t capacity = walk->capacity ? walk->capacity * 2 : 256;
+        tree_node_t **files = realloc(walk->files, capacity * sizeof(*files));
+        char **paths;
+
+        if (!files) {
+            return ENOMEM;
+        }
+        walk->files = files;
+        paths = realloc(walk->paths, capacity * sizeof(*paths));
+        if (!paths) {
+            return ENOMEM;
+        }
+        walk->paths = paths;
+        walk->capacity = capacity;
+    }
+    walk->files[walk->count] = node;
+    walk->paths[walk->count] = node->path;
+    walk->count++;
+    return 0;
+}
+
+/* Read a directory's entries into node->children, sorted by name */
+static int tree_read_dir(tree_node_t *node) {
+    size_t dirlen = strlen(node->path);
+    size_t capacity = 0;
+    struct dirent *ent;
+    DIR *dir;
+
+    dir = opendir(node->path);
+    if (!dir) {
+        return errno;
+    }
+    if (dirlen > 0 && node->path[dirlen - 1] == '/') {
+        dirlen--;
+    }
+
+    while ((errno = 0, ent = readdir(dir)) != NULL) {
+        size_t namelen = strlen(ent->d_name);
+        tree_node_t *child;
+
+        if (strcmp(ent->d_name, ".") == 0 || strcmp(ent->d_name, "..") == 0) {
+            continue;
+        }
+        if (node->nchildren == capacity) {
+            size_t grown = capacity ? capacity * 2 : 16;
+            tree_node_t *children = realloc(node->children, grown * sizeof(*children));
+
+            if (!children) {
+                closedir(dir);
+                return ENOMEM;
+            }
+            node->children = children;
+            capacity = grown;
+        }
+
+        child = &node->children[node->nchildren];
+        memset(child, 0, sizeof(*child));
+        child->path = malloc(dirlen + namelen + 2);
+        if (!child->path) {
+            closedir(dir);
+            return ENOMEM;
+        }
+        memcpy(child->path, node->path, dirlen);
+        child->path[dirlen] = '/';
+        memcpy(child->path + dirlen + 1, ent->d_name, namelen + 1);
+        child->name = child->path + dirlen + 1;
+        node->nchildren++;
+    }
+    if (errno != 0) {
+        int err = errno;
+
+        closedir(dir);
+        return err;
+    }
+    closedir(dir);
+
+    if (node->nchildren > 1) {
+        qsort(node->children, node->nchildren, sizeof(*node->children), tree_compare);
+    }
+    return 0;
+}
+
+/* Stat the tree under node; regular files are queued for hashing */
+static void tree_scan(tree_walk_t *walk, tree_node_t *node) {
+    struct stat st;
+
+    if (lstat(node->path, &st) != 0) {
+        node->error = errno;
+        return;
+    }
+    node->mode = st.st_mode;
+
+    if (S_ISREG(st.st_mode)) {
+        node->size = (uint64_t)st.st_size;
+        node->error = tree_add_file(walk, node);
+    } else if (S_ISLNK(st.st_mode)) {
+        size_t size = st.st_size > 0 ? (size_t)st.st_size + 1 : 4096;
+        char *target = malloc(size);
+        ssize_t len = target ? readlink(node->path, target, size) : -1;
+
+        if (len < 0) {
+            node->error = target ? errno : ENOMEM;
+        } else {
+            node->size = (uint64_t)len;
+            tree_hash_bytes(node, target, (size_t)len);
+        }
+        free(target);
+    } else if (S_ISDIR(st.st_mode)) {
+        node->error = tree_read_dir(node);
+        for (size_t i = 0; i < node->nchildren; i++) {
+            tree_scan(walk, &node->children[i]);
+        }
+    } else {
+        tree_hash_bytes(node, "", 0);
+    }
+}
+
+static int emit_tree(size_t index, const file_slot_t *result, void *arg) {
+    tree_walk_t *walk = arg;
+    tree_node_t *node = walk->files[index];
+
+    node->error = result->error;
+    memcpy(node->results, result->results, sizeof(node->results));
+    node->size = result->results[0].bytes_processed;
+    return 0;
+}
+
+/* Combine children into directory digests, bottom-up */
+static void tree_digest(tree_node_t *node) {
+    if (!S_ISDIR(node->mode) || node->error != 0) {
+        return;
+    }
+
+    for (size_t i = 0; i < node->nchildren; i++) {
+        tree_digest(&node->children[i]);
+        if (node->children[i].error != 0) {
+            node->error = -1;
+        }
+    }
+    if (node->error != 0) {
+        return;
+    }
+
+    for (size_t a = 0; a < nalgos; a++) {
+        checksum_ctx_t ctx;
+
+        checksum_init(&ctx, algos[a]);
+        for (size_t i = 0; i < node->nchildren; i++) {
+            const tree_node_t *child = &node->children[i];
+            char header[64];
+            int len = snprintf(header, sizeof(header), "%lo %" PRIu64 " ",
+                               (unsigned long)child->mode, S_ISDIR(child->mode) ? 0 : child->size);
+
+            checksum_update(&ctx, header, (size_t)len);
+            checksum_update(&ctx, child->name, strlen(child->name) + 1);
+            checksum_update(&ctx, child->results[a].digest, child->results[a].digest_len);
+        }
+        checksum_final(&ctx, &node->results[a]);
+    }
+}
+
+/*
+ * Print in sorted pre-order: every entry when listing subtrees, regular
+ * files only for plain -r, or just the root. Errors are always reported.
+ */
+static void tree_print(const tree_node_t *node, int root, int tree, int recursive, int quiet) {
+    if (node->error > 0) {
+        fprintf(stderr, "%s: %s: %s\n", program_name, node->path, strerror(node->error));
+    } else if (node->error == 0 &&
+               (tree ? (root || recursive) : S_ISREG(node->mode))) {
+        size_t len = strlen(node->path);
+
+        if (S_ISDIR(node->mode) && (len == 0 || node->path[len - 1] != '/')) {
+            char *name = malloc(len + 2);
+
+            if (name) {
+                memcpy(name, node->path, len);
+                memcpy(name + len, "/", 2);
+                print_checksum(node->results, name, quiet);
+                free(name);
+            }
+        } else {
+            print_checksum(node->results, node->path, quiet);
+        }
+    }
+
+    if (recursive || !tree) {
+        for (size_t i = 0; i < node->nchildren; i++) {
+            tree_print(&node->children[i], 0, tree, recursive, quiet);
+        }
+    }
+}
+
+/* Report every entry of a walk that could not be read; nonzero if any */
+static int tree_report_errors(const tree_node_t *node) {
+    int failed = 0;
+
+    if (node->error > 0) {
+        fprintf(stderr, "%s: %s: %s\n", program_name, node->path, strerror(node->error));
+        failed = 1;
+    }
+    for (size_t i = 0; i < node->nchildren; i++) {
+        failed |= tree_report_errors(&node->children[i]);
+    }
+    return failed;
+}
+
+static void tree_free(tree_node_t *node, int root) {
+    for (size_t i = 0; i < node->nchildren; i++) {
+        tree_free(&node->children[i], 0);
+    }
+    free(node->children);
+    if (!root) {
+        free(node->path);
+    }
+}
+
+/*
+ * -r and --tree: walk each argument, hash every regular file on the file
+ * pool (through the xattr cache when enabled, so unchanged trees are cheap
+ * to re-digest), then fold directory digests bottom-up.
+ */
+static int checksum_trees(char **roots, size_t count, int tree, int recursive, int quiet) {
+    static char *dot[] = {"."};
+    int exit_code = 0;
+
+    if (count == 0) {
+        roots = dot;
+        count = 1;
+    }
+
+    for (size_t r = 0; r < count; r++) {
+        tree_walk_t walk = {0};
+        tree_node_t root = {0};
+
+        root.path = roots[r];
+        root.name = roots[r];
+        tree_scan(&walk, &root);
+        if (progress.track) {
+            for (size_t i = 0; i < walk.count; i++) {
+                progress_expect(walk.files[i]->size, 1);
+            }
+        }
+
+        if (jobs < 2 || walk.count < 2 ||
+            run_file_pool(walk.paths, walk.count, cli_spec(), jobs, (size_t)jobs,
+                          emit_tree, &walk) < 0) {
+            static unsigned char buffer[READ_BUF_SIZE];
+
+            for (size_t i = 0; i < walk.count; i++) {
+                file_slot_t slot = {.done = 1};
+
+                slot.error = hash_path(walk.paths[i], cli_spec(), buffer, sizeof(buffer),
+                                       slot.results);
+                emit_tree(i, &slot, &walk);
+            }
+        }
+
+        tree_digest(&root);
+        tree_print(&root, 1, tree, recursive, quiet);
+        if (root.error != 0) {
+            exit_code = 1;
+        }
+
+        tree_free(&root, 1);
+        free(walk.files);
+        free(walk.paths);
+    }
+    return exit_code;
+}
+
+/*
+ * Block maps. --blocks=SIZE lists one digest per SIZE-byte block of each
+ * file, so a damaged copy can be narrowed down to the blocks that differ:
+ *
+ *   #blocks ALGO BLOCK_SIZE FILE_SIZE  NAME
+ *   HEX                                    (block 0)
+ *   HEX                                    (block 1, ...)
+ *
+ * The last block may be short. Blocks are hashed with pread on up to
+ * `jobs` threads, each taking a contiguous run of blocks.
+ */
+typedef struct {
+    checksum_type_t type;
+    uint64_t block_size;
+    uint64_t size;
+    size_t count;
+    size_t digest_len;
+    unsigned char *digests;     /* count * digest_len bytes */
+} block_map_t;
+
+typedef struct {
+    int fd;
+    block_map_t *map;
+    size_t first;               /* blocks [first, last) */
+    size_t last;
+    progress_slot_t *progress;  /* the spawning thread's, for --progress */
+    int error;
+    int running;                /* owned by the spawning thread */
+} block_job_t;
+
+static void *block_worker(void *arg) {
+    block_job_t *job = arg;
+    block_map_t *map = job->map;
+    size_t bufsize = map->block_size < PARALLEL_BUF_SIZE ? (size_t)map->block_size
+                                                         : PARALLEL_BUF_SIZE;
+    unsigned char *buf = malloc(bufsize);
+
+    if (!buf) {
+        job->error = ENOMEM;
+        return NULL;
+    }
+
+    progress_slot = job->progress;
+    for (size_t b = job->first; b < job->last && job->error == 0; b++) {
+        uint64_t pos = b * map->block_size;
+        uint64_t end = pos + map->block_size < map->size ? pos + map->block_size : map->size;
+        checksum_result_t result;
+        checksum_ctx_t ctx;
+
+        checksum_init(&ctx, map->type);
+        while (pos < end) {
+            size_t want = end - pos < bufsize ? (size_t)(end - pos) : bufsize;
+            ssize_t got = pread(job->fd, buf, want, (off_t)pos);
+
+            if (got < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                job->error = errno;
+                break;
+            }
+            if (got == 0) {
+                /* File shrank underneath us */
+                job->error = EIO;
+                break;
+            }
+            checksum_update(&ctx, buf, (size_t)got);
+            progress_add((uint64_t)got);
+            pos += (uint64_t)got;
+        }
+        checksum_final(&ctx, &result);
+        memcpy(map->digests + b * map->digest_len, result.digest, map->digest_len);
+    }
+
+    free(buf);
+    return NULL;
+}
+
+/* Fill map (type and block_size already set) from a regular file */
+static int block_map_fd(int fd, block_map_t *map) {
+    block_job_t *work;
+    pthread_t *threads;
+    struct stat st;
+    uint64_t count;
+    long nworkers;
+    size_t per_worker;
+    int err = 0;
+
+    if (fstat(fd, &st) != 0) {
+        return errno;
+    }
+    if (!S_ISREG(st.st_mode)) {
+        return ESPIPE;
+    }
+
+    map->size = (uint64_t)st.st_size;
+    count = map->size / map->block_size + (map->size % map->block_size != 0);
+    map->digest_len = checksum_digest_size(map->type);
+    if (count > SIZE_MAX / map->digest_len) {
+        return ENOMEM;
+    }
+    map->count = (size_t)count;
+    map->digests = malloc(map->count ? map->count * map->digest_len : 1);
+    if (!map->digests) {
+        return ENOMEM;
+    }
+
+    nworkers = (long)(map->size / PARALLEL_MIN_CHUNK);
+    if (nworkers > jobs) {
+        nworkers = jobs;
+    }
+    if ((size_t)nworkers > map->count) {
+        nworkers = (long)map->count;
+    }
+    if (nworkers < 1) {
+        nworkers = 1;
+    }
+    per_worker = (map->count + (size_t)nworkers - 1) / (size_t)nworkers;
+
+    work = calloc((size_t)nworkers, sizeof(*work));
+    threads = calloc((size_t)nworkers, sizeof(*threads));
+    if (!work || !threads) {
+        free(work);
+        free(threads);
+        return ENOMEM;
+    }
+
+    posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+    for (long i = 0; i < nworkers; i++) {
+        work[i].fd = fd;
+        work[i].map = map;
+        work[i].first = (size_t)i * per_worker < map->count ? (size_t)i * per_worker : map->count;
+        work[i].last = work[i].first + per_worker < map->count ? work[i].first + per_worker
+                                                               : map->count;
+        work[i].progress = progress_slot;
+
+        if (nworkers > 1 && pthread_create(&threads[i], NULL, block_worker, &work[i]) == 0) {
+            work[i].running = 1;
+        } else {
+            block_worker(&work[i]);
+        }
+    }
+
+    for (long i = 0; i < nworkers; i++) {
+        if (work[i].running) {
+            pthread_join(threads[i], NULL);
+        }
+        if (err == 0) {
+            err = work[i].error;
+        }
+    }
+
+    free(work);
+    free(threads);
+    return err;
+}
+
+static int checksum_block_maps(char **files, size_t count, uint64_t block_size) {
+    int exit_code = 0;
+
+    if (nalgos != 1) {
+        fprintf(stderr, "%s: --blocks takes a single algorithm\n", program_name);
+        return 1;
+    }
+
+    for (size_t i = 0; i < count; i++) {
+        block_map_t map = {algos[0], block_size, 0, 0, 0, NULL};
+        char header[96];
+        int fd = open(files[i], O_RDONLY);
+        int err;
+
+        if (fd == -1) {
+            err = errno;
+        } else {
+            progress_file_begin(files[i], fd);
+            err = block_map_fd(fd, &map);
+            progress_file_end();
+            close(fd);
+        }
+        if (err != 0) {
+            fprintf(stderr, "%s: %s: %s\n", program_name, files[i],
+                    err == ESPIPE ? "not a regular file" : strerror(err));
+            exit_code = 1;
+            free(map.digests);
+            continue;
+        }
+
+        snprintf(header, sizeof(header), "#blocks %s %" PRIu64 " %" PRIu64 "  ",
+                 checksum_name(map.type), map.block_size, map.size);
+        out_str(&out, header);
+        put_name(&out, files[i]);
+        out_end_line(&out);
+        for (size_t b = 0; b < map.count; b++) {
+            out_hex(&map.digests[b * map.digest_len], map.digest_len);
+            out_end_line(&out);
+        }
+        free(map.digests);
+    }
+    return exit_code;
+}
+
+/*
+ * Load a block map written by --blocks. Returns 0, an errno value, or -1
+ * if the data is not a block map. Only the first map in the file is used.
+ */
+static int block_map_parse(char *data, size_t size, block_map_t *map) {
+    char algo[32];
+    char *line, *end = data + size;
+    uint64_t block_size, file_size, count;
+
+    if (size < 8 || memcmp(data, "#blocks ", 8) != 0) {
+        return -1;
+    }
+    line = memchr(data, '\n', size);
+    if (!line) {
+        return -1;
+    }
+    *line++ = '\0';
+    if (sscanf(data, "#blocks %31s %" SCNu64 " %" SCNu64, algo, &block_size, &file_size) != 3 ||
+        checksum_type_from_name(algo, &map->type) != CHECKSUM_SUCCESS || block_size == 0) {
+        return -1;
+    }
+
+    /* The header is untrusted: every digest line it promises must be present */
+    count = file_size / block_size + (file_size % block_size != 0);
+    map->digest_len = checksum_digest_size(map->type);
+    if (count > (uint64_t)(end - line) / (2 * map->digest_len + 1)) {
+        return -1;
+    }
+    map->block_size = block_size;
+    map->size = file_size;
+    map->count = (size_t)count;
+    map->digests = malloc(map->count ? map->count * map->digest_len : 1);
+    if (!map->digests) {
+        return ENOMEM;
+    }
+
+    for (size_t b = 0; b < map->count; b++) {
+        size_t hexlen = 2 * map->digest_len;
+
+        if ((size_t)(end - line) < hexlen + 1 || line[hexlen] != '\n' ||
+            parse_hex(line, map->digests + b * map->digest_len, map->digest_len) != 0) {
+            free(map->digests);
+            map->digests = NULL;
+            return -1;
+        }
+        line += hexlen + 1;
+    }
+    return 0;
+}
+
+/* Read a block map, or map a data file the way `reference` was made */
+static int block_map_load(const char *path, const block_map_t *reference, block_map_t *map) {
+    char head[8];
+    ssize_t got;
+    int fd, err;
+
+    fd = open(path, O_RDONLY);
+    if (fd == -1) {
+        return errno;
+    }
+
+    got = pread(fd, head, sizeof(head), 0);
+    if (got == (ssize_t)sizeof(head) && memcmp(head, "#blocks ", sizeof(head)) == 0) {
+        size_t size;
+        char *data = slurp_fd(fd, &size);
+
+        err = data ? block_map_parse(data, size, map) : errno;
+        free(data);
+    } else if (reference) {
+        map->type = reference->type;
+        map->block_size = reference->block_size;
+        progress_file_begin(path, fd);
+        err = block_map_fd(fd, map);
+        progress_file_end();
+    } else {
+        err = -1;
+    }
+
+    close(fd);
+    return err;
+}
+
+static void report_range(const char *name, const block_map_t *a, uint64_t size,
+                         size_t first, size_t last) {
+    uint64_t start = first * a->block_size;
+    uint64_t end = last * a->block_size < size ? last * a->block_size : size;
+
+    put_status_name(name);
+    out_printf("bytes %" PRIu64 "-%" PRIu64 " differ (", start, end - 1);
+    if (last - first == 1) {
+        out_printf("block %zu)", first);
+    } else {
+        out_printf("blocks %zu-%zu)", first, last - 1);
+    }
+    out_end_line(&out);
+}
+
+/*
+ * --compare=MAP TARGET...: each TARGET is another block map or a file to
+ * map the same way. Differing blocks are merged into byte ranges.
+ */
+static int checksum_compare_blocks(const char *reference, char **targets, size_t count,
+                                   int quiet) {
+    block_map_t ref = {0};
+    int exit_code = 0;
+    int err;
+
+    err = block_map_load(reference, NULL, &ref);
+    if (err != 0) {
+        fprintf(stderr, "%s: %s: %s\n", program_name, reference,
+                err < 0 ? "not a block map" : strerror(err));
+        return 1;
+    }
+
+    for (size_t t = 0; t < count; t++) {
+        block_map_t map = {0};
+        uint64_t size;
+        size_t blocks, run_start = 0, ranges = 0;
+        int in_run = 0;
+
+        err = block_map_load(targets[t], &ref, &map);
+        if (err != 0) {
+            fprintf(stderr, "%s: %s: %s\n", program_name, targets[t],
+                    err == ESPIPE ? "not a regular file" : strerror(err));
+            exit_code = 1;
+            continue;
+        }
+        if (map.type != ref.type || map.block_size != ref.block_size) {
+            fprintf(stderr, "%s: %s: block map uses a different algorithm or block size\n",
+                    program_name, targets[t]);
+            free(map.digests);
+            exit_code = 1;
+            continue;
+        }
+
+        size = map.size > ref.size ? map.size : ref.size;
+        blocks = map.count > ref.count ? map.count : ref.count;
+        for (size_t b = 0; b <= blocks; b++) {
+            int differs = b < blocks &&
+                          (b >= map.count || b >= ref.count ||
+                           memcmp(map.digests + b * map.digest_len,
+                                  ref.digests + b * ref.digest_len, ref.digest_len) != 0);
+
+            if (differs && !in_run) {
+                run_start = b;
+                in_run = 1;
+            } else if (!differs && in_run) {
+                report_range(targets[t], &ref, size, run_start, b);
+                ranges++;
+                in_run = 0;
+            }
+        }
+
+        if (map.size != ref.size) {
+            put_status_name(targets[t]);
+            out_printf("size %" PRIu64 ", expected %" PRIu64, map.size, ref.size);
+            out_end_line(&out);
+        }
+        if (ranges > 0 || map.size != ref.size) {
+            exit_code = 1;
+        } else if (!quiet) {
+            put_status_name(targets[t]);
+            out_str(&out, "OK");
+            out_end_line(&out);
+        }
+        free(map.digests);
+    }
+
+    free(ref.digests);
+    return exit_code;
+}
+
+/* A whole input file: mapped when regular and non-empty, otherwise read */
+typedef struct {
+    unsigned char *data;
+    size_t size;
+    int mapped;
+} whole_file_t;
+
+static int whole_file_load(const char *path, whole_file_t *file) {
+    struct stat st;
+    int fd = STDIN_FILENO;
+    int err = 0;
+
+    if (strcmp(path, "-") != 0) {
+        fd = open(path, O_RDONLY);
+        if (fd == -1) {
+            return errno;
+        }
+    }
+
+    file->mapped = 0;
+    file->data = NULL;
+    if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0) {
+        file->size = (size_t)st.st_size;
+        file->data = mmap(NULL, file->size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (file->data == MAP_FAILED) {
+            file->data = NULL;
+        } else {
+            file->mapped = 1;
+        }
+    }
+    if (!file->data) {
+        file->data = (unsigned char *)slurp_fd(fd, &file->size);
+        if (!file->data) {
+            err = errno;
+        }
+    }
+
+    if (fd != STDIN_FILENO) {
+        close(fd);
+    }
+    return err;
+}
+
+static void whole_file_release(whole_file_t *file) {
+    if (file->mapped) {
+        munmap(file->data, file->size);
+    } else {
+        free(file->data);
+    }
+}
+
+static int write_stdout(void *ctx, const void *data, size_t len) {
+    (void)ctx;
+    return fwrite(data, 1, len, stdout) == len ? 0 : -1;
+}
+
+enum { DELTA_SIGNATURE = 1, DELTA_ENCODE, DELTA_PATCH };
+
+/*
+ * rsync-style delta transfer, each writing binary output to stdout:
+ *   --signature=BASE        signature of BASE
+ *   --delta=SIG NEW         delta turning the signature's base into NEW
+ *   --patch=DELTA BASE      NEW rebuilt from BASE and the delta
+ */
+static int checksum_delta_mode(int mode, const char *arg, char **files, size_t count,
+                               uint64_t block_size) {
+    whole_file_t first = {0}, second = {0};
+    checksum_signature_t sig;
+    const char *name = mode == DELTA_SIGNATURE ? "--signature" :
+                       mode == DELTA_ENCODE ? "--delta" : "--patch";
+    const char *failed = arg;
+    int err;
+
+    if (count != (mode == DELTA_SIGNATURE ? 0u : 1u)) {
+        fprintf(stderr, "%s: %s %s\n", program_name, name,
+                mode == DELTA_SIGNATURE ? "takes no FILE operands" : "requires exactly one FILE");
+        return 1;
+    }
+    if (block_size > UINT32_MAX) {
+        fprintf(stderr, "%s: block size too large for a signature\n", program_name);
+        return 1;
+    }
+    if (isatty(STDOUT_FILENO)) {
+        fprintf(stderr, "%s: %s writes binary data; redirect standard output\n",
+                program_name, name);
+        return 1;
+    }
+
+    err = whole_file_load(arg, &first);
+    if (err != 0) {
+        fprintf(stderr, "%s: %s: %s\n", program_name, arg, strerror(err));
+        return 1;
+    }
+    if (count > 0) {
+        err = whole_file_load(files[0], &second);
+        if (err != 0) {
+            fprintf(stderr, "%s: %s: %s\n", program_name, files[0], strerror(err));
+            whole_file_release(&first);
+            return 1;
+        }
+    }
+
+    switch (mode) {
+        case DELTA_SIGNATURE:
+            err = checksum_signature_build(&sig, first.data, first.size, (uint32_t)block_size);
+            if (err == CHECKSUM_SUCCESS) {
+                err = checksum_signature_write(&sig, write_stdout, NULL);
+                checksum_signature_free(&sig);
+            }
+            break;
+        case DELTA_ENCODE:
+            err = checksum_signature_load(&sig, first.data, first.size);
+            if (err == CHECKSUM_SUCCESS) {
+                failed = files[0];
+                err = checksum_delta(&sig, second.data, second.size, write_stdout, NULL);
+                checksum_signature_free(&sig);
+            }
+            break;
+        default:
+            err = checksum_patch(second.data, second.size, first.data, first.size,
+                                 write_stdout, NULL);
+            if (err == CHECKSUM_ERROR_DATA) {
+                fprintf(stderr, "%s: %s: delta does not apply to %s; discard the output\n",
+                        program_name, arg, files[0]);
+                failed = NULL;
+            }
+            break;
+    }
+
+    whole_file_release(&first);
+    if (count > 0) {
+        whole_file_release(&second);
+    }
+    if (fflush(stdout) != 0 && err == CHECKSUM_SUCCESS) {
+        err = CHECKSUM_ERROR_IO;
+    }
+    if (err == CHECKSUM_ERROR_IO) {
+        fprintf(stderr, "%s: standard output: %s\n", program_name, strerror(errno));
+    } else if (err != CHECKSUM_SUCCESS && failed) {
+        fprintf(stderr, "%s: %s: %s\n", program_name, failed, checksum_strerror(err));
+    }
+    return err == CHECKSUM_SUCCESS ? 0 : 1;
+}
+
+/*
+ * --cdc: dedup analysis. Each file is cut into content-defined chunks,
+ * every chunk is hashed, and a table of chunk hashes counts how many bytes
+ * are unique across all files. Workers chunk and hash whole files, then
+ * add their hashes to the shared table under the pool lock.
+ */
+typedef struct {
+    uint64_t lo;
+    uint64_t hi;
+} cdc_key_t;
+
+typedef struct {
+    cdc_key_t key;
+    uint64_t length;
+} cdc_chunk_t;
+
+/* Open addressing; an all-zero key marks an empty slot */
+typedef struct {
+    cdc_key_t *slots;
+    size_t mask;
+    size_t used;
+} cdc_table_t;
+
+typedef struct {
+    char **files;
+    size_t count;
+    size_t next;
+    checksum_type_t type;
+    const checksum_cdc_t *cdc;
+    cdc_table_t table;
+    uint64_t files_done;
+    uint64_t chunks;
+    uint64_t bytes;
+    uint64_t unique_chunks;
+    uint64_t unique_bytes;
+    int failed;
+    pthread_mutex_t lock;
+} cdc_pool_t;
+
+static uint64_t load_u64(const unsigned char *p) {
+    uint64_t v;
+
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+static int cdc_table_grow(cdc_table_t *table) {
+    size_t capacity = table->slots ? (table->mask + 1) * 2 : 4096;
+    cdc_key_t *slots = calloc(capacity, sizeof(*slots));
+
+    if (!slots) {
+        return ENOMEM;
+    }
+    for (size_t i = 0; table->slots && i <= table->mask; i++) {
+        cdc_key_t key = table->slots[i];
+
+        if (key.lo | key.hi) {
+            size_t s = (size_t)key.lo & (capacity - 1);
+
+            while (slots[s].lo | slots[s].hi) {
+                s = (s + 1) & (capacity - 1);
+            }
+            slots[s] = key;
+        }
+    }
+    free(table->slots);
+    table->slots = slots;
+    table->mask = capacity - 1;
+    return 0;
+}
+
+/* Returns 1 if the key was new, 0 if already present, or -1 without memory */
+static int cdc_table_insert(cdc_table_t *table, cdc_key_t key) {
+    size_t s;
+
+    if ((!table->slots || table->used >= (table->mask + 1) / 2) && cdc_table_grow(table) != 0) {
+        return -1;
+    }
+    for (s = (size_t)key.lo & table->mask; table->slots[s].lo | table->slots[s].hi;
+         s = (s + 1) & table->mask) {
+        if (table->slots[s].lo == key.lo && table->slots[s].hi == key.hi) {
+            return 0;
+        }
+    }
+    table->slots[s] = key;
+    table->used++;
+    return 1;
+}
+
+/* Chunk and hash one file into a malloc'd list */
+static int cdc_file(const cdc_pool_t *pool, const char *path, cdc_chunk_t **chunks,
+                    size_t *count) {
+    whole_file_t file;
+    size_t capacity = 0, pos = 0;
+    int err;
+
+    *chunks = NULL;
+    *count = 0;
+    err = whole_file_load(path, &file);
+    if (err != 0) {
+        return err;
+    }
+    if (file.mapped) {
+        posix_madvise(file.data, file.size, POSIX_MADV_SEQUENTIAL);
+    }
+
+    while (pos < file.size) {
+        size_t len = checksum_cdc_next(pool->cdc, file.data + pos, file.size - pos);
+        cdc_chunk_t *chunk;
+        checksum_ctx_t ctx;
+        checksum_result_t result;
+
+        if (*count == capacity) {
+            cdc_chunk_t *grown;
+
+            capacity = capacity ? capacity * 2 : 1024;
+            grown = realloc(*chunks, capacity * sizeof(**chunks));
+            if (!grown) {
+                err = ENOMEM;
+                break;
+            }
+            *chunks = grown;
+        }
+
+        checksum_init(&ctx, pool->type);
+        checksum_update(&ctx, file.data + pos, len);
+        checksum_final(&ctx, &result);
+        progress_add(len);
+
+        chunk = &(*chunks)[(*count)++];
+        chunk->length = len;
+        chunk->key.lo = load_u64(result.digest);
+        chunk->key.hi = result.digest_len >= 16 ? load_u64(result.digest + 8) : 0;
+        if (!(chunk->key.lo | chunk->key.hi)) {
+            chunk->key.lo = 1;      /* keep the empty-slot marker free */
+        }
+        pos += len;
+    }
+
+    whole_file_release(&file);
+    progress_file_end();
+    if (err != 0) {
+        free(*chunks);
+        *chunks = NULL;
+        *count = 0;
+    }
+    return err;
+}
+
+static void *cdc_worker(void *arg) {
+    cdc_pool_t *pool = arg;
+
+    for (;;) {
+        cdc_chunk_t *chunks;
+        size_t i, count;
+        int err;
+
+        pthread_mutex_lock(&pool->lock);
+        if (pool->next >= pool->count) {
+            pthread_mutex_unlock(&pool->lock);
+            break;
+        }
+        i = pool->next++;
+        pthread_mutex_unlock(&pool->lock);
+
+        err = cdc_file(pool, pool->files[i], &chunks, &count);
+
+        pthread_mutex_lock(&pool->lock);
+        for (size_t c = 0; c < count && err == 0; c++) {
+            int added = cdc_table_insert(&pool->table, chunks[c].key);
+
+            if (added < 0) {
+                err = ENOMEM;
+                break;
+            }
+            pool->chunks++;
+            pool->bytes += chunks[c].length;
+            if (added) {
+                pool->unique_chunks++;
+                pool->unique_bytes += chunks[c].length;
+            }
+        }
+        if (err != 0) {
+            fprintf(stderr, "%s: %s: %s\n", program_name, pool->files[i], strerror(err));
+            pool->failed = 1;
+        } else {
+            pool->files_done++;
+        }
+        pthread_mutex_unlock(&pool->lock);
+        free(chunks);
+    }
+    return NULL;
+}
+
+/* Expand directory operands for -r into their regular files, in walk order */
+static char **cdc_collect(char **operands, size_t count, int recursive, size_t *nfiles,
+                          int *failed) {
+    char **files = NULL;
+    size_t n = 0;
+
+    if (!recursive) {
+        *nfiles = count;
+        return operands;
+    }
+
+    for (size_t r = 0; r < count; r++) {
+        tree_walk_t walk = {0};
+        tree_node_t root = {0};
+        char **grown;
+
+        root.path = operands[r];
+        root.name = operands[r];
+        tree_scan(&walk, &root);
+        if (tree_report_errors(&root)) {
+            *failed = 1;
+        }
+
+        grown = realloc(files, (n + walk.count + 1) * sizeof(*files));
+        if (grown) {
+            files = grown;
+            for (size_t i = 0; i < walk.count; i++) {
+                files[n] = strdup(walk.paths[i]);
+                if (files[n]) {
+                    n++;
+                } else {
+                    fprintf(stderr, "%s: %s: %s\n", program_name, walk.paths[i],
+                            strerror(ENOMEM));
+                    *failed = 1;
+                }
+            }
+        } else {
+            fprintf(stderr, "%s: %s: %s\n", program_name, operands[r], strerror(ENOMEM));
+            *failed = 1;
+        }
+        tree_free(&root, 1);
+        free(walk.files);
+        free(walk.paths);
+    }
+
+    *nfiles = n;
+    return files;
+}
+
+static int checksum_cdc_analyze(char **operands, size_t count, int recursive,
+                                const checksum_cdc_t *cdc) {
+    static char *dot[] = {"."};
+    static char *stdin_name[] = {"-"};
+    cdc_pool_t pool;
+    pthread_t *threads;
+    long nworkers, started = 0;
+
+    if (count == 0) {
+        operands = recursive ? dot : stdin_name;
+        count = 1;
+    }
+
+    memset(&pool, 0, sizeof(pool));
+    pool.type = algos[0];
+    pool.cdc = cdc;
+    pool.files = cdc_collect(operands, count, recursive, &pool.count, &pool.failed);
+    pthread_mutex_init(&pool.lock, NULL);
+
+    nworkers = jobs < (long)pool.count ? jobs : (long)pool.count;
+    threads = calloc(nworkers > 0 ? (size_t)nworkers : 1, sizeof(*threads));
+    for (long i = 0; threads && nworkers > 1 && i < nworkers; i++) {
+        if (pthread_create(&threads[started], NULL, cdc_worker, &pool) == 0) {
+            started++;
+        }
+    }
+    if (started == 0) {
+        cdc_worker(&pool);
+    }
+    for (long i = 0; i < started; i++) {
+        pthread_join(threads[i], NULL);
+    }
+
+    out_printf("algorithm:     %s", checksum_name(pool.type));
+    out_end_line(&out);
+    out_printf("chunk sizes:   %" PRIu32 " min, %" PRIu32 " avg, %" PRIu32 " max",
+               cdc->min_size, cdc->avg_size, cdc->max_size);
+    out_end_line(&out);
+    out_printf("files:         %" PRIu64, pool.files_done);
+    out_end_line(&out);
+    out_printf("chunks:        %" PRIu64 " (%" PRIu64 " unique)", pool.chunks,
+               pool.unique_chunks);
+    out_end_line(&out);
+    if (pool.chunks > 0) {
+        out_printf("average chunk: %" PRIu64 " bytes", pool.bytes / pool.chunks);
+        out_end_line(&out);
+    }
+    out_printf("total bytes:   %" PRIu64, pool.bytes);
+    out_end_line(&out);
+    out_printf("unique bytes:  %" PRIu64 " (%.2f%%)", pool.unique_bytes,
+               pool.bytes ? 100.0 * (double)pool.unique_bytes / (double)pool.bytes : 100.0);
+    out_end_line(&out);
+    out_printf("dedup ratio:   %.3f",
+               pool.unique_bytes ? (double)pool.bytes / (double)pool.unique_bytes : 1.0);
+    out_end_line(&out);
+
+    if (pool.files != operands) {
+        for (size_t i = 0; i < pool.count; i++) {
+            free(pool.files[i]);
+        }
+        free(pool.files);
+    }
+    pthread_mutex_destroy(&pool.lock);
+    free(pool.table.slots);
+    free(threads);
+    return pool.failed;
+}
+
+/* Parse a byte count with an optional K, M or G (binary) suffix */
+static int parse_size(const char *arg, uint64_t *size) {
+    char *end;
+    unsigned long long value;
+    int shift = 0;
+
+    errno = 0;
+    value = strtoull(arg, &end, 10);
+    if (errno != 0 || end == arg || arg[0] == '-') {
+        return -1;
+    }
+    switch (*end) {
+        case 'k': case 'K': shift = 10; end++; break;
+        case 'm': case 'M': shift = 20; end++; break;
+        case 'g': case 'G': shift = 30; end++; break;
+    }
+    if (*end != '\0' || value == 0 || value > (UINT64_MAX >> shift)) {
+        return -1;
+    }
+    *size = (uint64_t)value << shift;
+    return 0;
+}
+
+/*
+ * --find-dups: duplicate files under the given directories. Each stage only
+ * reads files that are still candidates after the previous one:
+ *   1. group by size (from the directory walk, no reads)
+ *   2. hash the first and last DUP_SAMPLE bytes of files sharing a size
+ *   3. fully hash files that still agree, on the file pool (and xattr cache)
+ * Hard links to one inode count as a single file.
+ */
+#define DUP_SAMPLE  4096
+
+typedef struct {
+    char *path;
+    uint64_t size;
+    size_t index;               /* walk order, for stable output */
+    dev_t dev;
+    ino_t ino;
+    struct timespec mtime;      /* when sampled, to detect later changes */
+    struct timespec ctime;
+    unsigned char sample[16];   /* XXH3-128 of the head and tail samples */
+    checksum_result_t results[MAX_ALGOS];
+    int error;
+} dup_file_t;
+
+typedef struct {
+    dup_file_t **files;
+    size_t count;
+    size_t next;
+    pthread_mutex_t lock;
+} dup_stage_t;
+
+static int dup_by_size(const void *a, const void *b) {
+    const dup_file_t *x = *(dup_file_t *const *)a, *y = *(dup_file_t *const *)b;
+
+    if (x->size != y->size) {
+        return x->size < y->size ? 1 : -1;      /* largest first */
+    }
+    return x->index < y->index ? -1 : x->index > y->index;
+}
+
+static int dup_by_inode(const void *a, const void *b) {
+    const dup_file_t *x = *(dup_file_t *const *)a, *y = *(dup_file_t *const *)b;
+
+    if (x->size != y->size) {
+        return x->size < y->size ? 1 : -1;
+    }
+    if (x->dev != y->dev) {
+        return x->dev < y->dev ? -1 : 1;
+    }
+    if (x->ino != y->ino) {
+        return x->ino < y->ino ? -1 : 1;
+    }
+    return x->index < y->index ? -1 : x->index > y->index;
+}
+
+static int dup_by_sample(const void *a, const void *b) {
+    const dup_file_t *x = *(dup_file_t *const *)a, *y = *(dup_file_t *const *)b;
+    int c;
+
+    if (x->size != y->size) {
+        return x->size < y->size ? 1 : -1;
+    }
+    c = memcmp(x->sample, y->sample, sizeof(x->sample));
+    if (c != 0) {
+        return c;
+    }
+    return x->index < y->index ? -1 : x->index > y->index;
+}
+
+static int dup_same_digest(const dup_file_t *x, const dup_file_t *y) {
+    for (size_t i = 0; i < nalgos; i++) {
+        if (memcmp(x->results[i].digest, y->results[i].digest, x->results[i].digest_len) != 0) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+static int dup_by_digest(const void *a, const void *b) {
+    const dup_file_t *x = *(dup_file_t *const *)a, *y = *(dup_file_t *const *)b;
+
+    if (x->size != y->size) {
+        return x->size < y->size ? 1 : -1;
+    }
+    for (size_t i = 0; i < nalgos; i++) {
+        int c = memcmp(x->results[i].digest, y->results[i].digest, x->results[i].digest_len);
+
+        if (c != 0) {
+            return c;
+        }
+    }
+    return x->index < y->index ? -1 : x->index > y->index;
+}
+
+/* Stage 2 for one file: identify the inode and hash its head and tail */
+static void dup_sample(dup_file_t *file) {
+    unsigned char buf[2 * DUP_SAMPLE];
+    size_t head, tail = 0;
+    checksum_result_t result;
+    struct stat st;
+    int fd;
+
+    fd = open(file->path, O_RDONLY);
+    if (fd == -1) {
+        file->error = errno;
+        return;
+    }
+    if (fstat(fd, &st) != 0) {
+        file->error = errno;
+        close(fd);
+        return;
+    }
+    if ((uint64_t)st.st_size != file->size) {
+        file->error = EAGAIN;   /* changed since the scan */
+        close(fd);
+        return;
+    }
+    file->dev = st.st_dev;
+    file->ino = st.st_ino;
+    file->mtime = st.st_mtim;
+    file->ctime = st.st_ctim;
+
+    head = file->size < DUP_SAMPLE ? (size_t)file->size : DUP_SAMPLE;
+    if (file->size > DUP_SAMPLE) {
+        tail = file->size - DUP_SAMPLE < DUP_SAMPLE ? (size_t)(file->size - DUP_SAMPLE)
+                                                    : DUP_SAMPLE;
+    }
+    errno = EIO;    /* a short read means the file shrank */
+    if (pread(fd, buf, head, 0) != (ssize_t)head ||
+        (tail > 0 && pread(fd, buf + head, tail, (off_t)(file->size - tail)) != (ssize_t)tail)) {
+        file->error = errno;
+    } else {
+        checksum_buffers(CHECKSUM_XXH3_128, &(struct iovec){buf, head + tail}, 1, &result);
+        memcpy(file->sample, result.digest, sizeof(file->sample));
+        progress_add(head + tail);
+    }
+    close(fd);
+}
+
+static void *dup_sample_worker(void *arg) {
+    dup_stage_t *stage = arg;
+
+    for (;;) {
+        size_t i;
+
+        pthread_mutex_lock(&stage->lock);
+        i = stage->next++;
+        pthread_mutex_unlock(&stage->lock);
+        if (i >= stage->count) {
+            break;
+        }
+        dup_sample(stage->files[i]);
+    }
+    return NULL;
+}
+
+static void dup_sample_all(dup_file_t **files, size_t count) {
+    dup_stage_t stage = {files, count, 0, PTHREAD_MUTEX_INITIALIZER};
+    pthread_t threads[MAX_JOBS];
+    long nworkers = jobs < (long)count ? jobs : (long)count;
+    long started = 0;
+
+    for (long i = 0; nworkers > 1 && i < nworkers; i++) {
+        if (pthread_create(&threads[started], NULL, dup_sample_worker, &stage) == 0) {
+            started++;
+        }
+    }
+    if (started == 0) {
+        dup_sample_worker(&stage);
+    }
+    for (long i = 0; i < started; i++) {
+        pthread_join(threads[i], NULL);
+    }
+    pthread_mutex_destroy(&stage.lock);
+}
+
+/* Keep only runs of two or more adjacent files that are the same() */
+static size_t dup_keep_runs(dup_file_t **files, size_t count,
+                            int (*same)(const dup_file_t *, const dup_file_t *)) {
+    size_t kept = 0;
+
+    for (size_t start = 0, end; start < count; start = end) {
+        for (end = start + 1; end < count && same(files[start], files[end]); end++) {
+        }
+        if (end - start >= 2) {
+            memmove(files + kept, files + start, (end - start) * sizeof(*files));
+            kept += end - start;
+        }
+    }
+    return kept;
+}
+
+static int dup_same_size(const dup_file_t *x, const dup_file_t *y) {
+    return x->size == y->size;
+}
+
+static int dup_same_sample(const dup_file_t *x, const dup_file_t *y) {
+    return x->size == y->size && memcmp(x->sample, y->sample, sizeof(x->sample)) == 0;
+}
+
+static int dup_same_content(const dup_file_t *x, const dup_file_t *y) {
+    return x->size == y->size && dup_same_digest(x, y);
+}
+
+/* Drop failed files, and all but the first path of each inode */
+static size_t dup_drop(dup_file_t **files, size_t count, int *failed) {
+    size_t kept = 0;
+
+    for (size_t i = 0; i < count; i++) {
+        dup_file_t *f = files[i];
+
+        if (f->error != 0) {
+            fprintf(stderr, "%s: %s: %s\n", program_name, f->path,
+                    f->error == EAGAIN ? "changed during the scan" : strerror(f->error));
+            *failed = 1;
+        } else if (kept == 0 || files[kept - 1]->size != f->size ||
+                   files[kept - 1]->dev != f->dev || files[kept - 1]->ino != f->ino) {
+            files[kept++] = f;
+        }
+    }
+    return kept;
+}
+
+static int emit_dup(size_t index, const file_slot_t *result, void *arg) {
+    dup_file_t **files = arg;
+
+    files[index]->error = result->error;
+    memcpy(files[index]->results, result->results, sizeof(result->results));
+    return 0;
+}
+
+static int timespec_equal(const struct timespec *a, const struct timespec *b) {
+    return a->tv_sec == b->tv_sec && a->tv_nsec == b->tv_nsec;
+}
+
+/*
+ * Whether st is still the inode file had when it was sampled. The change
+ * time is only meaningful for a file this run has not touched itself:
+ * linking to the first file of a group and writing cache xattrs update it.
+ */
+static int dup_unchanged(const dup_file_t *file, const struct stat *st, int check_ctime) {
+    return S_ISREG(st->st_mode) && st->st_dev == file->dev && st->st_ino == file->ino &&
+           (uint64_t)st->st_size == file->size && timespec_equal(&st->st_mtim, &file->mtime) &&
+           (!check_ctime || timespec_equal(&st->st_ctim, &file->ctime));
+}
+
+/* Compare the contents of two open files; 0 if equal, EAGAIN if not, or an errno */
+static int dup_compare(int a, int b, uint64_t size) {
+    unsigned char *buf = malloc(2 * READ_BUF_SIZE);
+    uint64_t pos = 0;
+    int err = 0;
+
+    if (!buf) {
+        return ENOMEM;
+    }
+    while (err == 0 && pos < size) {
+        size_t want = size - pos < READ_BUF_SIZE ? (size_t)(size - pos) : READ_BUF_SIZE;
+
+        errno = EAGAIN;     /* a short read means the file shrank */
+        if (pread(a, buf, want, (off_t)pos) != (ssize_t)want ||
+            pread(b, buf + READ_BUF_SIZE, want, (off_t)pos) != (ssize_t)want) {
+            err = errno;
+        } else if (memcmp(buf, buf + READ_BUF_SIZE, want) != 0) {
+            err = EAGAIN;
+        }
+        progress_add(2 * (uint64_t)want);
+        pos += want;
+    }
+    free(buf);
+    return err;
+}
+
+/*
+ * Replace dup with a hard link to, or a reflinked copy of, keep. Both files
+ * must still be the inodes that were hashed, unmodified, and are compared
+ * byte for byte first, so nothing is replaced because of a stale digest.
+ */
+static int dup_link(const dup_file_t *keep, const dup_file_t *dup, int reflink) {
+    struct stat st;
+    int src, dst, err = 0;
+
+    if (dup->dev != keep->dev) {
+        return EXDEV;
+    }
+    src = open(keep->path, O_RDONLY);
+    if (src == -1) {
+        return errno;
+    }
+    dst = open(dup->path, reflink ? O_RDWR : O_RDONLY);
+    if (dst == -1) {
+        err = errno;
+        close(src);
+        return err;
+    }
+
+    if (fstat(src, &st) != 0 || !dup_unchanged(keep, &st, 0) ||
+        fstat(dst, &st) != 0 || !dup_unchanged(dup, &st, cache_mode == CACHE_OFF)) {
+        err = EAGAIN;
+    } else {
+        err = dup_compare(src, dst, keep->size);
+    }
+    /* Neither may have been written to while they were compared */
+    if (err == 0 && (fstat(src, &st) != 0 || !dup_unchanged(keep, &st, 0) ||
+                     fstat(dst, &st) != 0 || !dup_unchanged(dup, &st, cache_mode == CACHE_OFF))) {
+        err = EAGAIN;
+    }
+
+    if (err == 0 && reflink) {
+#ifdef FICLONE
+        if (ioctl(dst, FICLONE, src) != 0) {
+            err = errno;
+        }
+#else
+        err = ENOTSUP;
+#endif
+    } else if (err == 0) {
+        /* Link beside the duplicate, then rename over it atomically */
+        size_t len = strlen(dup->path) + sizeof(".checksum-link");
+        char *tmp = malloc(len);
+
+        if (!tmp) {
+            err = ENOMEM;
+        } else {
+            snprintf(tmp, len, "%s.checksum-link", dup->path);
+            if (link(keep->path, tmp) != 0) {
+                err = errno;
+            } else if (lstat(tmp, &st) != 0 || st.st_ino != keep->ino) {
+                err = EAGAIN;   /* keep's path was replaced after the check */
+                unlink(tmp);
+            } else if (rename(tmp, dup->path) != 0) {
+                err = errno;
+                unlink(tmp);
+            }
+            free(tmp);
+        }
+    }
+    close(dst);
+    close(src);
+    return err;
+}
+
+enum { DUP_LINK_NONE, DUP_LINK_HARD, DUP_LINK_REFLINK };
+
+static int checksum_find_dups(char **roots, size_t count, int link_mode, int quiet) {
+    static char *dot[] = {"."};
+    dup_file_t *all = NULL;
+    dup_file_t **files = NULL;
+    size_t nfiles = 0, ncand, kept, groups = 0, redundant = 0, linked = 0;
+    uint64_t reclaimable = 0;
+    int failed = 0;
+
+    if (count == 0) {
+        roots = dot;
+        count = 1;
+    }
+
+    /* Stage 1: walk, then keep sizes shared by two or more non-empty files */
+    for (size_t r = 0; r < count; r++) {
+        tree_walk_t walk = {0};
+        tree_node_t root = {0};
+        dup_file_t *grown;
+
+        root.path = roots[r];
+        root.name = roots[r];
+        tree_scan(&walk, &root);
+        if (tree_report_errors(&root)) {
+            failed = 1;
+        }
+
+        grown = realloc(all, (nfiles + walk.count + 1) * sizeof(*all));
+        if (grown) {
+            all = grown;
+            for (size_t i = 0; i < walk.count; i++) {
+                dup_file_t *f = &all[nfiles];
+
+                if (walk.files[i]->size == 0) {
+                    continue;
+                }
+                memset(f, 0, sizeof(*f));
+                f->size = walk.files[i]->size;
+                f->index = nfiles;
+                f->path = strdup(walk.paths[i]);
+                if (f->path) {
+                    nfiles++;
+                } else {
+                    fprintf(stderr, "%s: %s: %s\n", program_name, walk.paths[i],
+                            strerror(ENOMEM));
+                    failed = 1;
+                }
+            }
+        } else {
+            fprintf(stderr, "%s: %s: %s\n", program_name, roots[r], strerror(ENOMEM));
+            failed = 1;
+        }
+        tree_free(&root, 1);
+        free(walk.files);
+        free(walk.paths);
+    }
+
+    files = malloc((nfiles + 1) * sizeof(*files));
+    if (!files) {
+        fprintf(stderr, "%s: %s\n", program_name, strerror(ENOMEM));
+        nfiles = 0;
+        failed = 1;
+    }
+    for (size_t i = 0; files && i < nfiles; i++) {
+        files[i] = &all[i];
+    }
+    if (nfiles > 1) {
+        qsort(files, nfiles, sizeof(*files), dup_by_size);
+    }
+    ncand = dup_keep_runs(files, nfiles, dup_same_size);
+
+    /* Stage 2: head and tail samples; one path per inode */
+    dup_sample_all(files, ncand);
+    if (ncand > 1) {
+        qsort(files, ncand, sizeof(*files), dup_by_inode);
+    }
+    ncand = dup_drop(files, ncand, &failed);
+    if (ncand > 1) {
+        qsort(files, ncand, sizeof(*files), dup_by_sample);
+    }
+    ncand = dup_keep_runs(files, ncand, dup_same_sample);
+
+    /* Stage 3: full hashes of the survivors */
+    if (ncand > 0) {
+        char **paths = malloc(ncand * sizeof(*paths));
+
+        for (size_t i = 0; paths && i < ncand; i++) {
+            paths[i] = files[i]->path;
+        }
+        if (!paths || jobs < 2 || ncand < 2 ||
+            run_file_pool(paths, ncand, cli_spec(), jobs, (size_t)jobs, emit_dup,
+                          files) < 0) {
+            static unsigned char buffer[READ_BUF_SIZE];
+
+            for (size_t i = 0; i < ncand; i++) {
+                files[i]->error = hash_path(files[i]->path, cli_spec(), buffer,
+                                            sizeof(buffer), files[i]->results);
+            }
+        }
+        free(paths);
+    }
+    kept = 0;
+    for (size_t i = 0; i < ncand; i++) {
+        if (files[i]->error != 0) {
+            fprintf(stderr, "%s: %s: %s\n", program_name, files[i]->path,
+                    strerror(files[i]->error));
+            failed = 1;
+        } else {
+            files[kept++] = files[i];
+        }
+    }
+    ncand = kept;
+    if (ncand > 1) {
+        qsort(files, ncand, sizeof(*files), dup_by_digest);
+    }
+    ncand = dup_keep_runs(files, ncand, dup_same_content);
+
+    /* Groups, largest files first, separated by blank lines */
+    for (size_t start = 0, end; start < ncand; start = end) {
+        for (end = start + 1; end < ncand && dup_same_content(files[start], files[end]); end++) {
+        }
+        if (groups > 0) {
+            out_end_line(&out);
+        }
+        for (size_t i = start; i < end; i++) {
+            print_checksum(files[i]->results, files[i]->path, 0);
+        }
+        groups++;
+        redundant += end - start - 1;
+        reclaimable += (end - start - 1) * files[start]->size;
+
+        for (size_t i = start + 1; link_mode != DUP_LINK_NONE && i < end; i++) {
+            int err = dup_link(files[start], files[i], link_mode == DUP_LINK_REFLINK);
+
+            if (err != 0) {
+                fprintf(stderr, "%s: %s: cannot link: %s\n", program_name, files[i]->path,
+                        err == EAGAIN ? "changed during the scan" : strerror(err));
+                failed = 1;
+            } else {
+                linked++;
+            }
+        }
+    }
+
+    out_flush(&out);
+    if (!quiet) {
+        fprintf(stderr, "%s: %zu duplicate groups, %zu redundant files, %" PRIu64
+                " bytes reclaimable\n", program_name, groups, redundant, reclaimable);
+        if (link_mode != DUP_LINK_NONE) {
+            fprintf(stderr, "%s: %zu files replaced by %s\n", program_name, linked,
+                    link_mode == DUP_LINK_REFLINK ? "reflinks" : "hard links");
+        }
+    }
+
+    for (size_t i = 0; i < nfiles; i++) {
+        free(all[i].path);
+    }
+    free(all);
+    free(files);
+    return failed;
+}
+
+/* Parse --cdc's AVG or MIN,AVG,MAX; a lone AVG gets AVG/4 and AVG*8 bounds */
+static int parse_cdc_sizes(const char *arg, checksum_cdc_t *cdc) {
+    uint64_t sizes[3];
+    char part[32];
+    size_t n = 0;
+
+    for (const char *p = arg;; p++) {
+        size_t len = strcspn(p, ",");
+
+        if (n == 3 || len == 0 || len >= sizeof(part)) {
+            return -1;
+        }
+        memcpy(part, p, len);
+        part[len] = '\0';
+        if (parse_size(part, &sizes[n]) != 0 || sizes[n] > UINT32_MAX) {
+            return -1;
+        }
+        n++;
+        p += len;
+        if (*p == '\0') {
+            break;
+        }
+    }
+
+    if (n == 1) {
+        sizes[1] = sizes[0];
+        sizes[0] = sizes[1] / 4;
+        sizes[2] = sizes[1] * 8 < UINT32_MAX ? sizes[1] * 8 : UINT32_MAX;
+    } else if (n != 3) {
+        return -1;
+    }
+    return checksum_cdc_init(cdc, (uint32_t)sizes[0], (uint32_t)sizes[1],
+                             (uint32_t)sizes[2]) == CHECKSUM_SUCCESS ? 0 : -1;
+}
+
+static int algorithm_given = 0;     /* algos set by an option, not the default */
+
+static void set_algorithm(checksum_type_t type) {
+    algos[0] = type;
+    nalgos = 1;
+    algorithm_given = 1;
+}
+
+/* Select the algorithms in a comma-separated list such as "crc32,adler32" */
+static int parse_algorithms(const char *list) {
+    char name[32];
+    size_t count = 0;
+
+    for (const char *p = list;; p++) {
+        size_t len = strcspn(p, ",");
+
+        if (count == MAX_ALGOS) {
+            fprintf(stderr, "%s: at most %d algorithms may be given\n", program_name, MAX_ALGOS);
+            return -1;
+        }
+        if (len == 0 || len >= sizeof(name)) {
+            fprintf(stderr, "%s: invalid algorithm list: '%s'\n", program_name, list);
+            return -1;
+        }
+        memcpy(name, p, len);
+        name[len] = '\0';
+        if (checksum_type_from_name(name, &algos[count]) != CHECKSUM_SUCCESS) {
+            fprintf(stderr, "%s: unknown algorithm: '%s'\n", program_name, name);
+            return -1;
+        }
+        count++;
+
+        p += len;
+        if (*p == '\0') {
+            break;
+        }
+    }
+
+    nalgos = count;
+    algorithm_given = 1;
+    return 0;
 }
 
-static void print_version(void) {
-    printf("%s (dev-utils) 1.0.0\n", program_name);
-    printf("Copyright (C) 2025 AnmiTaliDev\n");
-    printf("License GPLv3+: GNU GPL version 3 or later <https://gnu.org/licenses/gpl.html>.\n");
-    printf("This is free software: you are free to change and redistribute it.\n");
-    printf("There is NO WARRANTY, to the extent permitted by law.\n");
+/*
+ * --offset/--length and --ranges: hash byte ranges of a file, such as a
+ * partition of a disk image, with pread() instead of piping them through
+ * dd. Ranges of one file are hashed in parallel, one per worker.
+ */
+#define RANGE_TO_END        UINT64_MAX
+#define RANGE_SEPARATORS    ", \t\r\n"
+#define RANGE_PAST_END      (-1)    /* error: range extends past the end */
+
+typedef struct {
+    uint64_t offset;
+    uint64_t length;            /* RANGE_TO_END: up to the end of the file */
+    checksum_result_t results[MAX_ALGOS];
+    int error;                  /* errno value or RANGE_PAST_END */
+} byte_range_t;
+
+typedef struct {
+    int fd;
+    byte_range_t *ranges;
+    size_t count;
+    size_t next;
+    pthread_mutex_t lock;
+} range_pool_t;
+
+/* Like parse_size(), but 0 is a valid offset */
+static int parse_offset(const char *arg, uint64_t *value) {
+    if (strcmp(arg, "0") == 0) {
+        *value = 0;
+        return 0;
+    }
+    return parse_size(arg, value);
 }
 
-static uint32_t crc32_table[256];
-static int crc32_table_computed = 0;
+/* One OFFSET[+LENGTH] entry of a --ranges list */
+static int parse_range(const char *arg, byte_range_t *range) {
+    char part[64];
+    size_t len = strcspn(arg, "+");
 
-static void make_crc32_table(void) {
-    uint32_t c;
-    int n, k;
-    
-    for (n = 0; n < 256; n++) {
-        c = (uint32_t) n;
-        for (k = 0; k < 8; k++) {
-            if (c & 1) {
-                c = 0xedb88320L ^ (c >> 1);
-            } else {
-                c = c >> 1;
+    if (len == 0 || len >= sizeof(part)) {
+        return -1;
+    }
+    memcpy(part, arg, len);
+    part[len] = '\0';
+    if (parse_offset(part, &range->offset) != 0) {
+        return -1;
+    }
+    range->length = RANGE_TO_END;
+    return arg[len] == '+' ? parse_size(arg + len + 1, &range->length) : 0;
+}
+
+/* Parse a --ranges LIST, or read it from FILE for "@FILE" */
+static byte_range_t *parse_ranges(const char *arg, size_t *count) {
+    byte_range_t *ranges = NULL;
+    size_t n = 0, capacity = 0;
+    char *text = NULL;
+    const char *p = arg;
+
+    if (arg[0] == '@') {
+        int fd = open(arg + 1, O_RDONLY);
+        size_t size;
+
+        text = fd == -1 ? NULL : slurp_fd(fd, &size);
+        if (!text) {
+            fprintf(stderr, "%s: %s: %s\n", program_name, arg + 1, strerror(errno));
+            if (fd != -1) {
+                close(fd);
             }
+            return NULL;
         }
-        crc32_table[n] = c;
+        close(fd);
+        text[size] = '\0';
+        p = text;
     }
-    crc32_table_computed = 1;
-}
 
-static uint32_t update_crc32(uint32_t crc, const unsigned char *buf, size_t len) {
-    uint32_t c = crc;
-    size_t n;
-    
-    if (!crc32_table_computed) {
-        make_crc32_table();
+    for (p += strspn(p, RANGE_SEPARATORS); *p; p += strspn(p, RANGE_SEPARATORS)) {
+        size_t len = strcspn(p, RANGE_SEPARATORS);
+        char token[128];
+
+        if (n == capacity) {
+            byte_range_t *grown;
+
+            capacity = capacity ? capacity * 2 : 16;
+            grown = realloc(ranges, capacity * sizeof(*ranges));
+            if (!grown) {
+                fprintf(stderr, "%s: %s\n", program_name, strerror(ENOMEM));
+                goto fail;
+            }
+            ranges = grown;
+        }
+        if (len >= sizeof(token)) {
+            fprintf(stderr, "%s: invalid range: '%.*s' (too long)\n", program_name, (int)len, p);
+            goto fail;
+        }
+        memcpy(token, p, len);
+        token[len] = '\0';
+        if (parse_range(token, &ranges[n]) != 0) {
+            fprintf(stderr, "%s: invalid range: '%s' (expected OFFSET[+LENGTH])\n", program_name,
+                    token);
+            goto fail;
+        }
+        n++;
+        p += strcspn(p, RANGE_SEPARATORS);
     }
-    
-    for (n = 0; n < len; n++) {
-        c = crc32_table[(c ^ buf[n]) & 0xff] ^ (c >> 8);
+
+    if (n == 0) {
+        fprintf(stderr, "%s: --ranges: no ranges given\n", program_name);
+        goto fail;
     }
-    
-    return c;
+    free(text);
+    *count = n;
+    return ranges;
+
+fail:
+    free(text);
+    free(ranges);
+    return NULL;
 }
 
-static uint32_t crc32_checksum(const unsigned char *buf, size_t len) {
-    return update_crc32(0xffffffffL, buf, len) ^ 0xffffffffL;
+static void *range_worker(void *arg) {
+    range_pool_t *pool = arg;
+    unsigned char *buf = malloc(PARALLEL_BUF_SIZE);
+
+    for (;;) {
+        byte_range_t *range;
+        multi_ctx_t multi;
+        size_t i;
+
+        pthread_mutex_lock(&pool->lock);
+        i = pool->next++;
+        pthread_mutex_unlock(&pool->lock);
+        if (i >= pool->count) {
+            break;
+        }
+
+        range = &pool->ranges[i];
+        if (range->error != 0) {
+            continue;
+        }
+        if (!buf) {
+            range->error = ENOMEM;
+            continue;
+        }
+        multi_init(&multi, cli_spec());
+        posix_fadvise(pool->fd, (off_t)range->offset, (off_t)range->length,
+                      POSIX_FADV_SEQUENTIAL);
+        range->error = hash_range(&multi, pool->fd, buf, PARALLEL_BUF_SIZE, (off_t)range->offset,
+                                  (off_t)(range->offset + range->length));
+        if (range->error == 0) {
+            multi_final(&multi, range->results);
+        }
+    }
+
+    free(buf);
+    return NULL;
 }
 
-static uint32_t adler32_checksum(const unsigned char *buf, size_t len) {
-    uint32_t a = 1, b = 0;
-    size_t i;
-    
-    for (i = 0; i < len; i++) {
-        a = (a + buf[i]) % 65521;
-        b = (b + a) % 65521;
+/* Resolve the ranges against a file of the given size and hash them */
+static void hash_ranges_seekable(int fd, uint64_t size, byte_range_t *ranges, size_t count) {
+    range_pool_t pool = {fd, ranges, count, 0, PTHREAD_MUTEX_INITIALIZER};
+    pthread_t threads[MAX_JOBS];
+    long nworkers = jobs < (long)count ? jobs : (long)count;
+    long started = 0;
+
+    for (size_t i = 0; i < count; i++) {
+        byte_range_t *r = &ranges[i];
+
+        r->error = 0;
+        if (r->offset > size) {
+            r->error = RANGE_PAST_END;
+        } else if (r->length == RANGE_TO_END) {
+            r->length = size - r->offset;
+        } else if (r->length > size - r->offset) {
+            r->error = RANGE_PAST_END;
+        }
     }
-    
-    return (b << 16) | a;
+
+    for (long i = 0; nworkers > 1 && i < nworkers; i++) {
+        if (pthread_create(&threads[started], NULL, range_worker, &pool) == 0) {
+            started++;
+        }
+    }
+    if (started == 0) {
+        range_worker(&pool);
+    }
+    for (long i = 0; i < started; i++) {
+        pthread_join(threads[i], NULL);
+    }
+    pthread_mutex_destroy(&pool.lock);
 }
 
-static uint32_t bsd_sum_checksum(const unsigned char *buf, size_t len) {
-    uint32_t checksum = 0;
-    size_t i;
-    
-    for (i = 0; i < len; i++) {
-        checksum = ((checksum >> 1) + ((checksum & 1) << 15) + buf[i]) & 0xffff;
+/* A pipe or terminal: skip to the offset by reading, then hash the range */
+static void hash_range_stream(int fd, byte_range_t *range) {
+    static unsigned char buffer[READ_BUF_SIZE];
+    uint64_t skip = range->offset, left = range->length;
+    multi_ctx_t multi;
+
+    multi_init(&multi, cli_spec());
+    range->error = 0;
+    while (skip > 0 || left > 0) {
+        size_t want = sizeof(buffer);
+        ssize_t got;
+
+        if (skip > 0 && skip < want) {
+            want = (size_t)skip;
+        } else if (skip == 0 && left < want) {
+            want = (size_t)left;
+        }
+
+        got = read(fd, buffer, want);
+        if (got < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            range->error = errno;
+            return;
+        }
+        if (got == 0) {
+            if (skip == 0 && left == RANGE_TO_END) {
+                break;
+            }
+            range->error = RANGE_PAST_END;
+            return;
+        }
+        if (skip > 0) {
+            skip -= (uint64_t)got;
+            continue;
+        }
+        multi_update(&multi, buffer, (size_t)got);
+        if (left != RANGE_TO_END) {
+            left -= (uint64_t)got;
+        }
     }
-    
-    return checksum;
+    multi_final(&multi, range->results);
 }
 
-static uint32_t calculate_checksum(const unsigned char *buf, size_t len, checksum_type_t type) {
-    switch (type) {
-        case CHECKSUM_CRC32:
-            return crc32_checksum(buf, len);
-        case CHECKSUM_ADLER32:
-            return adler32_checksum(buf, len);
-        case CHECKSUM_BSD_SUM:
-            return bsd_sum_checksum(buf, len);
-        default:
-            return 0;
+static void print_range(const byte_range_t *range, const char *name, int labelled, int quiet) {
+    char *label;
+
+    if (range->error != 0) {
+        if (range->error == RANGE_PAST_END && range->length == RANGE_TO_END) {
+            fprintf(stderr, "%s: %s: offset %" PRIu64 " is past the end of the file\n",
+                    program_name, name, range->offset);
+        } else if (range->error == RANGE_PAST_END) {
+            fprintf(stderr, "%s: %s: range %" PRIu64 "+%" PRIu64 " extends past the end of the file\n",
+                    program_name, name, range->offset, range->length);
+        } else {
+            fprintf(stderr, "%s: %s: %s\n", program_name, name, strerror(range->error));
+        }
+        return;
+    }
+    if (!labelled) {
+        print_checksum(range->results, name, quiet);
+        return;
+    }
+
+    label = malloc(strlen(name) + 48);
+    if (!label) {
+        print_checksum(range->results, name, quiet);
+        return;
     }
+    sprintf(label, "%s@%" PRIu64 "+%" PRIu64, name, range->offset, range->length);
+    print_checksum(range->results, label, quiet);
+    free(label);
 }
 
-static const char *get_checksum_name(checksum_type_t type) {
-    switch (type) {
-        case CHECKSUM_CRC32: return "CRC32";
-        case CHECKSUM_ADLER32: return "ADLER32";
-        case CHECKSUM_BSD_SUM: return "BSD";
-        default: return "UNKNOWN";
+/*
+ * Hash the ranges of every FILE (standard input if none). Single ranges
+ * print as "HEX  NAME", like hashing the extracted bytes; with labelled
+ * set, each line names its range as "NAME@OFFSET+LENGTH".
+ */
+static int checksum_ranges(char **files, size_t count, const byte_range_t *ranges,
+                           size_t nranges, int labelled, int quiet) {
+    static char *stdin_only[] = {"-"};
+    byte_range_t *work = malloc(nranges * sizeof(*work));
+    int exit_code = 0;
+
+    if (!work) {
+        fprintf(stderr, "%s: %s\n", program_name, strerror(ENOMEM));
+        return 1;
+    }
+    if (count == 0) {
+        files = stdin_only;
+        count = 1;
+    }
+
+    for (size_t i = 0; i < count; i++) {
+        int use_stdin = strcmp(files[i], "-") == 0;
+        const char *name = use_stdin ? "(standard input)" : files[i];
+        int fd = use_stdin ? STDIN_FILENO : open(files[i], O_RDONLY);
+        struct stat st;
+        int err = 0;
+
+        if (fd == -1 || fstat(fd, &st) != 0) {
+            fprintf(stderr, "%s: %s: %s\n", program_name, name, strerror(errno));
+            exit_code = 1;
+            if (fd != -1 && !use_stdin) {
+                close(fd);
+            }
+            continue;
+        }
+
+        memcpy(work, ranges, nranges * sizeof(*work));
+        if (S_ISREG(st.st_mode) || S_ISBLK(st.st_mode)) {
+            /* Block devices report their size through lseek() */
+            off_t size = S_ISREG(st.st_mode) ? st.st_size : lseek(fd, 0, SEEK_END);
+
+            if (size >= 0) {
+                hash_ranges_seekable(fd, (uint64_t)size, work, nranges);
+            }
+            err = size < 0 ? errno : 0;
+        } else if (nranges == 1) {
+            hash_range_stream(fd, &work[0]);
+        } else {
+            err = ESPIPE;
+        }
+        if (!use_stdin) {
+            close(fd);
+        }
+        if (err != 0) {
+            fprintf(stderr, "%s: %s: %s\n", program_name, name,
+                    err == ESPIPE ? "several ranges need a regular file or block device"
+                                  : strerror(err));
+            exit_code = 1;
+            continue;
+        }
+
+        for (size_t r = 0; r < nranges; r++) {
+            print_range(&work[r], name, labelled, quiet);
+            if (work[r].error != 0) {
+                exit_code = 1;
+            }
+        }
     }
+
+    free(work);
+    return exit_code;
 }
 
-static int checksum_file(const char *filename, int quiet) {
-    FILE *file;
-    unsigned char buffer[8192];
-    size_t bytes_read;
-    uint32_t checksum = 0;
-    uint32_t running_crc = 0xffffffffL;
-    uint32_t running_adler_a = 1, running_adler_b = 0;
-    uint32_t running_bsd = 0;
-    int result = 0;
-    
-    if (!filename) {
-        file = stdin;
-        filename = "(standard input)";
-    } else {
-        file = fopen(filename, "rb");
-        if (!file) {
-            fprintf(stderr, "%s: %s: %s\n", program_name, filename, strerror(errno));
-            return 1;
+static void print_crc_catalog(void) {
+    size_t count;
+    const checksum_crc_params_t *catalog = checksum_crc_catalog(&count);
+
+    printf("%-18s %5s %18s %18s %5s %6s %18s %18s  %s\n", "NAME", "WIDTH", "POLY", "INIT",
+           "REFIN", "REFOUT", "XOROUT", "CHECK", "ALIAS");
+    for (size_t i = 0; i < count; i++) {
+        const checksum_crc_params_t *p = &catalog[i];
+        int digits = (int)(p->width + 3) / 4;
+
+        printf("%-18s %5u %*s0x%0*llx %*s0x%0*llx %5s %6s %*s0x%0*llx %*s0x%0*llx",
+               p->name, p->width,
+               16 - digits, "", digits, (unsigned long long)p->poly,
+               16 - digits, "", digits, (unsigned long long)p->init,
+               p->refin ? "true" : "false", p->refout ? "true" : "false",
+               16 - digits, "", digits, (unsigned long long)p->xorout,
+               16 - digits, "", digits, (unsigned long long)p->check);
+        if (p->alias) {
+            printf("  %s", p->alias);
         }
+        putchar('\n');
     }
-    
-    while ((bytes_read = fread(buffer, 1, sizeof(buffer), file)) > 0) {
-        switch (checksum_type) {
-            case CHECKSUM_CRC32:
-                running_crc = update_crc32(running_crc, buffer, bytes_read);
-                break;
-            case CHECKSUM_ADLER32:
-                for (size_t i = 0; i < bytes_read; i++) {
-                    running_adler_a = (running_adler_a + buffer[i]) % 65521;
-                    running_adler_b = (running_adler_b + running_adler_a) % 65521;
-                }
-                break;
-            case CHECKSUM_BSD_SUM:
-                for (size_t i = 0; i < bytes_read; i++) {
-                    running_bsd = ((running_bsd >> 1) + ((running_bsd & 1) << 15) + buffer[i]) & 0xffff;
+}
+
+/* --crc=NAME: one catalog CRC per FILE, printed as width/4 hex digits */
+static int checksum_crc_files(const checksum_crc_params_t *params, char **files, size_t count,
+                              int quiet) {
+    static unsigned char buffer[READ_BUF_SIZE];
+    static char *stdin_only[] = {"-"};
+    int digits = (int)(params->width + 3) / 4;
+    int exit_code = 0;
+
+    if (count == 0) {
+        files = stdin_only;
+        count = 1;
+    }
+
+    for (size_t i = 0; i < count; i++) {
+        int use_stdin = strcmp(files[i], "-") == 0;
+        const char *name = use_stdin ? "(standard input)" : files[i];
+        int fd = use_stdin ? STDIN_FILENO : open(files[i], O_RDONLY);
+        checksum_crc_ctx_t ctx;
+        ssize_t got;
+
+        if (fd == -1) {
+            fprintf(stderr, "%s: %s: %s\n", program_name, name, strerror(errno));
+            exit_code = 1;
+            continue;
+        }
+        if (!use_stdin) {
+            posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+        }
+
+        progress_file_begin(name, fd);
+        checksum_crc_init(&ctx, params);
+        while ((got = read(fd, buffer, sizeof(buffer))) != 0) {
+            if (got < 0) {
+                if (errno == EINTR) {
+                    continue;
                 }
                 break;
+            }
+            checksum_crc_update(&ctx, buffer, (size_t)got);
+            progress_add((uint64_t)got);
         }
+        progress_file_end();
+        if (got < 0) {
+            fprintf(stderr, "%s: %s: %s\n", program_name, name, strerror(errno));
+            exit_code = 1;
+        }
+        if (!use_stdin) {
+            close(fd);
+        }
+        if (got < 0) {
+            continue;
+        }
+
+        if (output_tag && !quiet) {
+            put_tag(params->name, name);
+            out_hex_value(checksum_crc_final(&ctx), digits);
+        } else {
+            if (!quiet && name_needs_escape(&out, name)) {
+                out_char(&out, '\\');
+            }
+            out_hex_value(checksum_crc_final(&ctx), digits);
+            if (!quiet) {
+                out_bytes(&out, "  ", 2);
+                put_name(&out, name);
+            }
+        }
+        out_end_line(&out);
     }
-    
-    switch (checksum_type) {
-        case CHECKSUM_CRC32:
-            checksum = running_crc ^ 0xffffffffL;
-            break;
-        case CHECKSUM_ADLER32:
-            checksum = (running_adler_b << 16) | running_adler_a;
-            break;
-        case CHECKSUM_BSD_SUM:
-            checksum = running_bsd;
-            break;
-    }
-    
-    if (ferror(file)) {
-        fprintf(stderr, "%s: %s: %s\n", program_name, filename, strerror(errno));
-        result = 1;
-        goto cleanup;
-    }
-    
-    if (quiet) {
-        printf("%08x\n", checksum);
-    } else {
-        printf("%08x  %s\n", checksum, filename);
-    }
-    
-cleanup:
-    if (file != stdin) {
-        fclose(file);
+    return exit_code;
+}
+
+static int checksum_files_parallel(char **files, size_t count, int quiet) {
+    print_ctx_t ctx = {files, quiet, 0};
+
+    if (run_file_pool(files, count, cli_spec(), jobs, 0, emit_print, &ctx) < 0) {
+        return -1;
     }
-    
-    return result;
+    return ctx.failed;
 }
 
 int main(int argc, char *argv[]) {
     int c;
     int exit_code = 0;
     int quiet = 0;
+    int fail_fast = 0;
+    int recursive = 0;
+    int tree = 0;
+    uint64_t block_size = 0;
+    const char *compare_map = NULL;
     const char *verify_file = NULL;
+    const char *delta_arg = NULL;
+    int delta_mode = 0;
+    int cdc_mode = 0;
+    int find_dups = 0;
+    const checksum_crc_params_t *crc_variant = NULL;
+    byte_range_t single_range = {0, RANGE_TO_END, {{0}}, 0};
+    int single_range_given = 0;
+    const char *ranges_arg = NULL;
+    int show_progress = 0;
+    const char *tee_path = NULL;
+    int link_mode = DUP_LINK_NONE;
+    static checksum_cdc_t cdc;
     
     static struct option long_options[] = {
         {"crc32", no_argument, 0, 'c'},
+        {"crc32c", no_argument, 0, 'C'},
         {"sum", no_argument, 0, 's'},
         {"adler32", no_argument, 0, 'a'},
+        {"algorithms", required_argument, 0, 'A'},
+        {"sha256", no_argument, 0, 'S'},
+        {"sha1", no_argument, 0, 'H'},
+        {"blake3", no_argument, 0, 'B'},
+        {"xxh64", no_argument, 0, 'X'},
+        {"xxh3", no_argument, 0, 'Y'},
+        {"xxh128", no_argument, 0, 'Z'},
+        {"jobs", required_argument, 0, 'j'},
         {"verify", required_argument, 0, 'v'},
+        {"fail-fast", no_argument, 0, 'F'},
+        {"recursive", no_argument, 0, 'r'},
+        {"tree", no_argument, 0, 'T'},
+        {"blocks", required_argument, 0, 'M'},
+        {"compare", required_argument, 0, 'D'},
+        {"signature", required_argument, 0, 'G'},
+        {"delta", required_argument, 0, 'E'},
+        {"patch", required_argument, 0, 'P'},
+        {"cdc", optional_argument, 0, 'U'},
+        {"crc", required_argument, 0, 'N'},
+        {"offset", required_argument, 0, 'O'},
+        {"length", required_argument, 0, 'W'},
+        {"ranges", required_argument, 0, 'J'},
+        {"find-dups", no_argument, 0, 'Q'},
+        {"link", required_argument, 0, 'L'},
+        {"cache", no_argument, 0, 'K'},
+        {"refresh", no_argument, 0, 'R'},
+        {"progress", no_argument, 0, 'I'},
+        {"tee", required_argument, 0, 'e'},
+        {"tag", no_argument, 0, 't'},
+        {"zero", no_argument, 0, 'z'},
         {"quiet", no_argument, 0, 'q'},
         {"help", no_argument, 0, 'h'},
         {"version", no_argument, 0, 'V'},
         {0, 0, 0, 0}
     };
     
-    while ((c = getopt_long(argc, argv, "csav:qh", long_options, NULL)) != -1) {
+    while ((c = getopt_long(argc, argv, "csaA:j:v:rzqh", long_options, NULL)) != -1) {
         switch (c) {
             case 'c':
-                checksum_type = CHECKSUM_CRC32;
+                set_algorithm(CHECKSUM_CRC32);
+                break;
+            case 'C':
+                set_algorithm(CHECKSUM_CRC32C);
                 break;
             case 's':
-                checksum_type = CHECKSUM_BSD_SUM;
+                set_algorithm(CHECKSUM_BSD_SUM);
                 break;
             case 'a':
-                checksum_type = CHECKSUM_ADLER32;
+                set_algorithm(CHECKSUM_ADLER32);
+                break;
+            case 'S':
+                set_algorithm(CHECKSUM_SHA256);
+                break;
+            case 'H':
+                set_algorithm(CHECKSUM_SHA1);
+                break;
+            case 'B':
+                set_algorithm(CHECKSUM_BLAKE3);
+                break;
+            case 'X':
+                set_algorithm(CHECKSUM_XXH64);
+                break;
+            case 'Y':
+                set_algorithm(CHECKSUM_XXH3_64);
                 break;
+            case 'Z':
+                set_algorithm(CHECKSUM_XXH3_128);
+                break;
+            case 'A':
+                if (parse_algorithms(optarg) != 0) {
+                    return 1;
+                }
+                break;
+            case 'j': {
+                char *end;
+                errno = 0;
+                jobs = strtol(optarg, &end, 10);
+                if (errno != 0 || end == optarg || *end != '\0' || jobs < 0 || jobs > MAX_JOBS) {
+                    fprintf(stderr, "%s: invalid number of jobs: '%s'\n", program_name, optarg);
+                    return 1;
+                }
+                if (jobs == 0) {
+                    jobs = sysconf(_SC_NPROCESSORS_ONLN);
+                    if (jobs < 1) {
+                        jobs = 1;
+                    } else if (jobs > MAX_JOBS) {
+                        jobs = MAX_JOBS;
+                    }
+                }
+                break;
+            }
             case 'v':
                 verify_file = optarg;
                 break;
+            case 'F':
+                fail_fast = 1;
+                break;
+            case 'r':
+                recursive = 1;
+                break;
+            case 'T':
+                tree = 1;
+                break;
+            case 'M':
+                if (parse_size(optarg, &block_size) != 0) {
+                    fprintf(stderr, "%s: invalid block size: '%s'\n", program_name, optarg);
+                    return 1;
+                }
+                break;
+            case 'D':
+                compare_map = optarg;
+                break;
+            case 'G':
+                delta_mode = DELTA_SIGNATURE;
+                delta_arg = optarg;
+                break;
+            case 'E':
+                delta_mode = DELTA_ENCODE;
+                delta_arg = optarg;
+                break;
+            case 'P':
+                delta_mode = DELTA_PATCH;
+                delta_arg = optarg;
+                break;
+            case 'U':
+                if (optarg ? parse_cdc_sizes(optarg, &cdc) != 0
+                           : checksum_cdc_init(&cdc, 2048, 8192, 65536) != CHECKSUM_SUCCESS) {
+                    fprintf(stderr, "%s: invalid chunk sizes: '%s' (need 64 <= MIN <= AVG <= MAX)\n",
+                            program_name, optarg);
+                    return 1;
+                }
+                cdc_mode = 1;
+                break;
+            case 'N':
+                if (strcmp(optarg, "list") == 0) {
+                    print_crc_catalog();
+                    return 0;
+                }
+                crc_variant = checksum_crc_find(optarg);
+                if (!crc_variant) {
+                    fprintf(stderr, "%s: unknown CRC '%s' (see --crc=list)\n", program_name,
+                            optarg);
+                    return 1;
+                }
+                break;
+            case 'O':
+                if (parse_offset(optarg, &single_range.offset) != 0) {
+                    fprintf(stderr, "%s: invalid offset: '%s'\n", program_name, optarg);
+                    return 1;
+                }
+                single_range_given = 1;
+                break;
+            case 'W':
+                if (parse_size(optarg, &single_range.length) != 0) {
+                    fprintf(stderr, "%s: invalid length: '%s'\n", program_name, optarg);
+                    return 1;
+                }
+                single_range_given = 1;
+                break;
+            case 'J':
+                ranges_arg = optarg;
+                break;
+            case 'Q':
+                find_dups = 1;
+                break;
+            case 'L':
+                if (strcmp(optarg, "hard") == 0) {
+                    link_mode = DUP_LINK_HARD;
+                } else if (strcmp(optarg, "reflink") == 0) {
+                    link_mode = DUP_LINK_REFLINK;
+                } else {
+                    fprintf(stderr, "%s: --link must be 'hard' or 'reflink'\n", program_name);
+                    return 1;
+                }
+                break;
+            case 'K':
+                if (cache_mode == CACHE_OFF) {
+                    cache_mode = CACHE_USE;
+                }
+                break;
+            case 'R':
+                cache_mode = CACHE_REFRESH;
+                break;
+            case 'I':
+                show_progress = 1;
+                break;
+            case 'e':
+                tee_path = optarg;
+                break;
+            case 't':
+                output_tag = 1;
+                break;
+            case 'z':
+                output_zero = 1;
+                break;
             case 'q':
                 quiet = 1;
                 break;
@@ -260,20 +4609,149 @@ int main(int argc, char *argv[]) {
         }
     }
     
-    if (verify_file) {
-        fprintf(stderr, "%s: verify functionality not yet implemented\n", program_name);
+    if (output_tag && (delta_mode || cdc_mode || block_size || compare_map)) {
+        fprintf(stderr, "%s: --tag only applies to checksum lines\n", program_name);
+        return 1;
+    }
+    if (output_zero && (delta_mode || block_size)) {
+        fprintf(stderr, "%s: --zero does not apply to block maps and deltas\n", program_name);
+        return 1;
+    }
+    if (output_tag && verify_file) {
+        fprintf(stderr, "%s: --tag is meaningless when verifying checksums\n", program_name);
+        return 1;
+    }
+    if (tee_path && (optind < argc || verify_file || single_range_given || ranges_arg ||
+                     delta_mode || find_dups || crc_variant || cdc_mode || recursive || tree ||
+                     block_size || compare_map)) {
+        fprintf(stderr, "%s: --tee hashes standard input and takes no FILE or other mode\n",
+                program_name);
         return 1;
     }
     
-    if (optind >= argc) {
-        exit_code = checksum_file(NULL, quiet);
-    } else {
+    out_init();
+    progress_start(show_progress);
+    if (show_progress && !recursive && !tree) {
         for (int i = optind; i < argc; i++) {
-            if (checksum_file(argv[i], quiet) != 0) {
-                exit_code = 1;
+            struct stat st;
+
+            if (stat(argv[i], &st) == 0 && S_ISREG(st.st_mode)) {
+                progress_expect((uint64_t)st.st_size, 1);
             }
         }
     }
     
+    if (verify_file) {
+        checksum_verify_options_t options = {algos, nalgos, (unsigned int)jobs, quiet,
+                                             fail_fast, output_zero, cache_mode};
+
+        return verify_run(verify_file, &options, 1);
+    }
+    
+    if (tee_path) {
+        return checksum_tee(tee_path, quiet);
+    }
+    
+    if (single_range_given || ranges_arg) {
+        byte_range_t *ranges = &single_range;
+        size_t nranges = 1;
+
+        if (single_range_given && ranges_arg) {
+            fprintf(stderr, "%s: use either --offset/--length or --ranges\n", program_name);
+            return 1;
+        }
+        if (delta_mode || find_dups || cdc_mode || crc_variant || recursive || tree ||
+            block_size || compare_map) {
+            fprintf(stderr, "%s: byte ranges cannot be combined with other modes\n",
+                    program_name);
+            return 1;
+        }
+        if (ranges_arg && !(ranges = parse_ranges(ranges_arg, &nranges))) {
+            return 1;
+        }
+        exit_code = checksum_ranges(argv + optind, (size_t)(argc - optind), ranges, nranges,
+                                    ranges_arg != NULL, quiet);
+        if (ranges != &single_range) {
+            free(ranges);
+        }
+        return exit_code;
+    }
+    
+    if (delta_mode) {
+        return checksum_delta_mode(delta_mode, delta_arg, argv + optind,
+                                   (size_t)(argc - optind), block_size);
+    }
+    
+    if (link_mode != DUP_LINK_NONE && !find_dups) {
+        fprintf(stderr, "%s: --link requires --find-dups\n", program_name);
+        return 1;
+    }
+    
+    if (find_dups) {
+        if (!algorithm_given) {
+            set_algorithm(CHECKSUM_BLAKE3);
+        }
+        return checksum_find_dups(argv + optind, (size_t)(argc - optind), link_mode, quiet);
+    }
+    
+    if (crc_variant) {
+        if (algorithm_given || recursive || tree || block_size || compare_map || cdc_mode) {
+            fprintf(stderr, "%s: --crc cannot be combined with other algorithms or modes\n",
+                    program_name);
+            return 1;
+        }
+        return checksum_crc_files(crc_variant, argv + optind, (size_t)(argc - optind), quiet);
+    }
+    
+    if (cdc_mode) {
+        if (!algorithm_given) {
+            set_algorithm(CHECKSUM_XXH3_128);
+        }
+        if (nalgos != 1 || (algos[0] != CHECKSUM_XXH3_64 && algos[0] != CHECKSUM_XXH3_128 &&
+                            algos[0] != CHECKSUM_BLAKE3)) {
+            fprintf(stderr, "%s: --cdc hashes chunks with one of --xxh3, --xxh128 or --blake3\n",
+                    program_name);
+            return 1;
+        }
+        return checksum_cdc_analyze(argv + optind, (size_t)(argc - optind), recursive, &cdc);
+    }
+    
+    if (compare_map || block_size) {
+        if (optind >= argc) {
+            fprintf(stderr, "%s: %s requires a FILE\n", program_name,
+                    compare_map ? "--compare" : "--blocks");
+            return 1;
+        }
+        if (compare_map) {
+            return checksum_compare_blocks(compare_map, argv + optind, (size_t)(argc - optind),
+                                           quiet);
+        }
+        return checksum_block_maps(argv + optind, (size_t)(argc - optind), block_size);
+    }
+    
+    if (recursive || tree) {
+        return checksum_trees(argv + optind, (size_t)(argc - optind), tree, recursive, quiet);
+    }
+    
+    if (optind >= argc) {
+        return checksum_file(NULL, quiet);
+    }
+    
+    if (jobs > 1 && argc - optind > 1) {
+        exit_code = checksum_files_parallel(argv + optind, argc - optind, quiet);
+        if (exit_code >= 0) {
+            return exit_code;
+        }
+        /* Could not start the pool; fall back to hashing serially */
+        exit_code = 0;
+    }
+    
+    for (int i = optind; i < argc; i++) {
+        if (checksum_file(argv[i], quiet) != 0) {
+            exit_code = 1;
+        }
+    }
+    
     return exit_code;
 }
+#endif /* CHECKSUM_LIB_ONLY */
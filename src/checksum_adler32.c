@@ -0,0 +1,277 @@
+/*
+ * checksum_adler32.c - Adler-32 kernels with runtime dispatch
+ *
+ * Copyright (c) 2025 AnmiTaliDev
+ * Created: 2025-08-09
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdatomic.h>
+
+#include "checksum.h"
+#include "checksum_kernels.h"
+
+#if CHECKSUM_HAVE_X86_SIMD
+#include <immintrin.h>
+#endif
+
+/* Largest prime smaller than 65536 */
+#define ADLER32_BASE  65521U
+/* NMAX is the largest n such that 255n(n+1)/2 + (n+1)(BASE-1) <= 2^32-1,
+ * i.e. how many bytes can be summed before the modulo must be taken */
+#define ADLER32_NMAX  5552
+
+typedef uint32_t (*adler32_update_fn)(uint32_t adler, const unsigned char *data, size_t len);
+
+#define DO1(i)  { a += buf[i]; b += a; }
+#define DO4(i)  DO1(i) DO1(i + 1) DO1(i + 2) DO1(i + 3)
+#define DO16    DO4(0) DO4(4) DO4(8) DO4(12)
+
+uint32_t checksum_adler32_raw_scalar(uint32_t adler, const unsigned char *buf, size_t len) {
+    uint32_t a = adler & 0xffff;
+    uint32_t b = adler >> 16;
+
+    while (len >= ADLER32_NMAX) {
+        size_t n = ADLER32_NMAX / 16;
+
+        len -= ADLER32_NMAX;
+        do {
+            DO16;
+            buf += 16;
+        } while (--n);
+        a %= ADLER32_BASE;
+        b %= ADLER32_BASE;
+    }
+
+    /* len < NMAX: at most one deferred reduction left */
+    while (len >= 16) {
+        DO16;
+        buf += 16;
+        len -= 16;
+    }
+    while (len--) {
+        a += *buf++;
+        b += a;
+    }
+    a %= ADLER32_BASE;
+    b %= ADLER32_BASE;
+
+    return (b << 16) | a;
+}
+
+#undef DO1
+#undef DO4
+#undef DO16
+
+#if CHECKSUM_HAVE_X86_SIMD
+/*
+ * Vector kernels process blocks of BLOCK bytes. Per block:
+ *   b += BLOCK * a + sum((BLOCK - i) * buf[i])
+ *   a += sum(buf[i])
+ * The BLOCK * a term is accumulated lazily in v_ps (a summed once per
+ * block) and scaled with a shift at the end of each NMAX-sized run.
+ */
+
+__attribute__((target("ssse3")))
+static inline uint32_t hsum_epi32_128(__m128i v) {
+    v = _mm_add_epi32(v, _mm_shuffle_epi32(v, _MM_SHUFFLE(2, 3, 0, 1)));
+    v = _mm_add_epi32(v, _mm_shuffle_epi32(v, _MM_SHUFFLE(1, 0, 3, 2)));
+    return (uint32_t)_mm_cvtsi128_si32(v);
+}
+
+__attribute__((target("ssse3")))
+uint32_t checksum_adler32_raw_ssse3(uint32_t adler, const unsigned char *buf, size_t len) {
+    const size_t block = 32;
+    uint32_t a = adler & 0xffff;
+    uint32_t b = adler >> 16;
+    size_t blocks = len / block;
+
+    const __m128i tap1 = _mm_setr_epi8(32, 31, 30, 29, 28, 27, 26, 25,
+                                       24, 23, 22, 21, 20, 19, 18, 17);
+    const __m128i tap2 = _mm_setr_epi8(16, 15, 14, 13, 12, 11, 10, 9,
+                                       8, 7, 6, 5, 4, 3, 2, 1);
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i ones = _mm_set1_epi16(1);
+
+    len -= blocks * block;
+
+    while (blocks) {
+        size_t n = ADLER32_NMAX / block;
+        __m128i v_ps, v_s1, v_s2;
+
+        if (n > blocks) {
+            n = blocks;
+        }
+        blocks -= n;
+
+        v_ps = _mm_set_epi32(0, 0, 0, (int)(a * n));
+        v_s2 = _mm_set_epi32(0, 0, 0, (int)b);
+        v_s1 = _mm_setzero_si128();
+
+        do {
+            const __m128i bytes1 = _mm_loadu_si128((const __m128i *)buf);
+            const __m128i bytes2 = _mm_loadu_si128((const __m128i *)(buf + 16));
+
+            v_ps = _mm_add_epi32(v_ps, v_s1);
+            v_s1 = _mm_add_epi32(v_s1, _mm_sad_epu8(bytes1, zero));
+            v_s2 = _mm_add_epi32(v_s2, _mm_madd_epi16(_mm_maddubs_epi16(bytes1, tap1), ones));
+            v_s1 = _mm_add_epi32(v_s1, _mm_sad_epu8(bytes2, zero));
+            v_s2 = _mm_add_epi32(v_s2, _mm_madd_epi16(_mm_maddubs_epi16(bytes2, tap2), ones));
+            buf += block;
+        } while (--n);
+
+        v_s2 = _mm_add_epi32(v_s2, _mm_slli_epi32(v_ps, 5));
+
+        a = (a + hsum_epi32_128(v_s1)) % ADLER32_BASE;
+        b = hsum_epi32_128(v_s2) % ADLER32_BASE;
+    }
+
+    return checksum_adler32_raw_scalar((b << 16) | a, buf, len);
+}
+
+__attribute__((target("avx2")))
+static inline uint32_t hsum_epi32_256(__m256i v) {
+    __m128i x = _mm_add_epi32(_mm256_castsi256_si128(v), _mm256_extracti128_si256(v, 1));
+
+    x = _mm_add_epi32(x, _mm_shuffle_epi32(x, _MM_SHUFFLE(2, 3, 0, 1)));
+    x = _mm_add_epi32(x, _mm_shuffle_epi32(x, _MM_SHUFFLE(1, 0, 3, 2)));
+    return (uint32_t)_mm_cvtsi128_si32(x);
+}
+
+__attribute__((target("avx2")))
+uint32_t checksum_adler32_raw_avx2(uint32_t adler, const unsigned char *buf, size_t len) {
+    const size_t block = 64;
+    uint32_t a = adler & 0xffff;
+    uint32_t b = adler >> 16;
+    size_t blocks = len / block;
+
+    const __m256i tap1 = _mm256_setr_epi8(64, 63, 62, 61, 60, 59, 58, 57,
+                                          56, 55, 54, 53, 52, 51, 50, 49,
+                                          48, 47, 46, 45, 44, 43, 42, 41,
+                                          40, 39, 38, 37, 36, 35, 34, 33);
+    const __m256i tap2 = _mm256_setr_epi8(32, 31, 30, 29, 28, 27, 26, 25,
+                                          24, 23, 22, 21, 20, 19, 18, 17,
+                                          16, 15, 14, 13, 12, 11, 10, 9,
+                                          8, 7, 6, 5, 4, 3, 2, 1);
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i ones = _mm256_set1_epi16(1);
+
+    len -= blocks * block;
+
+    while (blocks) {
+        size_t n = ADLER32_NMAX / block;
+        __m256i v_ps, v_s1, v_s2a, v_s2b;
+
+        if (n > blocks) {
+            n = blocks;
+        }
+        blocks -= n;
+
+        v_ps = _mm256_set_epi32(0, 0, 0, 0, 0, 0, 0, (int)(a * n));
+        v_s2a = _mm256_set_epi32(0, 0, 0, 0, 0, 0, 0, (int)b);
+        v_s2b = _mm256_setzero_si256();
+        v_s1 = _mm256_setzero_si256();
+
+        do {
+            const __m256i bytes1 = _mm256_loadu_si256((const __m256i *)buf);
+            const __m256i bytes2 = _mm256_loadu_si256((const __m256i *)(buf + 32));
+
+            v_ps = _mm256_add_epi32(v_ps, v_s1);
+            v_s1 = _mm256_add_epi32(v_s1, _mm256_sad_epu8(bytes1, zero));
+            v_s2a = _mm256_add_epi32(v_s2a,
+                                     _mm256_madd_epi16(_mm256_maddubs_epi16(bytes1, tap1), ones));
+            v_s1 = _mm256_add_epi32(v_s1, _mm256_sad_epu8(bytes2, zero));
+            v_s2b = _mm256_add_epi32(v_s2b,
+                                     _mm256_madd_epi16(_mm256_maddubs_epi16(bytes2, tap2), ones));
+            buf += block;
+        } while (--n);
+
+        v_s2a = _mm256_add_epi32(_mm256_add_epi32(v_s2a, v_s2b), _mm256_slli_epi32(v_ps, 6));
+
+        a = (a + hsum_epi32_256(v_s1)) % ADLER32_BASE;
+        b = hsum_epi32_256(v_s2a) % ADLER32_BASE;
+    }
+
+    return checksum_adler32_raw_scalar((b << 16) | a, buf, len);
+}
+#endif /* CHECKSUM_HAVE_X86_SIMD */
+
+static adler32_update_fn adler32_resolve(void) {
+#if CHECKSUM_HAVE_X86_SIMD
+    unsigned int cpu = checksum_cpu_features();
+
+    if (cpu & CHECKSUM_CPU_AVX2) {
+        return checksum_adler32_raw_avx2;
+    }
+    if (cpu & CHECKSUM_CPU_SSSE3) {
+        return checksum_adler32_raw_ssse3;
+    }
+#endif
+    return checksum_adler32_raw_scalar;
+}
+
+uint32_t checksum_adler32_raw(uint32_t adler, const unsigned char *data, size_t len) {
+    static _Atomic(adler32_update_fn) impl;
+    adler32_update_fn fn = atomic_load_explicit(&impl, memory_order_relaxed);
+
+    if (!fn) {
+        fn = adler32_resolve();
+        atomic_store_explicit(&impl, fn, memory_order_relaxed);
+    }
+
+    return fn(adler, data, len);
+}
+
+uint32_t checksum_adler32_combine(uint32_t adler1, uint32_t adler2, uint64_t len2) {
+    uint32_t rem = (uint32_t)(len2 % ADLER32_BASE);
+    uint32_t sum1 = adler1 & 0xffff;
+    uint32_t sum2 = (rem * sum1) % ADLER32_BASE;
+
+    /* a = a1 + a2 - 1, b = b1 + b2 + len2 * a1 - len2 (mod BASE) */
+    sum1 += (adler2 & 0xffff) + ADLER32_BASE - 1;
+    sum2 += (adler1 >> 16) + (adler2 >> 16) + ADLER32_BASE - rem;
+    if (sum1 >= ADLER32_BASE) sum1 -= ADLER32_BASE;
+    if (sum1 >= ADLER32_BASE) sum1 -= ADLER32_BASE;
+    if (sum2 >= (ADLER32_BASE << 1)) sum2 -= (ADLER32_BASE << 1);
+    if (sum2 >= ADLER32_BASE) sum2 -= ADLER32_BASE;
+
+    return (sum2 << 16) | sum1;
+}
+
+uint32_t checksum_adler32_raw_zeros(uint32_t adler, uint64_t len) {
+    uint32_t a = adler & 0xffff;
+    uint32_t b = adler >> 16;
+
+    b = (uint32_t)((b + (len % ADLER32_BASE) * a) % ADLER32_BASE);
+    return (b << 16) | a;
+}
+
+uint32_t checksum_adler32_roll(uint32_t adler, unsigned char out, unsigned char in, size_t window) {
+    uint32_t a = adler & 0xffff;
+    uint32_t b = adler >> 16;
+    uint32_t drop = (uint32_t)((window % ADLER32_BASE) * out % ADLER32_BASE);
+
+    /* a' = a - out + in, b' = b - window * out + a' - 1 (mod BASE) */
+    a = (a + ADLER32_BASE - out + in) % ADLER32_BASE;
+    b = (b + a + 2 * ADLER32_BASE - 1 - drop) % ADLER32_BASE;
+
+    return (b << 16) | a;
+}
+
+uint32_t checksum_adler32(const unsigned char *data, size_t len) {
+    return checksum_adler32_raw(1, data, len);
+}
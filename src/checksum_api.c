@@ -0,0 +1,559 @@
+/*
+ * checksum_api.c - Streaming and one-shot checksum API
+ *
+ * Copyright (c) 2025 AnmiTaliDev
+ * Created: 2025-08-09
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "checksum.h"
+#include "checksum_kernels.h"
+
+/* Buffer for checksum_file_stream() reads */
+#define STREAM_BUF_SIZE (64 * 1024)
+
+/* Error messages */
+static const char *error_messages[] = {
+    [0] = "Success",
+    [-CHECKSUM_ERROR_IO] = "I/O error",
+    [-CHECKSUM_ERROR_MEM] = "Memory allocation failed",
+    [-CHECKSUM_ERROR_ARG] = "Invalid argument",
+    [-CHECKSUM_ERROR_DATA] = "Malformed or mismatched data"
+};
+
+const char *checksum_strerror(int error) {
+    error = -error;
+    if (error < 0 || error >= (int)(sizeof(error_messages) / sizeof(error_messages[0]))) {
+        return "Unknown error";
+    }
+    return error_messages[error];
+}
+
+const char *checksum_name(checksum_type_t type) {
+    switch (type) {
+        case CHECKSUM_CRC32: return "CRC32";
+        case CHECKSUM_ADLER32: return "ADLER32";
+        case CHECKSUM_BSD_SUM: return "BSD";
+        case CHECKSUM_CRC32C: return "CRC32C";
+        case CHECKSUM_SHA256: return "SHA256";
+        case CHECKSUM_SHA1: return "SHA1";
+        case CHECKSUM_BLAKE3: return "BLAKE3";
+        case CHECKSUM_XXH64: return "XXH64";
+        case CHECKSUM_XXH3_64: return "XXH3";
+        case CHECKSUM_XXH3_128: return "XXH128";
+        default: return "UNKNOWN";
+    }
+}
+
+size_t checksum_digest_size(checksum_type_t type) {
+    switch (type) {
+        case CHECKSUM_CRC32:
+        case CHECKSUM_CRC32C:
+        case CHECKSUM_ADLER32:
+        case CHECKSUM_BSD_SUM:
+            return 4;
+        case CHECKSUM_SHA256:
+            return CHECKSUM_SHA256_DIGEST;
+        case CHECKSUM_SHA1:
+            return CHECKSUM_SHA1_DIGEST;
+        case CHECKSUM_BLAKE3:
+            return CHECKSUM_BLAKE3_DIGEST;
+        case CHECKSUM_XXH64:
+            return CHECKSUM_XXH64_DIGEST;
+        case CHECKSUM_XXH3_64:
+            return CHECKSUM_XXH3_DIGEST;
+        case CHECKSUM_XXH3_128:
+            return CHECKSUM_XXH128_DIGEST;
+        default:
+            return 0;
+    }
+}
+
+/* ASCII case-insensitive equality, independent of the locale */
+static int name_equal(const char *a, const char *b) {
+    for (;; a++, b++) {
+        int ca = (*a >= 'A' && *a <= 'Z') ? *a - 'A' + 'a' : *a;
+        int cb = (*b >= 'A' && *b <= 'Z') ? *b - 'A' + 'a' : *b;
+
+        if (ca != cb) {
+            return 0;
+        }
+        if (ca == '\0') {
+            return 1;
+        }
+    }
+}
+
+int checksum_type_from_name(const char *name, checksum_type_t *type) {
+    static const struct {
+        const char *name;
+        checksum_type_t type;
+    } names[] = {
+        {"crc32", CHECKSUM_CRC32},
+        {"crc32c", CHECKSUM_CRC32C},
+        {"adler32", CHECKSUM_ADLER32},
+        {"adler-32", CHECKSUM_ADLER32},
+        {"sum", CHECKSUM_BSD_SUM},
+        {"bsd", CHECKSUM_BSD_SUM},
+        {"sha256", CHECKSUM_SHA256},
+        {"sha-256", CHECKSUM_SHA256},
+        {"sha1", CHECKSUM_SHA1},
+        {"sha-1", CHECKSUM_SHA1},
+        {"blake3", CHECKSUM_BLAKE3},
+        {"xxh64", CHECKSUM_XXH64},
+        {"xxh3", CHECKSUM_XXH3_64},
+        {"xxh3-64", CHECKSUM_XXH3_64},
+        {"xxh128", CHECKSUM_XXH3_128},
+        {"xxh3-128", CHECKSUM_XXH3_128},
+    };
+
+    if (!name || !type) {
+        return CHECKSUM_ERROR_ARG;
+    }
+
+    for (size_t i = 0; i < sizeof(names) / sizeof(names[0]); i++) {
+        if (name_equal(name, names[i].name)) {
+            *type = names[i].type;
+            return CHECKSUM_SUCCESS;
+        }
+    }
+    return CHECKSUM_ERROR_ARG;
+}
+
+/* CRC32 */
+
+void checksum_crc32_init(checksum_crc32_ctx_t *ctx) {
+    ctx->crc = 0xffffffffU;
+}
+
+void checksum_crc32_update(checksum_crc32_ctx_t *ctx, const void *data, size_t len) {
+    ctx->crc = checksum_crc32_raw(ctx->crc, data, len);
+}
+
+uint32_t checksum_crc32_final(const checksum_crc32_ctx_t *ctx) {
+    return ctx->crc ^ 0xffffffffU;
+}
+
+/* CRC32C */
+
+void checksum_crc32c_init(checksum_crc32c_ctx_t *ctx) {
+    ctx->crc = 0xffffffffU;
+}
+
+void checksum_crc32c_update(checksum_crc32c_ctx_t *ctx, const void *data, size_t len) {
+    ctx->crc = checksum_crc32c_raw(ctx->crc, data, len);
+}
+
+uint32_t checksum_crc32c_final(const checksum_crc32c_ctx_t *ctx) {
+    return ctx->crc ^ 0xffffffffU;
+}
+
+/* Adler-32 */
+
+void checksum_adler32_init(checksum_adler32_ctx_t *ctx) {
+    ctx->adler = 1;
+}
+
+void checksum_adler32_update(checksum_adler32_ctx_t *ctx, const void *data, size_t len) {
+    ctx->adler = checksum_adler32_raw(ctx->adler, data, len);
+}
+
+uint32_t checksum_adler32_final(const checksum_adler32_ctx_t *ctx) {
+    return ctx->adler;
+}
+
+/* BSD sum: 16-bit rotating checksum */
+
+void checksum_bsd_sum_init(checksum_bsd_sum_ctx_t *ctx) {
+    ctx->sum = 0;
+}
+
+void checksum_bsd_sum_update(checksum_bsd_sum_ctx_t *ctx, const void *data, size_t len) {
+    const unsigned char *buf = data;
+    uint32_t sum = ctx->sum;
+
+    for (size_t i = 0; i < len; i++) {
+        sum = ((sum >> 1) + ((sum & 1) << 15) + buf[i]) & 0xffff;
+    }
+    ctx->sum = sum;
+}
+
+uint32_t checksum_bsd_sum_final(const checksum_bsd_sum_ctx_t *ctx) {
+    return ctx->sum;
+}
+
+uint32_t checksum_bsd_sum(const unsigned char *data, size_t len) {
+    checksum_bsd_sum_ctx_t ctx;
+
+    checksum_bsd_sum_init(&ctx);
+    checksum_bsd_sum_update(&ctx, data, len);
+    return checksum_bsd_sum_final(&ctx);
+}
+
+/* SHA-256 and SHA-1: Merkle-Damgard over 64-byte blocks */
+
+typedef void (*block_fn)(uint32_t *state, const unsigned char *data, size_t blocks);
+
+/* Buffer input into whole blocks; `block` holds length % 64 pending bytes */
+static void block_update(uint32_t *state, unsigned char *block, uint64_t *length,
+                         block_fn compress, const unsigned char *data, size_t len) {
+    size_t used = (size_t)(*length % 64);
+
+    *length += len;
+
+    if (used) {
+        size_t take = 64 - used < len ? 64 - used : len;
+
+        memcpy(block + used, data, take);
+        data += take;
+        len -= take;
+        if (used + take < 64) {
+            return;
+        }
+        compress(state, block, 1);
+    }
+
+    if (len >= 64) {
+        compress(state, data, len / 64);
+        data += len & ~(size_t)63;
+        len &= 63;
+    }
+    memcpy(block, data, len);
+}
+
+/* Pad a copy of the state and write `words` big-endian state words */
+static void block_final(const uint32_t *state, const unsigned char *block, uint64_t length,
+                        block_fn compress, size_t words, unsigned char *digest) {
+    unsigned char tail[128];
+    uint32_t out[8];
+    size_t used = (size_t)(length % 64);
+    size_t padded = used < 56 ? 64 : 128;
+    uint64_t bits = length * 8;
+
+    memcpy(out, state, words * sizeof(*out));
+    memcpy(tail, block, used);
+    tail[used] = 0x80;
+    memset(tail + used + 1, 0, padded - used - 1);
+    for (int i = 0; i < 8; i++) {
+        tail[padded - 1 - i] = (unsigned char)(bits >> (8 * i));
+    }
+    compress(out, tail, padded / 64);
+
+    for (size_t i = 0; i < words; i++) {
+        digest[4 * i] = (unsigned char)(out[i] >> 24);
+        digest[4 * i + 1] = (unsigned char)(out[i] >> 16);
+        digest[4 * i + 2] = (unsigned char)(out[i] >> 8);
+        digest[4 * i + 3] = (unsigned char)out[i];
+    }
+}
+
+void checksum_sha256_init(checksum_sha256_ctx_t *ctx) {
+    static const uint32_t iv[8] = {
+        0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a,
+        0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19
+    };
+
+    memcpy(ctx->state, iv, sizeof(iv));
+    ctx->length = 0;
+}
+
+void checksum_sha256_update(checksum_sha256_ctx_t *ctx, const void *data, size_t len) {
+    block_update(ctx->state, ctx->block, &ctx->length, checksum_sha256_blocks, data, len);
+}
+
+void checksum_sha256_final(const checksum_sha256_ctx_t *ctx,
+                           unsigned char digest[CHECKSUM_SHA256_DIGEST]) {
+    block_final(ctx->state, ctx->block, ctx->length, checksum_sha256_blocks, 8, digest);
+}
+
+void checksum_sha256(const unsigned char *data, size_t len,
+                     unsigned char digest[CHECKSUM_SHA256_DIGEST]) {
+    checksum_sha256_ctx_t ctx;
+
+    checksum_sha256_init(&ctx);
+    checksum_sha256_update(&ctx, data, len);
+    checksum_sha256_final(&ctx, digest);
+}
+
+void checksum_sha1_init(checksum_sha1_ctx_t *ctx) {
+    static const uint32_t iv[5] = {
+        0x67452301, 0xefcdab89, 0x98badcfe, 0x10325476, 0xc3d2e1f0
+    };
+
+    memcpy(ctx->state, iv, sizeof(iv));
+    ctx->length = 0;
+}
+
+void checksum_sha1_update(checksum_sha1_ctx_t *ctx, const void *data, size_t len) {
+    block_update(ctx->state, ctx->block, &ctx->length, checksum_sha1_blocks, data, len);
+}
+
+void checksum_sha1_final(const checksum_sha1_ctx_t *ctx, unsigned char digest[CHECKSUM_SHA1_DIGEST]) {
+    block_final(ctx->state, ctx->block, ctx->length, checksum_sha1_blocks, 5, digest);
+}
+
+void checksum_sha1(const unsigned char *data, size_t len, unsigned char digest[CHECKSUM_SHA1_DIGEST]) {
+    checksum_sha1_ctx_t ctx;
+
+    checksum_sha1_init(&ctx);
+    checksum_sha1_update(&ctx, data, len);
+    checksum_sha1_final(&ctx, digest);
+}
+
+/* Generic dispatch */
+
+/* Results of the 32-bit checksums carry the value as a 4-byte digest too */
+static void set_value(checksum_result_t *result, uint32_t value) {
+    result->value = value;
+    result->digest_len = 4;
+    result->digest[0] = (unsigned char)(value >> 24);
+    result->digest[1] = (unsigned char)(value >> 16);
+    result->digest[2] = (unsigned char)(value >> 8);
+    result->digest[3] = (unsigned char)value;
+}
+
+/* 64-bit hashes are stored big-endian, the canonical xxHash form */
+static void set_value64(checksum_result_t *result, uint64_t value) {
+    for (int i = 0; i < 8; i++) {
+        result->digest[i] = (unsigned char)(value >> (56 - 8 * i));
+    }
+    result->digest_len = 8;
+    result->value = (uint32_t)(value >> 32);
+}
+
+/* Wide digests expose their leading 32 bits as the value */
+static void set_digest_len(checksum_result_t *result, size_t len) {
+    result->digest_len = len;
+    result->value = ((uint32_t)result->digest[0] << 24) | ((uint32_t)result->digest[1] << 16) |
+                    ((uint32_t)result->digest[2] << 8) | result->digest[3];
+}
+
+int checksum_init(checksum_ctx_t *ctx, checksum_type_t type) {
+    if (!ctx) {
+        return CHECKSUM_ERROR_ARG;
+    }
+
+    memset(ctx, 0, sizeof(*ctx));
+    ctx->type = type;
+
+    switch (type) {
+        case CHECKSUM_CRC32:
+            checksum_crc32_init(&ctx->u.crc32);
+            break;
+        case CHECKSUM_CRC32C:
+            checksum_crc32c_init(&ctx->u.crc32c);
+            break;
+        case CHECKSUM_ADLER32:
+            checksum_adler32_init(&ctx->u.adler32);
+            break;
+        case CHECKSUM_BSD_SUM:
+            checksum_bsd_sum_init(&ctx->u.bsd_sum);
+            break;
+        case CHECKSUM_SHA256:
+            checksum_sha256_init(&ctx->u.sha256);
+            break;
+        case CHECKSUM_SHA1:
+            checksum_sha1_init(&ctx->u.sha1);
+            break;
+        case CHECKSUM_BLAKE3:
+            checksum_blake3_init(&ctx->u.blake3);
+            break;
+        case CHECKSUM_XXH64:
+            checksum_xxh64_init(&ctx->u.xxh64);
+            break;
+        case CHECKSUM_XXH3_64:
+        case CHECKSUM_XXH3_128:
+            checksum_xxh3_init(&ctx->u.xxh3);
+            break;
+        default:
+            return CHECKSUM_ERROR_ARG;
+    }
+
+    return CHECKSUM_SUCCESS;
+}
+
+void checksum_update(checksum_ctx_t *ctx, const void *data, size_t len) {
+    switch (ctx->type) {
+        case CHECKSUM_CRC32:
+            checksum_crc32_update(&ctx->u.crc32, data, len);
+            break;
+        case CHECKSUM_CRC32C:
+            checksum_crc32c_update(&ctx->u.crc32c, data, len);
+            break;
+        case CHECKSUM_ADLER32:
+            checksum_adler32_update(&ctx->u.adler32, data, len);
+            break;
+        case CHECKSUM_BSD_SUM:
+            checksum_bsd_sum_update(&ctx->u.bsd_sum, data, len);
+            break;
+        case CHECKSUM_SHA256:
+            checksum_sha256_update(&ctx->u.sha256, data, len);
+            break;
+        case CHECKSUM_SHA1:
+            checksum_sha1_update(&ctx->u.sha1, data, len);
+            break;
+        case CHECKSUM_BLAKE3:
+            checksum_blake3_update(&ctx->u.blake3, data, len);
+            break;
+        case CHECKSUM_XXH64:
+            checksum_xxh64_update(&ctx->u.xxh64, data, len);
+            break;
+        case CHECKSUM_XXH3_64:
+        case CHECKSUM_XXH3_128:
+            checksum_xxh3_update(&ctx->u.xxh3, data, len);
+            break;
+    }
+    ctx->bytes += len;
+}
+
+void checksum_update_zeros(checksum_ctx_t *ctx, uint64_t len) {
+    static const unsigned char zeros[4096];
+
+    switch (ctx->type) {
+        case CHECKSUM_CRC32:
+            ctx->u.crc32.crc = checksum_crc32_raw_zeros(ctx->u.crc32.crc, len);
+            break;
+        case CHECKSUM_CRC32C:
+            ctx->u.crc32c.crc = checksum_crc32c_raw_zeros(ctx->u.crc32c.crc, len);
+            break;
+        case CHECKSUM_ADLER32:
+            ctx->u.adler32.adler = checksum_adler32_raw_zeros(ctx->u.adler32.adler, len);
+            break;
+        case CHECKSUM_BSD_SUM: {
+            /* Each zero byte only rotates the 16-bit sum right by one */
+            unsigned int r = (unsigned int)(len % 16);
+            uint32_t sum = ctx->u.bsd_sum.sum;
+
+            ctx->u.bsd_sum.sum = r ? ((sum >> r) | (sum << (16 - r))) & 0xffff : sum;
+            break;
+        }
+        default:
+            for (uint64_t left = len; left > 0;) {
+                size_t n = left < sizeof(zeros) ? (size_t)left : sizeof(zeros);
+
+                checksum_update(ctx, zeros, n);
+                left -= n;
+            }
+            return;     /* checksum_update() counted the bytes */
+    }
+    ctx->bytes += len;
+}
+
+void checksum_update_parallel(checksum_ctx_t *ctx, const void *data, size_t len,
+                              unsigned int threads) {
+    if (ctx->type != CHECKSUM_BLAKE3) {
+        checksum_update(ctx, data, len);
+        return;
+    }
+    checksum_blake3_update_parallel(&ctx->u.blake3, data, len, threads);
+    ctx->bytes += len;
+}
+
+void checksum_final(const checksum_ctx_t *ctx, checksum_result_t *result) {
+    result->type = ctx->type;
+    result->bytes_processed = (size_t)ctx->bytes;
+
+    switch (ctx->type) {
+        case CHECKSUM_CRC32:
+            set_value(result, checksum_crc32_final(&ctx->u.crc32));
+            break;
+        case CHECKSUM_CRC32C:
+            set_value(result, checksum_crc32c_final(&ctx->u.crc32c));
+            break;
+        case CHECKSUM_ADLER32:
+            set_value(result, checksum_adler32_final(&ctx->u.adler32));
+            break;
+        case CHECKSUM_BSD_SUM:
+            set_value(result, checksum_bsd_sum_final(&ctx->u.bsd_sum));
+            break;
+        case CHECKSUM_SHA256:
+            checksum_sha256_final(&ctx->u.sha256, result->digest);
+            set_digest_len(result, CHECKSUM_SHA256_DIGEST);
+            break;
+        case CHECKSUM_SHA1:
+            checksum_sha1_final(&ctx->u.sha1, result->digest);
+            set_digest_len(result, CHECKSUM_SHA1_DIGEST);
+            break;
+        case CHECKSUM_BLAKE3:
+            checksum_blake3_final(&ctx->u.blake3, result->digest);
+            set_digest_len(result, CHECKSUM_BLAKE3_DIGEST);
+            break;
+        case CHECKSUM_XXH64:
+            set_value64(result, checksum_xxh64_final(&ctx->u.xxh64));
+            break;
+        case CHECKSUM_XXH3_64:
+            set_value64(result, checksum_xxh3_64_final(&ctx->u.xxh3));
+            break;
+        case CHECKSUM_XXH3_128:
+            checksum_xxh3_128_final(&ctx->u.xxh3, result->digest);
+            set_digest_len(result, CHECKSUM_XXH128_DIGEST);
+            break;
+        default:
+            set_value(result, 0);
+            break;
+    }
+}
+
+int checksum_buffers(checksum_type_t type, const struct iovec *iov, size_t iovcnt,
+                     checksum_result_t *result) {
+    checksum_ctx_t ctx;
+    int err;
+
+    if (!result || (iovcnt > 0 && !iov)) {
+        return CHECKSUM_ERROR_ARG;
+    }
+
+    err = checksum_init(&ctx, type);
+    if (err != CHECKSUM_SUCCESS) {
+        return err;
+    }
+
+    for (size_t i = 0; i < iovcnt; i++) {
+        checksum_update(&ctx, iov[i].iov_base, iov[i].iov_len);
+    }
+
+    checksum_final(&ctx, result);
+    return CHECKSUM_SUCCESS;
+}
+
+int checksum_file_stream(FILE *stream, checksum_type_t type, checksum_result_t *result) {
+    unsigned char buffer[STREAM_BUF_SIZE];
+    checksum_ctx_t ctx;
+    size_t bytes_read;
+    int err;
+
+    if (!stream || !result) {
+        return CHECKSUM_ERROR_ARG;
+    }
+
+    err = checksum_init(&ctx, type);
+    if (err != CHECKSUM_SUCCESS) {
+        return err;
+    }
+
+    while ((bytes_read = fread(buffer, 1, sizeof(buffer), stream)) > 0) {
+        checksum_update(&ctx, buffer, bytes_read);
+    }
+
+    if (ferror(stream)) {
+        return CHECKSUM_ERROR_IO;
+    }
+
+    checksum_final(&ctx, result);
+    return CHECKSUM_SUCCESS;
+}
@@ -0,0 +1,790 @@
+/*
+ * checksum_blake3.c - BLAKE3 hashing with SIMD and multithreaded subtrees
+ *
+ * Copyright (c) 2025 AnmiTaliDev
+ * Created: 2025-08-09
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <stdatomic.h>
+#include <pthread.h>
+
+#include "checksum.h"
+#include "checksum_kernels.h"
+
+#if CHECKSUM_HAVE_X86_SIMD
+#include <immintrin.h>
+#endif
+
+#define BLAKE3_BLOCK_LEN   64
+#define BLAKE3_CHUNK_LEN   1024
+#define BLAKE3_OUT_LEN     32
+
+#define BLAKE3_CHUNK_START  (1 << 0)
+#define BLAKE3_CHUNK_END    (1 << 1)
+#define BLAKE3_PARENT       (1 << 2)
+#define BLAKE3_ROOT         (1 << 3)
+
+/* Widest hash_many kernel, in inputs per call */
+#define BLAKE3_MAX_SIMD_DEGREE  16
+/* Subtrees smaller than this are not worth a thread of their own */
+#define BLAKE3_THREAD_MIN       (1024 * 1024)
+
+static const uint32_t blake3_iv[8] = {
+    0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a,
+    0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19
+};
+
+/* Message word order for each of the seven rounds */
+static const uint8_t blake3_schedule[7][16] = {
+    {0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15},
+    {2, 6, 3, 10, 7, 0, 4, 13, 1, 11, 12, 5, 9, 14, 15, 8},
+    {3, 4, 10, 12, 13, 2, 7, 14, 6, 5, 9, 0, 11, 15, 8, 1},
+    {10, 7, 12, 9, 14, 3, 13, 15, 4, 0, 11, 2, 5, 8, 1, 6},
+    {12, 13, 9, 11, 15, 10, 14, 8, 7, 2, 5, 3, 0, 1, 6, 4},
+    {9, 14, 11, 5, 8, 12, 15, 1, 13, 3, 0, 10, 2, 6, 4, 7},
+    {11, 15, 5, 0, 1, 9, 8, 6, 14, 10, 2, 12, 3, 4, 7, 13}
+};
+
+typedef void (*blake3_hash_many_fn)(const unsigned char *const *inputs, size_t num_inputs,
+                                    size_t blocks, const uint32_t key[8], uint64_t counter,
+                                    int increment, uint8_t flags, uint8_t flags_start,
+                                    uint8_t flags_end, unsigned char *out);
+
+typedef struct {
+    blake3_hash_many_fn hash_many;
+    size_t degree;      /* inputs hashed side by side */
+} blake3_impl_t;
+
+static inline uint32_t load_le32(const unsigned char *p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static inline void store_le32(unsigned char *p, uint32_t v) {
+    p[0] = (unsigned char)v;
+    p[1] = (unsigned char)(v >> 8);
+    p[2] = (unsigned char)(v >> 16);
+    p[3] = (unsigned char)(v >> 24);
+}
+
+static inline uint32_t rotr32(uint32_t x, int n) {
+    return (x >> n) | (x << (32 - n));
+}
+
+/* Portable compression function */
+
+#define G(a, b, c, d, x, y) do { \
+    a = a + b + (x); d = rotr32(d ^ a, 16); c = c + d; b = rotr32(b ^ c, 12); \
+    a = a + b + (y); d = rotr32(d ^ a, 8);  c = c + d; b = rotr32(b ^ c, 7); \
+} while (0)
+
+static void compress_in_place(uint32_t cv[8], const unsigned char block[BLAKE3_BLOCK_LEN],
+                              uint8_t block_len, uint64_t counter, uint8_t flags) {
+    uint32_t m[16], v[16];
+
+    for (int i = 0; i < 16; i++) {
+        m[i] = load_le32(block + 4 * i);
+    }
+    for (int i = 0; i < 8; i++) {
+        v[i] = cv[i];
+    }
+    v[8] = blake3_iv[0];
+    v[9] = blake3_iv[1];
+    v[10] = blake3_iv[2];
+    v[11] = blake3_iv[3];
+    v[12] = (uint32_t)counter;
+    v[13] = (uint32_t)(counter >> 32);
+    v[14] = block_len;
+    v[15] = flags;
+
+    for (int r = 0; r < 7; r++) {
+        const uint8_t *s = blake3_schedule[r];
+
+        G(v[0], v[4], v[8], v[12], m[s[0]], m[s[1]]);
+        G(v[1], v[5], v[9], v[13], m[s[2]], m[s[3]]);
+        G(v[2], v[6], v[10], v[14], m[s[4]], m[s[5]]);
+        G(v[3], v[7], v[11], v[15], m[s[6]], m[s[7]]);
+        G(v[0], v[5], v[10], v[15], m[s[8]], m[s[9]]);
+        G(v[1], v[6], v[11], v[12], m[s[10]], m[s[11]]);
+        G(v[2], v[7], v[8], v[13], m[s[12]], m[s[13]]);
+        G(v[3], v[4], v[9], v[14], m[s[14]], m[s[15]]);
+    }
+
+    for (int i = 0; i < 8; i++) {
+        cv[i] = v[i] ^ v[i + 8];
+    }
+}
+
+#undef G
+
+void checksum_blake3_hash_many_portable(const unsigned char *const *inputs, size_t num_inputs,
+                                        size_t blocks, const uint32_t key[8], uint64_t counter,
+                                        int increment, uint8_t flags, uint8_t flags_start,
+                                        uint8_t flags_end, unsigned char *out) {
+    for (size_t n = 0; n < num_inputs; n++) {
+        uint32_t cv[8];
+        uint8_t block_flags = flags | flags_start;
+
+        memcpy(cv, key, sizeof(cv));
+        for (size_t b = 0; b < blocks; b++) {
+            if (b + 1 == blocks) {
+                block_flags |= flags_end;
+            }
+            compress_in_place(cv, inputs[n] + b * BLAKE3_BLOCK_LEN, BLAKE3_BLOCK_LEN, counter,
+                              block_flags);
+            block_flags = flags;
+        }
+        for (int i = 0; i < 8; i++) {
+            store_le32(out + n * BLAKE3_OUT_LEN + 4 * i, cv[i]);
+        }
+        if (increment) {
+            counter++;
+        }
+    }
+}
+
+#if CHECKSUM_HAVE_X86_SIMD
+#define B3_CAT_(a, b)   a##_##b
+#define B3_CAT(a, b)    B3_CAT_(a, b)
+#define B3_FN(name)     B3_CAT(name, B3_SUFFIX)
+
+/* SSE4.1: four inputs per call */
+
+__attribute__((target("sse4.1")))
+static inline void load_msg_sse41(const unsigned char *const *inputs, size_t offset, __m128i m[16]) {
+    for (int g = 0; g < 4; g++) {
+        __m128i a = _mm_loadu_si128((const __m128i *)(inputs[0] + offset + 16 * g));
+        __m128i b = _mm_loadu_si128((const __m128i *)(inputs[1] + offset + 16 * g));
+        __m128i c = _mm_loadu_si128((const __m128i *)(inputs[2] + offset + 16 * g));
+        __m128i d = _mm_loadu_si128((const __m128i *)(inputs[3] + offset + 16 * g));
+        __m128i t0 = _mm_unpacklo_epi32(a, b), t1 = _mm_unpackhi_epi32(a, b);
+        __m128i t2 = _mm_unpacklo_epi32(c, d), t3 = _mm_unpackhi_epi32(c, d);
+
+        m[4 * g + 0] = _mm_unpacklo_epi64(t0, t2);
+        m[4 * g + 1] = _mm_unpackhi_epi64(t0, t2);
+        m[4 * g + 2] = _mm_unpacklo_epi64(t1, t3);
+        m[4 * g + 3] = _mm_unpackhi_epi64(t1, t3);
+    }
+}
+
+#define B3_V            __m128i
+#define B3_LANES        4
+#define B3_SUFFIX       sse41
+#define B3_TARGET       __attribute__((target("sse4.1")))
+#define B3_ADD          _mm_add_epi32
+#define B3_XOR          _mm_xor_si128
+#define B3_SET1(x)      _mm_set1_epi32((int)(x))
+#define B3_LOADU(p)     _mm_loadu_si128((const __m128i *)(p))
+#define B3_STOREU(p, x) _mm_storeu_si128((__m128i *)(p), x)
+#define B3_ROT16(x)     _mm_shuffle_epi8(x, _mm_setr_epi8(2, 3, 0, 1, 6, 7, 4, 5, 10, 11, 8, 9, 14, 15, 12, 13))
+#define B3_ROT12(x)     _mm_or_si128(_mm_srli_epi32(x, 12), _mm_slli_epi32(x, 20))
+#define B3_ROT8(x)      _mm_shuffle_epi8(x, _mm_setr_epi8(1, 2, 3, 0, 5, 6, 7, 4, 9, 10, 11, 8, 13, 14, 15, 12))
+#define B3_ROT7(x)      _mm_or_si128(_mm_srli_epi32(x, 7), _mm_slli_epi32(x, 25))
+#define B3_FALLBACK     checksum_blake3_hash_many_portable
+#include "checksum_blake3_lanes.h"
+#undef B3_V
+#undef B3_LANES
+#undef B3_SUFFIX
+#undef B3_TARGET
+#undef B3_ADD
+#undef B3_XOR
+#undef B3_SET1
+#undef B3_LOADU
+#undef B3_STOREU
+#undef B3_ROT16
+#undef B3_ROT12
+#undef B3_ROT8
+#undef B3_ROT7
+#undef B3_FALLBACK
+
+/* AVX2: eight inputs per call */
+
+__attribute__((target("avx2")))
+static inline void load_msg_avx2(const unsigned char *const *inputs, size_t offset, __m256i m[16]) {
+    for (int half = 0; half < 2; half++) {
+        __m256i v[8], t[8], u[8];
+
+        for (int j = 0; j < 8; j++) {
+            v[j] = _mm256_loadu_si256((const __m256i *)(inputs[j] + offset + 32 * half));
+        }
+        for (int j = 0; j < 8; j += 2) {
+            t[j] = _mm256_unpacklo_epi32(v[j], v[j + 1]);
+            t[j + 1] = _mm256_unpackhi_epi32(v[j], v[j + 1]);
+        }
+        for (int j = 0; j < 8; j += 4) {
+            u[j + 0] = _mm256_unpacklo_epi64(t[j], t[j + 2]);
+            u[j + 1] = _mm256_unpackhi_epi64(t[j], t[j + 2]);
+            u[j + 2] = _mm256_unpacklo_epi64(t[j + 1], t[j + 3]);
+            u[j + 3] = _mm256_unpackhi_epi64(t[j + 1], t[j + 3]);
+        }
+        /* u[k] and u[k + 4] hold words k and k + 4 of lanes 0-3 and 4-7 */
+        for (int k = 0; k < 4; k++) {
+            m[8 * half + k] = _mm256_permute2x128_si256(u[k], u[k + 4], 0x20);
+            m[8 * half + k + 4] = _mm256_permute2x128_si256(u[k], u[k + 4], 0x31);
+        }
+    }
+}
+
+#define B3_V            __m256i
+#define B3_LANES        8
+#define B3_SUFFIX       avx2
+#define B3_TARGET       __attribute__((target("avx2")))
+#define B3_ADD          _mm256_add_epi32
+#define B3_XOR          _mm256_xor_si256
+#define B3_SET1(x)      _mm256_set1_epi32((int)(x))
+#define B3_LOADU(p)     _mm256_loadu_si256((const __m256i *)(p))
+#define B3_STOREU(p, x) _mm256_storeu_si256((__m256i *)(p), x)
+#define B3_ROT16(x)     _mm256_shuffle_epi8(x, _mm256_setr_epi8( \
+                            2, 3, 0, 1, 6, 7, 4, 5, 10, 11, 8, 9, 14, 15, 12, 13, \
+                            2, 3, 0, 1, 6, 7, 4, 5, 10, 11, 8, 9, 14, 15, 12, 13))
+#define B3_ROT12(x)     _mm256_or_si256(_mm256_srli_epi32(x, 12), _mm256_slli_epi32(x, 20))
+#define B3_ROT8(x)      _mm256_shuffle_epi8(x, _mm256_setr_epi8( \
+                            1, 2, 3, 0, 5, 6, 7, 4, 9, 10, 11, 8, 13, 14, 15, 12, \
+                            1, 2, 3, 0, 5, 6, 7, 4, 9, 10, 11, 8, 13, 14, 15, 12))
+#define B3_ROT7(x)      _mm256_or_si256(_mm256_srli_epi32(x, 7), _mm256_slli_epi32(x, 25))
+#define B3_FALLBACK     checksum_blake3_hash_many_sse41
+#include "checksum_blake3_lanes.h"
+#undef B3_V
+#undef B3_LANES
+#undef B3_SUFFIX
+#undef B3_TARGET
+#undef B3_ADD
+#undef B3_XOR
+#undef B3_SET1
+#undef B3_LOADU
+#undef B3_STOREU
+#undef B3_ROT16
+#undef B3_ROT12
+#undef B3_ROT8
+#undef B3_ROT7
+#undef B3_FALLBACK
+
+/* AVX-512: sixteen inputs per call */
+
+__attribute__((target("avx512f")))
+static inline void load_msg_avx512(const unsigned char *const *inputs, size_t offset, __m512i m[16]) {
+    __m512i v[16], t[16], s[16];
+
+    for (int j = 0; j < 16; j++) {
+        v[j] = _mm512_loadu_si512((const void *)(inputs[j] + offset));
+    }
+    for (int j = 0; j < 16; j += 2) {
+        t[j] = _mm512_unpacklo_epi32(v[j], v[j + 1]);
+        t[j + 1] = _mm512_unpackhi_epi32(v[j], v[j + 1]);
+    }
+    /* s[4i + r]: in 128-bit lane q, word 4q + r of inputs 4i..4i+3 */
+    for (int i = 0; i < 16; i += 4) {
+        s[i + 0] = _mm512_unpacklo_epi64(t[i], t[i + 2]);
+        s[i + 1] = _mm512_unpackhi_epi64(t[i], t[i + 2]);
+        s[i + 2] = _mm512_unpacklo_epi64(t[i + 1], t[i + 3]);
+        s[i + 3] = _mm512_unpackhi_epi64(t[i + 1], t[i + 3]);
+    }
+    /* Transpose the 128-bit lanes across the four input groups */
+    for (int r = 0; r < 4; r++) {
+        __m512i a = _mm512_shuffle_i32x4(s[r], s[4 + r], 0x44);
+        __m512i b = _mm512_shuffle_i32x4(s[r], s[4 + r], 0xee);
+        __m512i c = _mm512_shuffle_i32x4(s[8 + r], s[12 + r], 0x44);
+        __m512i d = _mm512_shuffle_i32x4(s[8 + r], s[12 + r], 0xee);
+
+        m[r] = _mm512_shuffle_i32x4(a, c, 0x88);
+        m[4 + r] = _mm512_shuffle_i32x4(a, c, 0xdd);
+        m[8 + r] = _mm512_shuffle_i32x4(b, d, 0x88);
+        m[12 + r] = _mm512_shuffle_i32x4(b, d, 0xdd);
+    }
+}
+
+#define B3_V            __m512i
+#define B3_LANES        16
+#define B3_SUFFIX       avx512
+#define B3_TARGET       __attribute__((target("avx512f")))
+#define B3_ADD          _mm512_add_epi32
+#define B3_XOR          _mm512_xor_si512
+#define B3_SET1(x)      _mm512_set1_epi32((int)(x))
+#define B3_LOADU(p)     _mm512_loadu_si512((const void *)(p))
+#define B3_STOREU(p, x) _mm512_storeu_si512((void *)(p), x)
+#define B3_ROT16(x)     _mm512_ror_epi32(x, 16)
+#define B3_ROT12(x)     _mm512_ror_epi32(x, 12)
+#define B3_ROT8(x)      _mm512_ror_epi32(x, 8)
+#define B3_ROT7(x)      _mm512_ror_epi32(x, 7)
+#define B3_FALLBACK     checksum_blake3_hash_many_avx2
+#include "checksum_blake3_lanes.h"
+#undef B3_V
+#undef B3_LANES
+#undef B3_SUFFIX
+#undef B3_TARGET
+#undef B3_ADD
+#undef B3_XOR
+#undef B3_SET1
+#undef B3_LOADU
+#undef B3_STOREU
+#undef B3_ROT16
+#undef B3_ROT12
+#undef B3_ROT8
+#undef B3_ROT7
+#undef B3_FALLBACK
+#endif /* CHECKSUM_HAVE_X86_SIMD */
+
+static const blake3_impl_t *blake3_resolve(void) {
+    static const blake3_impl_t portable = {checksum_blake3_hash_many_portable, 1};
+#if CHECKSUM_HAVE_X86_SIMD
+    static const blake3_impl_t sse41 = {checksum_blake3_hash_many_sse41, 4};
+    static const blake3_impl_t avx2 = {checksum_blake3_hash_many_avx2, 8};
+    static const blake3_impl_t avx512 = {checksum_blake3_hash_many_avx512, 16};
+    unsigned int cpu = checksum_cpu_features();
+
+    /* Each kernel hands its leftovers to the next narrower one */
+    if (cpu & CHECKSUM_CPU_SSE41) {
+        if (cpu & CHECKSUM_CPU_AVX2) {
+            if (cpu & CHECKSUM_CPU_AVX512F) {
+                return &avx512;
+            }
+            return &avx2;
+        }
+        return &sse41;
+    }
+#endif
+    return &portable;
+}
+
+static const blake3_impl_t *blake3_impl(void) {
+    static _Atomic(const blake3_impl_t *) impl;
+    const blake3_impl_t *p = atomic_load_explicit(&impl, memory_order_relaxed);
+
+    if (!p) {
+        p = blake3_resolve();
+        atomic_store_explicit(&impl, p, memory_order_relaxed);
+    }
+    return p;
+}
+
+void checksum_blake3_hash_many(const unsigned char *const *inputs, size_t num_inputs,
+                               size_t blocks, const uint32_t key[8], uint64_t counter,
+                               int increment, uint8_t flags, uint8_t flags_start,
+                               uint8_t flags_end, unsigned char *out) {
+    blake3_impl()->hash_many(inputs, num_inputs, blocks, key, counter, increment, flags,
+                             flags_start, flags_end, out);
+}
+
+/*
+ * Chunk state. A chunk is up to 16 blocks; the final block is only
+ * compressed once we know whether it is the last one (CHUNK_END), so
+ * `block` always holds 1..64 pending bytes once any input has arrived.
+ */
+
+static size_t chunk_len(const checksum_blake3_ctx_t *ctx) {
+    return (size_t)ctx->blocks_compressed * BLAKE3_BLOCK_LEN + ctx->block_len;
+}
+
+static uint8_t chunk_start_flag(const checksum_blake3_ctx_t *ctx) {
+    return ctx->blocks_compressed == 0 ? BLAKE3_CHUNK_START : 0;
+}
+
+static void chunk_reset(checksum_blake3_ctx_t *ctx, uint64_t counter) {
+    memcpy(ctx->cv, blake3_iv, sizeof(ctx->cv));
+    ctx->chunk_counter = counter;
+    memset(ctx->block, 0, sizeof(ctx->block));
+    ctx->block_len = 0;
+    ctx->blocks_compressed = 0;
+}
+
+static void chunk_update(checksum_blake3_ctx_t *ctx, const unsigned char *input, size_t len) {
+    if (ctx->block_len > 0) {
+        size_t take = BLAKE3_BLOCK_LEN - ctx->block_len;
+
+        if (take > len) {
+            take = len;
+        }
+        memcpy(ctx->block + ctx->block_len, input, take);
+        ctx->block_len += (uint8_t)take;
+        input += take;
+        len -= take;
+        if (len == 0) {
+            return;
+        }
+        compress_in_place(ctx->cv, ctx->block, BLAKE3_BLOCK_LEN, ctx->chunk_counter,
+                          chunk_start_flag(ctx));
+        ctx->blocks_compressed++;
+        ctx->block_len = 0;
+        memset(ctx->block, 0, sizeof(ctx->block));
+    }
+
+    while (len > BLAKE3_BLOCK_LEN) {
+        compress_in_place(ctx->cv, input, BLAKE3_BLOCK_LEN, ctx->chunk_counter,
+                          chunk_start_flag(ctx));
+        ctx->blocks_compressed++;
+        input += BLAKE3_BLOCK_LEN;
+        len -= BLAKE3_BLOCK_LEN;
+    }
+
+    memcpy(ctx->block, input, len);
+    ctx->block_len = (uint8_t)len;
+}
+
+/* The inputs of a pending compression: a chunk's last block or a parent */
+typedef struct {
+    uint32_t cv[8];
+    unsigned char block[BLAKE3_BLOCK_LEN];
+    uint8_t block_len;
+    uint64_t counter;
+    uint8_t flags;
+} blake3_output_t;
+
+static blake3_output_t chunk_output(const checksum_blake3_ctx_t *ctx) {
+    blake3_output_t out;
+
+    memcpy(out.cv, ctx->cv, sizeof(out.cv));
+    memcpy(out.block, ctx->block, sizeof(out.block));
+    out.block_len = ctx->block_len;
+    out.counter = ctx->chunk_counter;
+    out.flags = chunk_start_flag(ctx) | BLAKE3_CHUNK_END;
+    return out;
+}
+
+static blake3_output_t parent_output(const unsigned char block[BLAKE3_BLOCK_LEN]) {
+    blake3_output_t out;
+
+    memcpy(out.cv, blake3_iv, sizeof(out.cv));
+    memcpy(out.block, block, sizeof(out.block));
+    out.block_len = BLAKE3_BLOCK_LEN;
+    out.counter = 0;
+    out.flags = BLAKE3_PARENT;
+    return out;
+}
+
+static void output_cv(const blake3_output_t *out, unsigned char cv[BLAKE3_OUT_LEN]) {
+    uint32_t words[8];
+
+    memcpy(words, out->cv, sizeof(words));
+    compress_in_place(words, out->block, out->block_len, out->counter, out->flags);
+    for (int i = 0; i < 8; i++) {
+        store_le32(cv + 4 * i, words[i]);
+    }
+}
+
+/*
+ * Subtree hashing. Whole chunks are hashed side by side with hash_many,
+ * then their chaining values are paired up into parents the same way,
+ * level by level. With threads to spare, the two halves of a large
+ * subtree are hashed concurrently.
+ */
+
+/* Largest power-of-two number of whole chunks that leaves input on the right */
+static size_t left_subtree_len(size_t input_len) {
+    size_t full_chunks = (input_len - 1) / BLAKE3_CHUNK_LEN;
+    size_t power = 1;
+
+    while (power * 2 <= full_chunks) {
+        power *= 2;
+    }
+    return power * BLAKE3_CHUNK_LEN;
+}
+
+static size_t compress_chunks_parallel(const blake3_impl_t *impl, const unsigned char *input,
+                                       size_t input_len, uint64_t chunk_counter,
+                                       unsigned char *out) {
+    const unsigned char *chunks[BLAKE3_MAX_SIMD_DEGREE];
+    size_t count = 0;
+
+    while (input_len - count * BLAKE3_CHUNK_LEN >= BLAKE3_CHUNK_LEN) {
+        chunks[count] = input + count * BLAKE3_CHUNK_LEN;
+        count++;
+    }
+    impl->hash_many(chunks, count, BLAKE3_CHUNK_LEN / BLAKE3_BLOCK_LEN, blake3_iv, chunk_counter,
+                    1, 0, BLAKE3_CHUNK_START, BLAKE3_CHUNK_END, out);
+
+    /* A partial chunk can only be the last one */
+    if (input_len > count * BLAKE3_CHUNK_LEN) {
+        checksum_blake3_ctx_t tail;
+        blake3_output_t output;
+
+        chunk_reset(&tail, chunk_counter + count);
+        chunk_update(&tail, input + count * BLAKE3_CHUNK_LEN, input_len - count * BLAKE3_CHUNK_LEN);
+        output = chunk_output(&tail);
+        output_cv(&output, out + count * BLAKE3_OUT_LEN);
+        count++;
+    }
+    return count;
+}
+
+static size_t compress_parents_parallel(const blake3_impl_t *impl, const unsigned char *cvs,
+                                        size_t num_cvs, unsigned char *out) {
+    const unsigned char *parents[BLAKE3_MAX_SIMD_DEGREE];
+    size_t count = num_cvs / 2;
+
+    for (size_t i = 0; i < count; i++) {
+        parents[i] = cvs + 2 * i * BLAKE3_OUT_LEN;
+    }
+    impl->hash_many(parents, count, 1, blake3_iv, 0, 0, BLAKE3_PARENT, 0, 0, out);
+
+    /* An odd one out is carried up to the next level unchanged */
+    if (num_cvs % 2) {
+        memcpy(out + count * BLAKE3_OUT_LEN, cvs + 2 * count * BLAKE3_OUT_LEN, BLAKE3_OUT_LEN);
+        count++;
+    }
+    return count;
+}
+
+typedef struct {
+    const blake3_impl_t *impl;
+    const unsigned char *input;
+    size_t input_len;
+    uint64_t chunk_counter;
+    unsigned char *out;
+    unsigned int threads;
+    size_t count;
+} blake3_subtree_t;
+
+static size_t compress_subtree_wide(const blake3_impl_t *impl, const unsigned char *input,
+                                    size_t input_len, uint64_t chunk_counter, unsigned char *out,
+                                    unsigned int threads);
+
+static void *subtree_worker(void *arg) {
+    blake3_subtree_t *job = arg;
+
+    job->count = compress_subtree_wide(job->impl, job->input, job->input_len, job->chunk_counter,
+                                       job->out, job->threads);
+    return NULL;
+}
+
+/*
+ * Hash a subtree whose size and position keep it aligned to the tree,
+ * writing up to max(degree, 2) chaining values rather than one, so the
+ * caller can keep combining parents with full SIMD width.
+ */
+static size_t compress_subtree_wide(const blake3_impl_t *impl, const unsigned char *input,
+                                    size_t input_len, uint64_t chunk_counter, unsigned char *out,
+                                    unsigned int threads) {
+    unsigned char cvs[2 * BLAKE3_MAX_SIMD_DEGREE * BLAKE3_OUT_LEN];
+    blake3_subtree_t left;
+    pthread_t thread;
+    size_t left_len, right_len, degree = impl->degree;
+    size_t right_count;
+    int spawned = 0;
+
+    if (input_len <= impl->degree * BLAKE3_CHUNK_LEN) {
+        return compress_chunks_parallel(impl, input, input_len, chunk_counter, out);
+    }
+
+    left_len = left_subtree_len(input_len);
+    right_len = input_len - left_len;
+    if (left_len > BLAKE3_CHUNK_LEN && degree == 1) {
+        /* Always return at least two values so the caller can pair them */
+        degree = 2;
+    }
+
+    left.impl = impl;
+    left.input = input;
+    left.input_len = left_len;
+    left.chunk_counter = chunk_counter;
+    left.out = cvs;
+    left.threads = threads / 2;
+    if (threads > 1 && right_len >= BLAKE3_THREAD_MIN &&
+        pthread_create(&thread, NULL, subtree_worker, &left) == 0) {
+        spawned = 1;
+        threads -= threads / 2;
+    } else {
+        subtree_worker(&left);
+    }
+
+    right_count = compress_subtree_wide(impl, input + left_len, right_len,
+                                        chunk_counter + left_len / BLAKE3_CHUNK_LEN,
+                                        cvs + degree * BLAKE3_OUT_LEN, threads);
+    if (spawned) {
+        pthread_join(thread, NULL);
+    }
+
+    if (left.count == 1) {
+        /* Only with degree 1: both halves are single values already */
+        memcpy(out, cvs, 2 * BLAKE3_OUT_LEN);
+        return 2;
+    }
+    return compress_parents_parallel(impl, cvs, left.count + right_count, out);
+}
+
+/* Reduce a subtree of more than one chunk to the two children of its root */
+static void compress_subtree_to_parent(const unsigned char *input, size_t input_len,
+                                       uint64_t chunk_counter, unsigned int threads,
+                                       unsigned char out[2 * BLAKE3_OUT_LEN]) {
+    const blake3_impl_t *impl = blake3_impl();
+    unsigned char cvs[2 * BLAKE3_MAX_SIMD_DEGREE * BLAKE3_OUT_LEN];
+    unsigned char parents[BLAKE3_MAX_SIMD_DEGREE * BLAKE3_OUT_LEN];
+    size_t count = compress_subtree_wide(impl, input, input_len, chunk_counter, cvs, threads);
+
+    while (count > 2) {
+        count = compress_parents_parallel(impl, cvs, count, parents);
+        memcpy(cvs, parents, count * BLAKE3_OUT_LEN);
+    }
+    memcpy(out, cvs, 2 * BLAKE3_OUT_LEN);
+}
+
+/*
+ * Hasher. Completed subtrees are kept on a stack of chaining values and
+ * merged lazily: after `total` chunks the stack holds one entry per set
+ * bit of `total`, but merging waits until more input proves that the
+ * topmost entries are not the root.
+ */
+
+static unsigned int popcount64(uint64_t x) {
+    unsigned int count = 0;
+
+    while (x) {
+        x &= x - 1;
+        count++;
+    }
+    return count;
+}
+
+static void merge_cv_stack(checksum_blake3_ctx_t *ctx, uint64_t total_chunks) {
+    size_t target = popcount64(total_chunks);
+
+    while (ctx->cv_stack_len > target) {
+        unsigned char *pair = ctx->cv_stack + (ctx->cv_stack_len - 2) * BLAKE3_OUT_LEN;
+        blake3_output_t output = parent_output(pair);
+
+        output_cv(&output, pair);
+        ctx->cv_stack_len--;
+    }
+}
+
+static void push_cv(checksum_blake3_ctx_t *ctx, const unsigned char cv[BLAKE3_OUT_LEN],
+                    uint64_t chunk_counter) {
+    merge_cv_stack(ctx, chunk_counter);
+    memcpy(ctx->cv_stack + ctx->cv_stack_len * BLAKE3_OUT_LEN, cv, BLAKE3_OUT_LEN);
+    ctx->cv_stack_len++;
+}
+
+void checksum_blake3_init(checksum_blake3_ctx_t *ctx) {
+    chunk_reset(ctx, 0);
+    ctx->cv_stack_len = 0;
+}
+
+void checksum_blake3_update_parallel(checksum_blake3_ctx_t *ctx, const void *data, size_t len,
+                                     unsigned int threads) {
+    const unsigned char *input = data;
+
+    if (len == 0) {
+        return;
+    }
+
+    /* Finish a partial chunk first; it is only closed once more input follows */
+    if (chunk_len(ctx) > 0) {
+        size_t take = BLAKE3_CHUNK_LEN - chunk_len(ctx);
+
+        if (take > len) {
+            take = len;
+        }
+        chunk_update(ctx, input, take);
+        input += take;
+        len -= take;
+        if (len == 0) {
+            return;
+        }
+
+        {
+            blake3_output_t output = chunk_output(ctx);
+            unsigned char cv[BLAKE3_OUT_LEN];
+
+            output_cv(&output, cv);
+            push_cv(ctx, cv, ctx->chunk_counter);
+            chunk_reset(ctx, ctx->chunk_counter + 1);
+        }
+    }
+
+    /* Hash the largest aligned power-of-two subtrees; keep the last chunk back */
+    while (len > BLAKE3_CHUNK_LEN) {
+        uint64_t counter = ctx->chunk_counter;
+        size_t subtree_len = BLAKE3_CHUNK_LEN;
+        uint64_t subtree_chunks;
+
+        while (subtree_len * 2 <= len && subtree_len * 2 != 0) {
+            subtree_len *= 2;
+        }
+        while (((uint64_t)(subtree_len - 1) & (counter * BLAKE3_CHUNK_LEN)) != 0) {
+            subtree_len /= 2;
+        }
+        subtree_chunks = subtree_len / BLAKE3_CHUNK_LEN;
+
+        if (subtree_len <= BLAKE3_CHUNK_LEN) {
+            blake3_output_t output;
+            unsigned char cv[BLAKE3_OUT_LEN];
+
+            chunk_update(ctx, input, subtree_len);
+            output = chunk_output(ctx);
+            output_cv(&output, cv);
+            push_cv(ctx, cv, counter);
+        } else {
+            unsigned char pair[2 * BLAKE3_OUT_LEN];
+
+            compress_subtree_to_parent(input, subtree_len, counter, threads, pair);
+            push_cv(ctx, pair, counter);
+            push_cv(ctx, pair + BLAKE3_OUT_LEN, counter + subtree_chunks / 2);
+        }
+
+        chunk_reset(ctx, counter + subtree_chunks);
+        input += subtree_len;
+        len -= subtree_len;
+    }
+
+    if (len > 0) {
+        chunk_update(ctx, input, len);
+        merge_cv_stack(ctx, ctx->chunk_counter);
+    }
+}
+
+void checksum_blake3_update(checksum_blake3_ctx_t *ctx, const void *data, size_t len) {
+    checksum_blake3_update_parallel(ctx, data, len, 1);
+}
+
+void checksum_blake3_final(const checksum_blake3_ctx_t *ctx,
+                           unsigned char digest[CHECKSUM_BLAKE3_DIGEST]) {
+    blake3_output_t output;
+    size_t remaining;
+
+    if (ctx->cv_stack_len == 0) {
+        output = chunk_output(ctx);
+    } else {
+        if (chunk_len(ctx) > 0) {
+            output = chunk_output(ctx);
+            remaining = ctx->cv_stack_len;
+        } else {
+            output = parent_output(ctx->cv_stack + (ctx->cv_stack_len - 2) * BLAKE3_OUT_LEN);
+            remaining = ctx->cv_stack_len - 2;
+        }
+        while (remaining > 0) {
+            unsigned char block[BLAKE3_BLOCK_LEN];
+
+            remaining--;
+            memcpy(block, ctx->cv_stack + remaining * BLAKE3_OUT_LEN, BLAKE3_OUT_LEN);
+            output_cv(&output, block + BLAKE3_OUT_LEN);
+            output = parent_output(block);
+        }
+    }
+
+    output.flags |= BLAKE3_ROOT;
+    output.counter = 0;
+    output_cv(&output, digest);
+}
+
+void checksum_blake3(const unsigned char *data, size_t len,
+                     unsigned char digest[CHECKSUM_BLAKE3_DIGEST]) {
+    checksum_blake3_ctx_t ctx;
+
+    checksum_blake3_init(&ctx);
+    checksum_blake3_update(&ctx, data, len);
+    checksum_blake3_final(&ctx, digest);
+}
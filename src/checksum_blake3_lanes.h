@@ -0,0 +1,142 @@
+/*
+ * checksum_blake3_lanes.h - BLAKE3 compression across SIMD lanes
+ *
+ * Copyright (c) 2025 AnmiTaliDev
+ * Created: 2025-08-09
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Included by checksum_blake3.c once per vector width. Each lane hashes a
+ * different input (chunk or parent node), so rounds need no shuffling
+ * between lanes. The includer defines:
+ *
+ *   B3_V, B3_LANES, B3_SUFFIX, B3_TARGET       vector type, width, naming
+ *   B3_ADD, B3_XOR, B3_SET1, B3_LOADU, B3_STOREU
+ *   B3_ROT16, B3_ROT12, B3_ROT8, B3_ROT7       32-bit rotate right
+ *   B3_FALLBACK                                hash_many for the leftovers
+ *
+ * and a load_msg_<suffix>() that transposes one block of every lane into
+ * sixteen message word vectors.
+ */
+
+#define B3_G(a, b, c, d, x, y) do { \
+    a = B3_ADD(B3_ADD(a, b), x); \
+    d = B3_ROT16(B3_XOR(d, a)); \
+    c = B3_ADD(c, d); \
+    b = B3_ROT12(B3_XOR(b, c)); \
+    a = B3_ADD(B3_ADD(a, b), y); \
+    d = B3_ROT8(B3_XOR(d, a)); \
+    c = B3_ADD(c, d); \
+    b = B3_ROT7(B3_XOR(b, c)); \
+} while (0)
+
+B3_TARGET
+static inline void B3_FN(round)(B3_V v[16], const B3_V m[16], int r) {
+    const uint8_t *s = blake3_schedule[r];
+
+    B3_G(v[0], v[4], v[8], v[12], m[s[0]], m[s[1]]);
+    B3_G(v[1], v[5], v[9], v[13], m[s[2]], m[s[3]]);
+    B3_G(v[2], v[6], v[10], v[14], m[s[4]], m[s[5]]);
+    B3_G(v[3], v[7], v[11], v[15], m[s[6]], m[s[7]]);
+    B3_G(v[0], v[5], v[10], v[15], m[s[8]], m[s[9]]);
+    B3_G(v[1], v[6], v[11], v[12], m[s[10]], m[s[11]]);
+    B3_G(v[2], v[7], v[8], v[13], m[s[12]], m[s[13]]);
+    B3_G(v[3], v[4], v[9], v[14], m[s[14]], m[s[15]]);
+}
+
+B3_TARGET
+static void B3_FN(hash_lanes)(const unsigned char *const *inputs, size_t blocks,
+                              const uint32_t key[8], uint64_t counter, int increment,
+                              uint8_t flags, uint8_t flags_start, uint8_t flags_end,
+                              unsigned char *out) {
+    uint32_t lo[B3_LANES], hi[B3_LANES];
+    uint32_t words[8][B3_LANES];
+    uint8_t block_flags = flags | flags_start;
+    B3_V h[8], counter_lo, counter_hi;
+
+    for (int i = 0; i < 8; i++) {
+        h[i] = B3_SET1(key[i]);
+    }
+    for (int j = 0; j < B3_LANES; j++) {
+        uint64_t c = counter + (increment ? (uint64_t)j : 0);
+
+        lo[j] = (uint32_t)c;
+        hi[j] = (uint32_t)(c >> 32);
+    }
+    counter_lo = B3_LOADU(lo);
+    counter_hi = B3_LOADU(hi);
+
+    for (size_t b = 0; b < blocks; b++) {
+        B3_V m[16], v[16];
+
+        if (b + 1 == blocks) {
+            block_flags |= flags_end;
+        }
+        B3_FN(load_msg)(inputs, b * BLAKE3_BLOCK_LEN, m);
+
+        for (int i = 0; i < 8; i++) {
+            v[i] = h[i];
+        }
+        v[8] = B3_SET1(blake3_iv[0]);
+        v[9] = B3_SET1(blake3_iv[1]);
+        v[10] = B3_SET1(blake3_iv[2]);
+        v[11] = B3_SET1(blake3_iv[3]);
+        v[12] = counter_lo;
+        v[13] = counter_hi;
+        v[14] = B3_SET1(BLAKE3_BLOCK_LEN);
+        v[15] = B3_SET1(block_flags);
+
+        for (int r = 0; r < 7; r++) {
+            B3_FN(round)(v, m, r);
+        }
+        for (int i = 0; i < 8; i++) {
+            h[i] = B3_XOR(v[i], v[i + 8]);
+        }
+        block_flags = flags;
+    }
+
+    /* Transpose back through memory: once per input, so cheap */
+    for (int i = 0; i < 8; i++) {
+        B3_STOREU(words[i], h[i]);
+    }
+    for (int j = 0; j < B3_LANES; j++) {
+        for (int i = 0; i < 8; i++) {
+            store_le32(out + j * BLAKE3_OUT_LEN + 4 * i, words[i][j]);
+        }
+    }
+}
+
+B3_TARGET
+void B3_FN(checksum_blake3_hash_many)(const unsigned char *const *inputs, size_t num_inputs,
+                                      size_t blocks, const uint32_t key[8], uint64_t counter,
+                                      int increment, uint8_t flags, uint8_t flags_start,
+                                      uint8_t flags_end, unsigned char *out) {
+    while (num_inputs >= B3_LANES) {
+        B3_FN(hash_lanes)(inputs, blocks, key, counter, increment, flags, flags_start, flags_end,
+                          out);
+        if (increment) {
+            counter += B3_LANES;
+        }
+        inputs += B3_LANES;
+        num_inputs -= B3_LANES;
+        out += B3_LANES * BLAKE3_OUT_LEN;
+    }
+
+    B3_FALLBACK(inputs, num_inputs, blocks, key, counter, increment, flags, flags_start, flags_end,
+                out);
+}
+
+#undef B3_G
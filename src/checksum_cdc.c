@@ -0,0 +1,104 @@
+/*
+ * checksum_cdc.c - FastCDC content-defined chunking
+ *
+ * Copyright (c) 2025 AnmiTaliDev
+ * Created: 2025-08-09
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "checksum.h"
+
+#define CDC_MIN_SIZE    64
+#define CDC_MAX_SIZE    (1U << 30)
+
+/* Fixed seed: chunk boundaries must not change between runs or versions */
+#define CDC_GEAR_SEED   0x6a09e667f3bcc908ULL
+
+static uint64_t splitmix64(uint64_t *state) {
+    uint64_t z = (*state += 0x9e3779b97f4a7c15ULL);
+
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+}
+
+/*
+ * A mask of the top `bits` bits. With the gear hash shifting left, the
+ * high bits depend on the most bytes (up to 64), the low bits on the fewest.
+ */
+static uint64_t top_mask(int bits) {
+    if (bits <= 0) {
+        return 0;
+    }
+    if (bits >= 64) {
+        return ~0ULL;
+    }
+    return ~0ULL << (64 - bits);
+}
+
+int checksum_cdc_init(checksum_cdc_t *cdc, uint32_t min_size, uint32_t avg_size,
+                      uint32_t max_size) {
+    uint64_t state = CDC_GEAR_SEED;
+    int bits = 0;
+
+    if (!cdc || min_size < CDC_MIN_SIZE || min_size > avg_size || avg_size > max_size ||
+        max_size > CDC_MAX_SIZE) {
+        return CHECKSUM_ERROR_ARG;
+    }
+
+    while ((2U << bits) <= avg_size) {
+        bits++;
+    }
+
+    /* Normalized chunking, level 2: two bits either side of log2(avg) */
+    cdc->min_size = min_size;
+    cdc->avg_size = avg_size;
+    cdc->max_size = max_size;
+    cdc->mask_small = top_mask(bits + 2);
+    cdc->mask_large = top_mask(bits - 2);
+    for (int i = 0; i < 256; i++) {
+        cdc->gear[i] = splitmix64(&state);
+    }
+    return CHECKSUM_SUCCESS;
+}
+
+size_t checksum_cdc_next(const checksum_cdc_t *cdc, const unsigned char *data, size_t len) {
+    size_t normal, end, i;
+    uint64_t fp = 0;
+
+    if (len <= cdc->min_size) {
+        return len;
+    }
+    end = len < cdc->max_size ? len : cdc->max_size;
+    normal = end < cdc->avg_size ? end : cdc->avg_size;
+
+    /* Bytes before min_size can never end a chunk, so they are skipped */
+    for (i = cdc->min_size; i < normal; i++) {
+        fp = (fp << 1) + cdc->gear[data[i]];
+        if (!(fp & cdc->mask_small)) {
+            return i + 1;
+        }
+    }
+    for (; i < end; i++) {
+        fp = (fp << 1) + cdc->gear[data[i]];
+        if (!(fp & cdc->mask_large)) {
+            return i + 1;
+        }
+    }
+    return end;
+}
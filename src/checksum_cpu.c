@@ -0,0 +1,124 @@
+/*
+ * checksum_cpu.c - Runtime CPU feature detection for checksum kernels
+ *
+ * Copyright (c) 2025 AnmiTaliDev
+ * Created: 2025-08-09
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <stdatomic.h>
+#include <stdlib.h>
+
+#include "checksum_kernels.h"
+
+#if CHECKSUM_HAVE_X86_SIMD
+#include <cpuid.h>
+
+/* XCR0 state components */
+#define XCR0_SSE     (1u << 1)
+#define XCR0_AVX     (1u << 2)
+#define XCR0_OPMASK  (1u << 5)
+#define XCR0_ZMM_HI  (1u << 6)
+#define XCR0_HI_ZMM  (1u << 7)
+
+static uint32_t read_xcr0(void) {
+    uint32_t eax, edx;
+
+    __asm__ volatile("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+    return eax;
+}
+
+static unsigned int detect_features(void) {
+    unsigned int eax, ebx, ecx, edx;
+    unsigned int max_leaf;
+    unsigned int features = 0;
+    uint32_t xcr0 = 0;
+
+    max_leaf = __get_cpuid_max(0, NULL);
+    if (max_leaf < 1) {
+        return 0;
+    }
+
+    __cpuid(1, eax, ebx, ecx, edx);
+
+    if (edx & bit_SSE2)   features |= CHECKSUM_CPU_SSE2;
+    if (ecx & bit_SSSE3)  features |= CHECKSUM_CPU_SSSE3;
+    if (ecx & bit_SSE4_1) features |= CHECKSUM_CPU_SSE41;
+    if (ecx & bit_SSE4_2) features |= CHECKSUM_CPU_SSE42;
+    if (ecx & bit_PCLMUL) features |= CHECKSUM_CPU_PCLMUL;
+
+    /* AVX state must be enabled by the OS before any VEX code can run */
+    if ((ecx & bit_OSXSAVE) && (ecx & bit_AVX)) {
+        xcr0 = read_xcr0();
+        if ((xcr0 & (XCR0_SSE | XCR0_AVX)) == (XCR0_SSE | XCR0_AVX)) {
+            features |= CHECKSUM_CPU_AVX;
+        }
+    }
+
+    if (max_leaf < 7) {
+        return features;
+    }
+
+    __cpuid_count(7, 0, eax, ebx, ecx, edx);
+
+    if (ebx & bit_SHA) features |= CHECKSUM_CPU_SHA;
+
+    if (features & CHECKSUM_CPU_AVX) {
+        if (ebx & bit_AVX2) features |= CHECKSUM_CPU_AVX2;
+        if ((ecx & bit_VPCLMULQDQ) && (features & CHECKSUM_CPU_PCLMUL)) {
+            features |= CHECKSUM_CPU_VPCLMUL;
+        }
+
+        if ((xcr0 & (XCR0_OPMASK | XCR0_ZMM_HI | XCR0_HI_ZMM)) ==
+            (XCR0_OPMASK | XCR0_ZMM_HI | XCR0_HI_ZMM)) {
+            if (ebx & bit_AVX512F)  features |= CHECKSUM_CPU_AVX512F;
+            if (ebx & bit_AVX512BW) features |= CHECKSUM_CPU_AVX512BW;
+            if (ebx & bit_AVX512VL) features |= CHECKSUM_CPU_AVX512VL;
+        }
+    }
+
+    return features;
+}
+#else
+static unsigned int detect_features(void) {
+    return 0;
+}
+#endif
+
+/* CHECKSUM_CPU_MASK limits the detected features, e.g. 0 for portable code */
+static unsigned int feature_mask(void) {
+    const char *text = getenv("CHECKSUM_CPU_MASK");
+    char *end;
+    unsigned long mask;
+
+    if (!text || *text == '\0') {
+        return ~0u;
+    }
+    mask = strtoul(text, &end, 0);
+    return *end == '\0' ? (unsigned int)mask : ~0u;
+}
+
+unsigned int checksum_cpu_features(void) {
+    /* Bit 31 marks the cached value as valid */
+    static atomic_uint cached;
+    unsigned int features = atomic_load_explicit(&cached, memory_order_relaxed);
+
+    if (!(features & (1u << 31))) {
+        features = (detect_features() & feature_mask()) | (1u << 31);
+        atomic_store_explicit(&cached, features, memory_order_relaxed);
+    }
+
+    return features & ~(1u << 31);
+}
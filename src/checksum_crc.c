@@ -0,0 +1,291 @@
+/*
+ * checksum_crc.c - Generic CRC engine and variant catalog
+ *
+ * Copyright (c) 2025 AnmiTaliDev
+ * Created: 2025-08-09
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdatomic.h>
+#include <ctype.h>
+
+#include "checksum.h"
+#include "checksum_kernels.h"
+#include "crc_catalog_tables.h"    /* generated by crc_tablegen */
+
+#if CHECKSUM_HAVE_X86_SIMD
+#include <immintrin.h>
+#endif
+
+/* Minimum length at which folding beats the sliced tables */
+#define CRC_PCLMUL_MIN  64
+
+/* Tables depend only on width, polynomial and input reflection */
+#define CRC_VARIANT(name, alias, width, poly, init, refin, refout, xorout, check, table) \
+    { name, alias, width, poly, init, refin, refout, xorout, check, table, table##_fold }
+
+static const checksum_crc_params_t crc_catalog[] = {
+    CRC_VARIANT("CRC-8/SMBUS", NULL, 8, 0x07, 0x00, 0, 0, 0x00, 0xf4, crc8_07_n),
+    CRC_VARIANT("CRC-8/MAXIM-DOW", "CRC-8/MAXIM", 8, 0x31, 0x00, 1, 1, 0x00, 0xa1, crc8_31_r),
+    CRC_VARIANT("CRC-12/UMTS", "CRC-12/3GPP", 12, 0x80f, 0x000, 0, 1, 0x000, 0xdaf, crc12_80f_n),
+    CRC_VARIANT("CRC-16/ARC", "CRC-16", 16, 0x8005, 0x0000, 1, 1, 0x0000, 0xbb3d, crc16_8005_r),
+    CRC_VARIANT("CRC-16/MODBUS", NULL, 16, 0x8005, 0xffff, 1, 1, 0x0000, 0x4b37, crc16_8005_r),
+    CRC_VARIANT("CRC-16/IBM-3740", "CRC-16/CCITT-FALSE", 16, 0x1021, 0xffff, 0, 0, 0x0000,
+                0x29b1, crc16_1021_n),
+    CRC_VARIANT("CRC-16/XMODEM", NULL, 16, 0x1021, 0x0000, 0, 0, 0x0000, 0x31c3, crc16_1021_n),
+    CRC_VARIANT("CRC-16/KERMIT", "CRC-16/CCITT", 16, 0x1021, 0x0000, 1, 1, 0x0000, 0x2189,
+                crc16_1021_r),
+    CRC_VARIANT("CRC-16/IBM-SDLC", "CRC-16/X-25", 16, 0x1021, 0xffff, 1, 1, 0xffff, 0x906e,
+                crc16_1021_r),
+    CRC_VARIANT("CRC-24/OPENPGP", NULL, 24, 0x864cfb, 0xb704ce, 0, 0, 0x000000, 0x21cf02,
+                crc24_864cfb_n),
+    CRC_VARIANT("CRC-32/ISO-HDLC", "CRC-32", 32, 0x04c11db7, 0xffffffff, 1, 1, 0xffffffff,
+                0xcbf43926, crc32_04c11db7_r),
+    CRC_VARIANT("CRC-32/ISCSI", "CRC-32C", 32, 0x1edc6f41, 0xffffffff, 1, 1, 0xffffffff,
+                0xe3069283, crc32_1edc6f41_r),
+    CRC_VARIANT("CRC-32/BZIP2", NULL, 32, 0x04c11db7, 0xffffffff, 0, 0, 0xffffffff, 0xfc891918,
+                crc32_04c11db7_n),
+    CRC_VARIANT("CRC-32/MPEG-2", NULL, 32, 0x04c11db7, 0xffffffff, 0, 0, 0x00000000, 0x0376e6e7,
+                crc32_04c11db7_n),
+    CRC_VARIANT("CRC-64/ECMA-182", "CRC-64", 64, 0x42f0e1eba9ea3693ULL, 0, 0, 0, 0,
+                0x6c40df5f0b497347ULL, crc64_42f0e1eba9ea3693_n),
+    CRC_VARIANT("CRC-64/XZ", "CRC-64/GO-ECMA", 64, 0x42f0e1eba9ea3693ULL, ~0ULL, 1, 1, ~0ULL,
+                0x995dc9bbdf1939faULL, crc64_42f0e1eba9ea3693_r),
+    CRC_VARIANT("CRC-64/NVME", NULL, 64, 0xad93d23594c93659ULL, ~0ULL, 1, 1, ~0ULL,
+                0xae8b14860a799888ULL, crc64_ad93d23594c93659_r),
+    CRC_VARIANT("CRC-64/GO-ISO", NULL, 64, 0x1bULL, ~0ULL, 1, 1, ~0ULL, 0xb90956c775a41001ULL,
+                crc64_1b_r)
+};
+
+#define CRC_CATALOG_SIZE (sizeof(crc_catalog) / sizeof(crc_catalog[0]))
+
+typedef uint64_t (*crc_update_fn)(const checksum_crc_params_t *params, uint64_t crc,
+                                  const unsigned char *data, size_t len);
+
+static inline uint64_t load_le64(const unsigned char *p) {
+    return (uint64_t)p[0] | ((uint64_t)p[1] << 8) | ((uint64_t)p[2] << 16) |
+           ((uint64_t)p[3] << 24) | ((uint64_t)p[4] << 32) | ((uint64_t)p[5] << 40) |
+           ((uint64_t)p[6] << 48) | ((uint64_t)p[7] << 56);
+}
+
+static inline uint64_t load_be64(const unsigned char *p) {
+    return ((uint64_t)p[0] << 56) | ((uint64_t)p[1] << 48) | ((uint64_t)p[2] << 40) |
+           ((uint64_t)p[3] << 32) | ((uint64_t)p[4] << 24) | ((uint64_t)p[5] << 16) |
+           ((uint64_t)p[6] << 8) | (uint64_t)p[7];
+}
+
+static uint64_t reflect(uint64_t value, unsigned int width) {
+    uint64_t r = 0;
+
+    for (unsigned int i = 0; i < width; i++) {
+        r = (r << 1) | (value & 1);
+        value >>= 1;
+    }
+    return r;
+}
+
+static uint64_t width_mask(unsigned int width) {
+    return width >= 64 ? ~0ULL : (1ULL << width) - 1;
+}
+
+/*
+ * Slicing-by-8. A reflected register lives in the low width bits and
+ * consumes bytes from its bottom; a normal one is left-aligned in 64 bits
+ * and consumes them from its top.
+ */
+uint64_t checksum_crc_raw_table(const checksum_crc_params_t *params, uint64_t c,
+                                const unsigned char *buf, size_t len) {
+    const uint64_t (*t)[256] = params->table;
+
+    if (params->refin) {
+        while (len >= 8) {
+            c ^= load_le64(buf);
+            c = t[7][c & 0xff] ^ t[6][(c >> 8) & 0xff] ^ t[5][(c >> 16) & 0xff] ^
+                t[4][(c >> 24) & 0xff] ^ t[3][(c >> 32) & 0xff] ^ t[2][(c >> 40) & 0xff] ^
+                t[1][(c >> 48) & 0xff] ^ t[0][c >> 56];
+            buf += 8;
+            len -= 8;
+        }
+        while (len--) {
+            c = t[0][(c ^ *buf++) & 0xff] ^ (c >> 8);
+        }
+    } else {
+        while (len >= 8) {
+            c ^= load_be64(buf);
+            c = t[7][c >> 56] ^ t[6][(c >> 48) & 0xff] ^ t[5][(c >> 40) & 0xff] ^
+                t[4][(c >> 32) & 0xff] ^ t[3][(c >> 24) & 0xff] ^ t[2][(c >> 16) & 0xff] ^
+                t[1][(c >> 8) & 0xff] ^ t[0][c & 0xff];
+            buf += 8;
+            len -= 8;
+        }
+        while (len--) {
+            c = t[0][(c >> 56) ^ *buf++] ^ (c << 8);
+        }
+    }
+    return c;
+}
+
+#if CHECKSUM_HAVE_X86_SIMD
+/* acc * x^d folded onto the next 128 bits of data */
+__attribute__((target("pclmul,sse4.1")))
+static inline __m128i crc_fold(__m128i acc, __m128i k, __m128i data) {
+    __m128i lo = _mm_clmulepi64_si128(acc, k, 0x00);
+    __m128i hi = _mm_clmulepi64_si128(acc, k, 0x11);
+    return _mm_xor_si128(_mm_xor_si128(lo, hi), data);
+}
+
+__attribute__((target("pclmul,sse4.1")))
+static inline __m128i crc_k(const uint64_t *fold, int distance) {
+    /* fold[] holds (x^(d+63), x^(d-1)) pairs for d = 128, 256, 384, 512 */
+    return _mm_set_epi64x((long long)fold[distance * 2 + 1], (long long)fold[distance * 2]);
+}
+
+/*
+ * Fold four 128-bit lanes 512 bits at a time, merge them, then run the
+ * table kernel from a zero register over the last 16 folded bytes. The
+ * initial register is XORed into the first bytes of input, which is
+ * exactly what the table kernel would do with it.
+ */
+__attribute__((target("pclmul,sse4.1")))
+uint64_t checksum_crc_raw_pclmul(const checksum_crc_params_t *params, uint64_t crc,
+                                 const unsigned char *buf, size_t len) {
+    const uint64_t *fold = params->fold;
+    unsigned char folded[16];
+    __m128i x0, x1, x2, x3, k;
+
+    if (!params->refin || len < CRC_PCLMUL_MIN) {
+        return checksum_crc_raw_table(params, crc, buf, len);
+    }
+
+    x0 = _mm_xor_si128(_mm_loadu_si128((const __m128i *)buf), _mm_set_epi64x(0, (long long)crc));
+    x1 = _mm_loadu_si128((const __m128i *)(buf + 16));
+    x2 = _mm_loadu_si128((const __m128i *)(buf + 32));
+    x3 = _mm_loadu_si128((const __m128i *)(buf + 48));
+    buf += 64;
+    len -= 64;
+
+    k = crc_k(fold, 3);
+    while (len >= 64) {
+        x0 = crc_fold(x0, k, _mm_loadu_si128((const __m128i *)buf));
+        x1 = crc_fold(x1, k, _mm_loadu_si128((const __m128i *)(buf + 16)));
+        x2 = crc_fold(x2, k, _mm_loadu_si128((const __m128i *)(buf + 32)));
+        x3 = crc_fold(x3, k, _mm_loadu_si128((const __m128i *)(buf + 48)));
+        buf += 64;
+        len -= 64;
+    }
+
+    x3 = crc_fold(x0, crc_k(fold, 2), x3);
+    x3 = crc_fold(x1, crc_k(fold, 1), x3);
+    x3 = crc_fold(x2, crc_k(fold, 0), x3);
+
+    k = crc_k(fold, 0);
+    while (len >= 16) {
+        x3 = crc_fold(x3, k, _mm_loadu_si128((const __m128i *)buf));
+        buf += 16;
+        len -= 16;
+    }
+
+    _mm_storeu_si128((__m128i *)folded, x3);
+    crc = checksum_crc_raw_table(params, 0, folded, sizeof(folded));
+    return checksum_crc_raw_table(params, crc, buf, len);
+}
+#endif /* CHECKSUM_HAVE_X86_SIMD */
+
+static crc_update_fn crc_resolve(void) {
+#if CHECKSUM_HAVE_X86_SIMD
+    if ((checksum_cpu_features() & (CHECKSUM_CPU_PCLMUL | CHECKSUM_CPU_SSE41)) ==
+        (CHECKSUM_CPU_PCLMUL | CHECKSUM_CPU_SSE41)) {
+        return checksum_crc_raw_pclmul;
+    }
+#endif
+    return checksum_crc_raw_table;
+}
+
+const checksum_crc_params_t *checksum_crc_catalog(size_t *count) {
+    if (count) {
+        *count = CRC_CATALOG_SIZE;
+    }
+    return crc_catalog;
+}
+
+static int name_equal(const char *a, const char *b) {
+    while (*a && tolower((unsigned char)*a) == tolower((unsigned char)*b)) {
+        a++;
+        b++;
+    }
+    return *a == '\0' && *b == '\0';
+}
+
+const checksum_crc_params_t *checksum_crc_find(const char *name) {
+    if (!name) {
+        return NULL;
+    }
+
+    for (size_t i = 0; i < CRC_CATALOG_SIZE; i++) {
+        const checksum_crc_params_t *p = &crc_catalog[i];
+
+        /* Catalog names all start with "CRC-", which may be left out */
+        if (name_equal(name, p->name) || name_equal(name, p->name + 4) ||
+            (p->alias && (name_equal(name, p->alias) || name_equal(name, p->alias + 4)))) {
+            return p;
+        }
+    }
+    return NULL;
+}
+
+void checksum_crc_init(checksum_crc_ctx_t *ctx, const checksum_crc_params_t *params) {
+    ctx->params = params;
+    if (params->refin) {
+        ctx->crc = reflect(params->init, params->width);
+    } else {
+        ctx->crc = params->init << (64 - params->width);
+    }
+}
+
+void checksum_crc_update(checksum_crc_ctx_t *ctx, const unsigned char *data, size_t len) {
+    static _Atomic(crc_update_fn) impl;
+    crc_update_fn fn;
+
+    if (len == 0) {
+        return;
+    }
+
+    fn = atomic_load_explicit(&impl, memory_order_relaxed);
+    if (!fn) {
+        fn = crc_resolve();
+        atomic_store_explicit(&impl, fn, memory_order_relaxed);
+    }
+    ctx->crc = fn(ctx->params, ctx->crc, data, len);
+}
+
+uint64_t checksum_crc_final(const checksum_crc_ctx_t *ctx) {
+    const checksum_crc_params_t *p = ctx->params;
+    uint64_t crc = p->refin ? ctx->crc : ctx->crc >> (64 - p->width);
+
+    if (p->refin != p->refout) {
+        crc = reflect(crc, p->width);
+    }
+    return (crc ^ p->xorout) & width_mask(p->width);
+}
+
+uint64_t checksum_crc(const checksum_crc_params_t *params, const unsigned char *data, size_t len) {
+    checksum_crc_ctx_t ctx;
+
+    checksum_crc_init(&ctx, params);
+    checksum_crc_update(&ctx, data, len);
+    return checksum_crc_final(&ctx);
+}
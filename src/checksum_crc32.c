@@ -0,0 +1,505 @@
+/*
+ * checksum_crc32.c - CRC32 and CRC32C kernels with runtime dispatch
+ *
+ * Copyright (c) 2025 AnmiTaliDev
+ * Created: 2025-08-09
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdatomic.h>
+
+#include "checksum.h"
+#include "checksum_kernels.h"
+#include "crc32_tables.h"   /* generated by crc_tablegen */
+
+#if CHECKSUM_HAVE_X86_SIMD
+#include <immintrin.h>
+#endif
+
+/* Minimum lengths at which the folding kernels beat the sliced tables */
+#define CRC32_PCLMUL_MIN   64
+#define CRC32_VPCLMUL_MIN  256
+
+typedef uint32_t (*crc32_update_fn)(uint32_t crc, const unsigned char *data, size_t len);
+
+static inline uint32_t load_le32(const unsigned char *p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) |
+           ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+/*
+ * Slicing-by-16: fold 16 input bytes per iteration through independent
+ * table lookups, breaking the byte-serial dependency chain
+ */
+static inline uint32_t crc_slice16(const uint32_t table[16][256], uint32_t c,
+                                   const unsigned char *buf, size_t len) {
+    while (len >= 16) {
+        uint32_t w0 = load_le32(buf) ^ c;
+        uint32_t w1 = load_le32(buf + 4);
+        uint32_t w2 = load_le32(buf + 8);
+        uint32_t w3 = load_le32(buf + 12);
+        
+        c = table[15][w0 & 0xff] ^ table[14][(w0 >> 8) & 0xff] ^
+            table[13][(w0 >> 16) & 0xff] ^ table[12][w0 >> 24] ^
+            table[11][w1 & 0xff] ^ table[10][(w1 >> 8) & 0xff] ^
+            table[9][(w1 >> 16) & 0xff] ^ table[8][w1 >> 24] ^
+            table[7][w2 & 0xff] ^ table[6][(w2 >> 8) & 0xff] ^
+            table[5][(w2 >> 16) & 0xff] ^ table[4][w2 >> 24] ^
+            table[3][w3 & 0xff] ^ table[2][(w3 >> 8) & 0xff] ^
+            table[1][(w3 >> 16) & 0xff] ^ table[0][w3 >> 24];
+        
+        buf += 16;
+        len -= 16;
+    }
+    
+    while (len--) {
+        c = table[0][(c ^ *buf++) & 0xff] ^ (c >> 8);
+    }
+    
+    return c;
+}
+
+uint32_t checksum_crc32_raw_table(uint32_t crc, const unsigned char *buf, size_t len) {
+    return crc_slice16(crc32_table, crc, buf, len);
+}
+
+#if CHECKSUM_HAVE_X86_SIMD
+/*
+ * Folding constants for the reflected CRC-32 polynomial, following Intel's
+ * "Fast CRC Computation for Generic Polynomials Using PCLMULQDQ":
+ * each pair is (x^(d+32) mod P)' << 1, (x^(d-32) mod P)' << 1 for a fold
+ * distance of d bits, where ' denotes 32-bit reflection.
+ */
+#define CRC32_FOLD_2048  0x011542778aULL, 0x01322d1430ULL
+#define CRC32_FOLD_1024  0x01e88ef372ULL, 0x014a7fe880ULL
+#define CRC32_FOLD_512   0x0154442bd4ULL, 0x01c6e41596ULL
+#define CRC32_FOLD_384   0x003db1ecdcULL, 0x0174359406ULL
+#define CRC32_FOLD_256   0x00f1da05aaULL, 0x015a546366ULL
+#define CRC32_FOLD_128   0x01751997d0ULL, 0x00ccaa009eULL
+#define CRC32_FOLD_64    0x0163cd6124ULL
+/* Barrett reduction: P' and mu' = (x^64 / P)' */
+#define CRC32_POLY_P     0x01db710641ULL
+#define CRC32_POLY_MU    0x01f7011641ULL
+
+__attribute__((target("pclmul,sse4.1")))
+static inline __m128i crc32_k128(uint64_t lo, uint64_t hi) {
+    return _mm_set_epi64x((long long)hi, (long long)lo);
+}
+
+/* acc * x^d folded onto the next 128 bits of data */
+__attribute__((target("pclmul,sse4.1")))
+static inline __m128i fold128(__m128i acc, __m128i k, __m128i data) {
+    __m128i lo = _mm_clmulepi64_si128(acc, k, 0x00);
+    __m128i hi = _mm_clmulepi64_si128(acc, k, 0x11);
+    return _mm_xor_si128(_mm_xor_si128(lo, hi), data);
+}
+
+/* Fold the remaining 16-byte blocks and Barrett-reduce to 32 bits */
+__attribute__((target("pclmul,sse4.1")))
+static uint32_t crc32_reduce128(__m128i x1, const unsigned char **bufp, size_t *lenp) {
+    const unsigned char *buf = *bufp;
+    size_t len = *lenp;
+    const __m128i mask32 = _mm_setr_epi32(~0, 0, ~0, 0);
+    __m128i k = crc32_k128(CRC32_FOLD_128);
+    __m128i x2;
+
+    while (len >= 16) {
+        x1 = fold128(x1, k, _mm_loadu_si128((const __m128i *)buf));
+        buf += 16;
+        len -= 16;
+    }
+
+    /* 128 -> 64 bits */
+    x2 = _mm_clmulepi64_si128(x1, k, 0x10);
+    x1 = _mm_xor_si128(_mm_srli_si128(x1, 8), x2);
+
+    /* 64 -> 32 bits */
+    k = crc32_k128(CRC32_FOLD_64, 0);
+    x2 = _mm_srli_si128(x1, 4);
+    x1 = _mm_and_si128(x1, mask32);
+    x1 = _mm_clmulepi64_si128(x1, k, 0x00);
+    x1 = _mm_xor_si128(x1, x2);
+
+    /* Barrett reduction */
+    k = crc32_k128(CRC32_POLY_P, CRC32_POLY_MU);
+    x2 = _mm_and_si128(x1, mask32);
+    x2 = _mm_clmulepi64_si128(x2, k, 0x10);
+    x2 = _mm_and_si128(x2, mask32);
+    x2 = _mm_clmulepi64_si128(x2, k, 0x00);
+    x1 = _mm_xor_si128(x1, x2);
+
+    *bufp = buf;
+    *lenp = len;
+    return (uint32_t)_mm_extract_epi32(x1, 1);
+}
+
+__attribute__((target("pclmul,sse4.1")))
+uint32_t checksum_crc32_raw_pclmul(uint32_t crc, const unsigned char *buf, size_t len) {
+    __m128i x1, x2, x3, x4, k;
+
+    if (len < CRC32_PCLMUL_MIN) {
+        return checksum_crc32_raw_table(crc, buf, len);
+    }
+
+    x1 = _mm_loadu_si128((const __m128i *)(buf + 0x00));
+    x2 = _mm_loadu_si128((const __m128i *)(buf + 0x10));
+    x3 = _mm_loadu_si128((const __m128i *)(buf + 0x20));
+    x4 = _mm_loadu_si128((const __m128i *)(buf + 0x30));
+    x1 = _mm_xor_si128(x1, _mm_cvtsi32_si128((int)crc));
+    buf += 64;
+    len -= 64;
+
+    /* Four independent 128-bit accumulators hide the clmul latency */
+    k = crc32_k128(CRC32_FOLD_512);
+    while (len >= 64) {
+        x1 = fold128(x1, k, _mm_loadu_si128((const __m128i *)(buf + 0x00)));
+        x2 = fold128(x2, k, _mm_loadu_si128((const __m128i *)(buf + 0x10)));
+        x3 = fold128(x3, k, _mm_loadu_si128((const __m128i *)(buf + 0x20)));
+        x4 = fold128(x4, k, _mm_loadu_si128((const __m128i *)(buf + 0x30)));
+        buf += 64;
+        len -= 64;
+    }
+
+    k = crc32_k128(CRC32_FOLD_128);
+    x1 = fold128(x1, k, x2);
+    x1 = fold128(x1, k, x3);
+    x1 = fold128(x1, k, x4);
+
+    crc = crc32_reduce128(x1, &buf, &len);
+    return checksum_crc32_raw_table(crc, buf, len);
+}
+
+__attribute__((target("avx512f,avx512vl,vpclmulqdq,pclmul,sse4.1")))
+static inline __m512i fold512(__m512i acc, __m512i k, __m512i data) {
+    __m512i lo = _mm512_clmulepi64_epi128(acc, k, 0x00);
+    __m512i hi = _mm512_clmulepi64_epi128(acc, k, 0x11);
+    return _mm512_ternarylogic_epi64(lo, hi, data, 0x96);
+}
+
+__attribute__((target("avx512f,avx512vl,vpclmulqdq,pclmul,sse4.1")))
+uint32_t checksum_crc32_raw_vpclmul(uint32_t crc, const unsigned char *buf, size_t len) {
+    __m512i z0, z1, z2, z3, k;
+    __m128i x0, x1, x2, x3, k128;
+
+    if (len < CRC32_VPCLMUL_MIN) {
+        return checksum_crc32_raw_pclmul(crc, buf, len);
+    }
+
+    z0 = _mm512_loadu_si512((const void *)(buf + 0x00));
+    z1 = _mm512_loadu_si512((const void *)(buf + 0x40));
+    z2 = _mm512_loadu_si512((const void *)(buf + 0x80));
+    z3 = _mm512_loadu_si512((const void *)(buf + 0xc0));
+    z0 = _mm512_xor_si512(z0, _mm512_castsi128_si512(_mm_cvtsi32_si128((int)crc)));
+    buf += 256;
+    len -= 256;
+
+    /* 4 x 512-bit accumulators, each folded 2048 bits per iteration */
+    k = _mm512_broadcast_i32x4(crc32_k128(CRC32_FOLD_2048));
+    while (len >= 256) {
+        z0 = fold512(z0, k, _mm512_loadu_si512((const void *)(buf + 0x00)));
+        z1 = fold512(z1, k, _mm512_loadu_si512((const void *)(buf + 0x40)));
+        z2 = fold512(z2, k, _mm512_loadu_si512((const void *)(buf + 0x80)));
+        z3 = fold512(z3, k, _mm512_loadu_si512((const void *)(buf + 0xc0)));
+        buf += 256;
+        len -= 256;
+    }
+
+    k = _mm512_broadcast_i32x4(crc32_k128(CRC32_FOLD_512));
+    z0 = fold512(z0, k, z1);
+    z0 = fold512(z0, k, z2);
+    z0 = fold512(z0, k, z3);
+    while (len >= 64) {
+        z0 = fold512(z0, k, _mm512_loadu_si512((const void *)buf));
+        buf += 64;
+        len -= 64;
+    }
+
+    /* Collapse the four 128-bit lanes into one */
+    x0 = _mm512_extracti32x4_epi32(z0, 0);
+    x1 = _mm512_extracti32x4_epi32(z0, 1);
+    x2 = _mm512_extracti32x4_epi32(z0, 2);
+    x3 = _mm512_extracti32x4_epi32(z0, 3);
+
+    k128 = crc32_k128(CRC32_FOLD_384);
+    x3 = _mm_xor_si128(x3, fold128(x0, k128, _mm_setzero_si128()));
+    k128 = crc32_k128(CRC32_FOLD_256);
+    x3 = _mm_xor_si128(x3, fold128(x1, k128, _mm_setzero_si128()));
+    k128 = crc32_k128(CRC32_FOLD_128);
+    x3 = fold128(x2, k128, x3);
+
+    crc = crc32_reduce128(x3, &buf, &len);
+    return checksum_crc32_raw_table(crc, buf, len);
+}
+
+/* VEX-encoded VPCLMULQDQ for CPUs that have it without AVX-512 */
+__attribute__((target("avx2,vpclmulqdq,pclmul,sse4.1")))
+static inline __m256i fold256(__m256i acc, __m256i k, __m256i data) {
+    __m256i lo = _mm256_clmulepi64_epi128(acc, k, 0x00);
+    __m256i hi = _mm256_clmulepi64_epi128(acc, k, 0x11);
+    return _mm256_xor_si256(_mm256_xor_si256(lo, hi), data);
+}
+
+__attribute__((target("avx2,vpclmulqdq,pclmul,sse4.1")))
+uint32_t checksum_crc32_raw_vpclmul_avx2(uint32_t crc, const unsigned char *buf, size_t len) {
+    __m256i y0, y1, y2, y3, k;
+    __m128i x0;
+
+    if (len < CRC32_VPCLMUL_MIN) {
+        return checksum_crc32_raw_pclmul(crc, buf, len);
+    }
+
+    y0 = _mm256_loadu_si256((const __m256i *)(buf + 0x00));
+    y1 = _mm256_loadu_si256((const __m256i *)(buf + 0x20));
+    y2 = _mm256_loadu_si256((const __m256i *)(buf + 0x40));
+    y3 = _mm256_loadu_si256((const __m256i *)(buf + 0x60));
+    y0 = _mm256_xor_si256(y0, _mm256_castsi128_si256(_mm_cvtsi32_si128((int)crc)));
+    buf += 128;
+    len -= 128;
+
+    /* 4 x 256-bit accumulators, each folded 1024 bits per iteration */
+    k = _mm256_broadcastsi128_si256(crc32_k128(CRC32_FOLD_1024));
+    while (len >= 128) {
+        y0 = fold256(y0, k, _mm256_loadu_si256((const __m256i *)(buf + 0x00)));
+        y1 = fold256(y1, k, _mm256_loadu_si256((const __m256i *)(buf + 0x20)));
+        y2 = fold256(y2, k, _mm256_loadu_si256((const __m256i *)(buf + 0x40)));
+        y3 = fold256(y3, k, _mm256_loadu_si256((const __m256i *)(buf + 0x60)));
+        buf += 128;
+        len -= 128;
+    }
+
+    k = _mm256_broadcastsi128_si256(crc32_k128(CRC32_FOLD_256));
+    y0 = fold256(y0, k, y1);
+    y0 = fold256(y0, k, y2);
+    y0 = fold256(y0, k, y3);
+    while (len >= 32) {
+        y0 = fold256(y0, k, _mm256_loadu_si256((const __m256i *)buf));
+        buf += 32;
+        len -= 32;
+    }
+
+    /* Collapse the two 128-bit lanes into one */
+    x0 = fold128(_mm256_castsi256_si128(y0), crc32_k128(CRC32_FOLD_128),
+                 _mm256_extracti128_si256(y0, 1));
+
+    crc = crc32_reduce128(x0, &buf, &len);
+    return checksum_crc32_raw_table(crc, buf, len);
+}
+#endif /* CHECKSUM_HAVE_X86_SIMD */
+
+static crc32_update_fn crc32_resolve(void) {
+#if CHECKSUM_HAVE_X86_SIMD
+    unsigned int cpu = checksum_cpu_features();
+    const unsigned int need_vpclmul = CHECKSUM_CPU_VPCLMUL | CHECKSUM_CPU_AVX512F |
+                                      CHECKSUM_CPU_AVX512VL | CHECKSUM_CPU_SSE41;
+    const unsigned int need_vpclmul_avx2 = CHECKSUM_CPU_VPCLMUL | CHECKSUM_CPU_AVX2 |
+                                           CHECKSUM_CPU_SSE41;
+
+    /* 512-bit folds with AVX-512, otherwise 256-bit VPCLMULQDQ, then PCLMULQDQ */
+    if ((cpu & need_vpclmul) == need_vpclmul) {
+        return checksum_crc32_raw_vpclmul;
+    }
+    if ((cpu & need_vpclmul_avx2) == need_vpclmul_avx2) {
+        return checksum_crc32_raw_vpclmul_avx2;
+    }
+    if ((cpu & (CHECKSUM_CPU_PCLMUL | CHECKSUM_CPU_SSE41)) ==
+        (CHECKSUM_CPU_PCLMUL | CHECKSUM_CPU_SSE41)) {
+        return checksum_crc32_raw_pclmul;
+    }
+#endif
+    return checksum_crc32_raw_table;
+}
+
+uint32_t checksum_crc32_raw(uint32_t crc, const unsigned char *data, size_t len) {
+    static _Atomic(crc32_update_fn) impl;
+    crc32_update_fn fn = atomic_load_explicit(&impl, memory_order_relaxed);
+
+    if (!fn) {
+        fn = crc32_resolve();
+        atomic_store_explicit(&impl, fn, memory_order_relaxed);
+    }
+
+    return fn(crc, data, len);
+}
+
+/*
+ * GF(2) polynomial arithmetic modulo a reflected CRC polynomial, as used by
+ * zlib's crc32_combine(): bit 31 holds x^0, bit 0 holds x^31.
+ */
+uint32_t checksum_gf2_multmodp(uint32_t a, uint32_t b, uint32_t poly) {
+    uint32_t m = (uint32_t)1 << 31;
+    uint32_t p = 0;
+
+    while (a) {
+        if (a & m) {
+            p ^= b;
+            a ^= m;
+        }
+        m >>= 1;
+        b = (b & 1) ? (b >> 1) ^ poly : b >> 1;
+    }
+
+    return p;
+}
+
+uint32_t checksum_gf2_x8nmodp(uint64_t n, uint32_t poly) {
+    uint32_t p = (uint32_t)1 << 31;       /* x^0 */
+    uint32_t sq = (uint32_t)1 << 23;      /* x^8 */
+
+    while (n) {
+        if (n & 1) {
+            p = checksum_gf2_multmodp(sq, p, poly);
+        }
+        n >>= 1;
+        if (n) {
+            sq = checksum_gf2_multmodp(sq, sq, poly);
+        }
+    }
+
+    return p;
+}
+
+uint32_t checksum_crc32_raw_zeros(uint32_t crc, uint64_t len) {
+    return checksum_gf2_multmodp(checksum_gf2_x8nmodp(len, 0xedb88320U), crc, 0xedb88320U);
+}
+
+uint32_t checksum_crc32_combine(uint32_t crc1, uint32_t crc2, uint64_t len2) {
+    return checksum_gf2_multmodp(checksum_gf2_x8nmodp(len2, 0xedb88320U), crc1, 0xedb88320U) ^ crc2;
+}
+
+uint32_t checksum_crc32(const unsigned char *data, size_t len) {
+    return checksum_crc32_raw(0xffffffffU, data, len) ^ 0xffffffffU;
+}
+
+/* CRC32C (Castagnoli, reflected 0x82f63b78) */
+
+/* Stream lengths matching the crc32c_long/crc32c_short shift tables */
+#define CRC32C_LONG   8192
+#define CRC32C_SHORT  256
+
+uint32_t checksum_crc32c_raw_table(uint32_t crc, const unsigned char *buf, size_t len) {
+    return crc_slice16(crc32c_table, crc, buf, len);
+}
+
+#if CHECKSUM_HAVE_X86_SIMD
+#ifdef __x86_64__
+typedef uint64_t crc32c_word_t;
+#define crc32c_hw_word(c, p) ((uint32_t)_mm_crc32_u64((c), load_le64(p)))
+#else
+typedef uint32_t crc32c_word_t;
+#define crc32c_hw_word(c, p) _mm_crc32_u32((c), load_le32(p))
+#endif
+
+static inline uint64_t load_le64(const unsigned char *p) {
+    return (uint64_t)load_le32(p) | ((uint64_t)load_le32(p + 4) << 32);
+}
+
+/* Advance a CRC register over a fixed run of zero bytes via a shift table */
+static inline uint32_t crc32c_shift(const uint32_t table[4][256], uint32_t crc) {
+    return table[0][crc & 0xff] ^ table[1][(crc >> 8) & 0xff] ^
+           table[2][(crc >> 16) & 0xff] ^ table[3][crc >> 24];
+}
+
+/*
+ * Run three independent crc32 streams over consecutive stride-sized
+ * thirds of each 3 * stride block so the instruction's 3-cycle latency
+ * is hidden, then merge them: crc(A|B|C) = shift(shift(A) ^ B) ^ C.
+ */
+__attribute__((target("sse4.2")))
+static const unsigned char *crc32c_hw_streams(uint32_t *crcp, const unsigned char *buf,
+                                              size_t *lenp, size_t stride,
+                                              const uint32_t shift[4][256]) {
+    uint32_t crc0 = *crcp;
+    size_t len = *lenp;
+
+    while (len >= 3 * stride) {
+        uint32_t crc1 = 0, crc2 = 0;
+        const unsigned char *end = buf + stride;
+
+        do {
+            crc0 = crc32c_hw_word(crc0, buf);
+            crc1 = crc32c_hw_word(crc1, buf + stride);
+            crc2 = crc32c_hw_word(crc2, buf + 2 * stride);
+            buf += sizeof(crc32c_word_t);
+        } while (buf < end);
+
+        crc0 = crc32c_shift(shift, crc0) ^ crc1;
+        crc0 = crc32c_shift(shift, crc0) ^ crc2;
+        buf += 2 * stride;
+        len -= 3 * stride;
+    }
+
+    *crcp = crc0;
+    *lenp = len;
+    return buf;
+}
+
+__attribute__((target("sse4.2")))
+uint32_t checksum_crc32c_raw_sse42(uint32_t crc, const unsigned char *buf, size_t len) {
+    /* Align so the word loads don't straddle cache lines */
+    while (len && ((uintptr_t)buf & (sizeof(crc32c_word_t) - 1))) {
+        crc = _mm_crc32_u8(crc, *buf++);
+        len--;
+    }
+
+    buf = crc32c_hw_streams(&crc, buf, &len, CRC32C_LONG, crc32c_long);
+    buf = crc32c_hw_streams(&crc, buf, &len, CRC32C_SHORT, crc32c_short);
+
+    while (len >= sizeof(crc32c_word_t)) {
+        crc = crc32c_hw_word(crc, buf);
+        buf += sizeof(crc32c_word_t);
+        len -= sizeof(crc32c_word_t);
+    }
+    while (len--) {
+        crc = _mm_crc32_u8(crc, *buf++);
+    }
+
+    return crc;
+}
+#endif /* CHECKSUM_HAVE_X86_SIMD */
+
+static crc32_update_fn crc32c_resolve(void) {
+#if CHECKSUM_HAVE_X86_SIMD
+    if (checksum_cpu_features() & CHECKSUM_CPU_SSE42) {
+        return checksum_crc32c_raw_sse42;
+    }
+#endif
+    return checksum_crc32c_raw_table;
+}
+
+uint32_t checksum_crc32c_raw(uint32_t crc, const unsigned char *data, size_t len) {
+    static _Atomic(crc32_update_fn) impl;
+    crc32_update_fn fn = atomic_load_explicit(&impl, memory_order_relaxed);
+
+    if (!fn) {
+        fn = crc32c_resolve();
+        atomic_store_explicit(&impl, fn, memory_order_relaxed);
+    }
+
+    return fn(crc, data, len);
+}
+
+uint32_t checksum_crc32c_raw_zeros(uint32_t crc, uint64_t len) {
+    return checksum_gf2_multmodp(checksum_gf2_x8nmodp(len, 0x82f63b78U), crc, 0x82f63b78U);
+}
+
+uint32_t checksum_crc32c_combine(uint32_t crc1, uint32_t crc2, uint64_t len2) {
+    return checksum_gf2_multmodp(checksum_gf2_x8nmodp(len2, 0x82f63b78U), crc1, 0x82f63b78U) ^ crc2;
+}
+
+uint32_t checksum_crc32c(const unsigned char *data, size_t len) {
+    return checksum_crc32c_raw(0xffffffffU, data, len) ^ 0xffffffffU;
+}
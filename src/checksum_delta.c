@@ -0,0 +1,444 @@
+/*
+ * checksum_delta.c - rsync-style signatures, deltas and patching
+ *
+ * Copyright (c) 2025 AnmiTaliDev
+ * Created: 2025-08-09
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "checksum.h"
+
+/*
+ * Serialized forms, all integers little-endian:
+ *
+ *   signature: "CSUMSIG1" u32 block_size, u32 strong_len, u64 base_size,
+ *              then per block u32 weak, strong_len bytes strong
+ *   delta:     "CSUMDLT1" u32 block_size, u64 base_size, u64 new_size,
+ *              32-byte BLAKE3 of the new file, then operations:
+ *              'C' u64 offset, u64 length   copy from the base
+ *              'L' u64 length, bytes        literal data
+ *              'E'                          end
+ */
+#define SIG_MAGIC       "CSUMSIG1"
+#define DELTA_MAGIC     "CSUMDLT1"
+#define MAGIC_LEN       8
+#define SIG_HEADER      (MAGIC_LEN + 4 + 4 + 8)
+#define SIG_ENTRY       (4 + CHECKSUM_DELTA_STRONG)
+#define DELTA_HEADER    (MAGIC_LEN + 4 + 8 + 8 + CHECKSUM_BLAKE3_DIGEST)
+
+/* Automatic block size bounds, as rsync uses */
+#define BLOCK_MIN       700
+#define BLOCK_MAX       (128 * 1024)
+
+static void store_le32(unsigned char *p, uint32_t v) {
+    for (int i = 0; i < 4; i++) {
+        p[i] = (unsigned char)(v >> (8 * i));
+    }
+}
+
+static void store_le64(unsigned char *p, uint64_t v) {
+    for (int i = 0; i < 8; i++) {
+        p[i] = (unsigned char)(v >> (8 * i));
+    }
+}
+
+static uint32_t load_le32(const unsigned char *p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static uint64_t load_le64(const unsigned char *p) {
+    return (uint64_t)load_le32(p) | ((uint64_t)load_le32(p + 4) << 32);
+}
+
+static void strong_sum(const unsigned char *data, size_t len,
+                       unsigned char strong[CHECKSUM_DELTA_STRONG]) {
+    unsigned char digest[CHECKSUM_BLAKE3_DIGEST];
+
+    checksum_blake3(data, len, digest);
+    memcpy(strong, digest, CHECKSUM_DELTA_STRONG);
+}
+
+static size_t bucket_of(const checksum_signature_t *sig, uint32_t weak) {
+    uint32_t h = weak * 0x9e3779b1U;
+
+    return (h ^ (h >> 16)) & sig->mask;
+}
+
+static size_t block_length(const checksum_signature_t *sig, size_t block) {
+    uint64_t start = (uint64_t)block * sig->block_size;
+
+    return sig->base_size - start < sig->block_size ? (size_t)(sig->base_size - start)
+                                                    : sig->block_size;
+}
+
+/* Allocate per-block arrays for sig->count blocks */
+static int signature_alloc(checksum_signature_t *sig) {
+    size_t buckets = 16;
+
+    while (buckets < 2 * sig->count) {
+        buckets *= 2;
+    }
+    sig->mask = buckets - 1;
+    sig->weak = malloc((sig->count ? sig->count : 1) * sizeof(*sig->weak));
+    sig->strong = malloc((sig->count ? sig->count : 1) * CHECKSUM_DELTA_STRONG);
+    sig->chain = malloc((sig->count ? sig->count : 1) * sizeof(*sig->chain));
+    sig->buckets = calloc(buckets, sizeof(*sig->buckets));
+    if (!sig->weak || !sig->strong || !sig->chain || !sig->buckets) {
+        checksum_signature_free(sig);
+        return CHECKSUM_ERROR_MEM;
+    }
+    return CHECKSUM_SUCCESS;
+}
+
+/* Chain blocks by weak sum; inserting backwards keeps the first block first */
+static void signature_index(checksum_signature_t *sig) {
+    for (size_t i = sig->count; i-- > 0;) {
+        size_t b = bucket_of(sig, sig->weak[i]);
+
+        sig->chain[i] = sig->buckets[b];
+        sig->buckets[b] = (uint32_t)(i + 1);
+    }
+}
+
+/* Count blocks, rejecting sizes whose block indices would not fit the table */
+static int signature_count(checksum_signature_t *sig) {
+    uint64_t count = sig->base_size / sig->block_size + (sig->base_size % sig->block_size != 0);
+
+    if (count >= UINT32_MAX || count > SIZE_MAX / SIG_ENTRY) {
+        return CHECKSUM_ERROR_ARG;
+    }
+    sig->count = (size_t)count;
+    return CHECKSUM_SUCCESS;
+}
+
+int checksum_signature_build(checksum_signature_t *sig, const unsigned char *base, size_t len,
+                             uint32_t block_size) {
+    int err;
+
+    if (!sig || (len > 0 && !base)) {
+        return CHECKSUM_ERROR_ARG;
+    }
+
+    if (block_size == 0) {
+        /* About sqrt(len) blocks of sqrt(len) bytes, rounded to 8 */
+        uint64_t size = BLOCK_MIN;
+
+        while (size * size < len && size < BLOCK_MAX) {
+            size *= 2;
+        }
+        block_size = (uint32_t)(size & ~(uint64_t)7);
+    }
+
+    memset(sig, 0, sizeof(*sig));
+    sig->block_size = block_size;
+    sig->base_size = len;
+    err = signature_count(sig);
+    if (err == CHECKSUM_SUCCESS) {
+        err = signature_alloc(sig);
+    }
+    if (err != CHECKSUM_SUCCESS) {
+        return err;
+    }
+
+    for (size_t i = 0; i < sig->count; i++) {
+        const unsigned char *block = base + i * (size_t)block_size;
+        size_t n = block_length(sig, i);
+
+        sig->weak[i] = checksum_adler32(block, n);
+        strong_sum(block, n, sig->strong + i * CHECKSUM_DELTA_STRONG);
+    }
+    signature_index(sig);
+    return CHECKSUM_SUCCESS;
+}
+
+int checksum_signature_write(const checksum_signature_t *sig, checksum_write_fn write, void *ctx) {
+    unsigned char header[SIG_HEADER];
+    unsigned char entry[SIG_ENTRY];
+
+    memcpy(header, SIG_MAGIC, MAGIC_LEN);
+    store_le32(header + MAGIC_LEN, sig->block_size);
+    store_le32(header + MAGIC_LEN + 4, CHECKSUM_DELTA_STRONG);
+    store_le64(header + MAGIC_LEN + 8, sig->base_size);
+    if (write(ctx, header, sizeof(header)) != 0) {
+        return CHECKSUM_ERROR_IO;
+    }
+
+    for (size_t i = 0; i < sig->count; i++) {
+        store_le32(entry, sig->weak[i]);
+        memcpy(entry + 4, sig->strong + i * CHECKSUM_DELTA_STRONG, CHECKSUM_DELTA_STRONG);
+        if (write(ctx, entry, sizeof(entry)) != 0) {
+            return CHECKSUM_ERROR_IO;
+        }
+    }
+    return CHECKSUM_SUCCESS;
+}
+
+int checksum_signature_load(checksum_signature_t *sig, const void *data, size_t len) {
+    const unsigned char *p = data;
+    int err;
+
+    if (!sig || (len > 0 && !data)) {
+        return CHECKSUM_ERROR_ARG;
+    }
+    memset(sig, 0, sizeof(*sig));
+    if (len < SIG_HEADER || memcmp(p, SIG_MAGIC, MAGIC_LEN) != 0 ||
+        load_le32(p + MAGIC_LEN + 4) != CHECKSUM_DELTA_STRONG) {
+        return CHECKSUM_ERROR_DATA;
+    }
+
+    sig->block_size = load_le32(p + MAGIC_LEN);
+    sig->base_size = load_le64(p + MAGIC_LEN + 8);
+    if (sig->block_size == 0 || signature_count(sig) != CHECKSUM_SUCCESS ||
+        (len - SIG_HEADER) / SIG_ENTRY != sig->count || (len - SIG_HEADER) % SIG_ENTRY != 0) {
+        return CHECKSUM_ERROR_DATA;
+    }
+
+    err = signature_alloc(sig);
+    if (err != CHECKSUM_SUCCESS) {
+        return err;
+    }
+    p += SIG_HEADER;
+    for (size_t i = 0; i < sig->count; i++, p += SIG_ENTRY) {
+        sig->weak[i] = load_le32(p);
+        memcpy(sig->strong + i * CHECKSUM_DELTA_STRONG, p + 4, CHECKSUM_DELTA_STRONG);
+    }
+    signature_index(sig);
+    return CHECKSUM_SUCCESS;
+}
+
+void checksum_signature_free(checksum_signature_t *sig) {
+    if (!sig) {
+        return;
+    }
+    free(sig->weak);
+    free(sig->strong);
+    free(sig->chain);
+    free(sig->buckets);
+    sig->weak = NULL;
+    sig->strong = NULL;
+    sig->chain = NULL;
+    sig->buckets = NULL;
+    sig->count = 0;
+}
+
+/* Delta output: adjacent copies are merged before they are written */
+typedef struct {
+    checksum_write_fn write;
+    void *ctx;
+    int failed;
+    uint64_t copy_offset;
+    uint64_t copy_length;
+} delta_out_t;
+
+static void put(delta_out_t *out, const void *data, size_t len) {
+    if (!out->failed && len > 0 && out->write(out->ctx, data, len) != 0) {
+        out->failed = 1;
+    }
+}
+
+static void flush_copy(delta_out_t *out) {
+    unsigned char op[17];
+
+    if (out->copy_length == 0) {
+        return;
+    }
+    op[0] = 'C';
+    store_le64(op + 1, out->copy_offset);
+    store_le64(op + 9, out->copy_length);
+    put(out, op, sizeof(op));
+    out->copy_length = 0;
+}
+
+static void emit_copy(delta_out_t *out, uint64_t offset, uint64_t length) {
+    if (out->copy_length > 0 && out->copy_offset + out->copy_length == offset) {
+        out->copy_length += length;
+        return;
+    }
+    flush_copy(out);
+    out->copy_offset = offset;
+    out->copy_length = length;
+}
+
+static void emit_literal(delta_out_t *out, const unsigned char *data, size_t len) {
+    unsigned char op[9];
+
+    if (len == 0) {
+        return;
+    }
+    flush_copy(out);
+    op[0] = 'L';
+    store_le64(op + 1, len);
+    put(out, op, sizeof(op));
+    put(out, data, len);
+}
+
+/* Find a base block of length len matching data; the strong sum is lazy */
+static long find_block(const checksum_signature_t *sig, uint32_t weak,
+                       const unsigned char *data, size_t len) {
+    unsigned char strong[CHECKSUM_DELTA_STRONG];
+    int have_strong = 0;
+
+    for (uint32_t i = sig->buckets[bucket_of(sig, weak)]; i != 0; i = sig->chain[i - 1]) {
+        size_t block = i - 1;
+
+        if (sig->weak[block] != weak || block_length(sig, block) != len) {
+            continue;
+        }
+        if (!have_strong) {
+            strong_sum(data, len, strong);
+            have_strong = 1;
+        }
+        if (memcmp(strong, sig->strong + block * CHECKSUM_DELTA_STRONG,
+                   CHECKSUM_DELTA_STRONG) == 0) {
+            return (long)block;
+        }
+    }
+    return -1;
+}
+
+int checksum_delta(const checksum_signature_t *sig, const unsigned char *data, size_t len,
+                   checksum_write_fn write, void *ctx) {
+    delta_out_t out = {write, ctx, 0, 0, 0};
+    unsigned char header[DELTA_HEADER];
+    size_t bs, pos = 0, literal = 0;
+    size_t tail;
+    uint32_t weak = 0;
+    int have_weak = 0;
+
+    if (!sig || !write || (len > 0 && !data)) {
+        return CHECKSUM_ERROR_ARG;
+    }
+    bs = sig->block_size;
+
+    memcpy(header, DELTA_MAGIC, MAGIC_LEN);
+    store_le32(header + MAGIC_LEN, sig->block_size);
+    store_le64(header + MAGIC_LEN + 4, sig->base_size);
+    store_le64(header + MAGIC_LEN + 12, len);
+    checksum_blake3(data, len, header + MAGIC_LEN + 20);
+    put(&out, header, sizeof(header));
+
+    /* Slide a block-sized window, jumping a whole block on every match */
+    while (sig->count > 0 && len - pos >= bs) {
+        long block;
+
+        if (!have_weak) {
+            weak = checksum_adler32(data + pos, bs);
+            have_weak = 1;
+        }
+
+        block = find_block(sig, weak, data + pos, bs);
+        if (block >= 0) {
+            emit_literal(&out, data + literal, pos - literal);
+            emit_copy(&out, (uint64_t)block * bs, bs);
+            pos += bs;
+            literal = pos;
+            have_weak = 0;
+            continue;
+        }
+
+        if (len - pos > bs) {
+            weak = checksum_adler32_roll(weak, data[pos], data[pos + bs], bs);
+        }
+        pos++;
+    }
+
+    /* The base's short last block can only match the new file's tail */
+    tail = len - pos;
+    if (sig->count > 0 && tail > 0 && tail == block_length(sig, sig->count - 1) && tail < bs &&
+        find_block(sig, checksum_adler32(data + pos, tail), data + pos, tail) >= 0) {
+        emit_literal(&out, data + literal, pos - literal);
+        emit_copy(&out, (uint64_t)(sig->count - 1) * bs, tail);
+        literal = len;
+    }
+
+    emit_literal(&out, data + literal, len - literal);
+    flush_copy(&out);
+    put(&out, "E", 1);
+    return out.failed ? CHECKSUM_ERROR_IO : CHECKSUM_SUCCESS;
+}
+
+int checksum_patch(const unsigned char *base, size_t base_len, const unsigned char *delta,
+                   size_t delta_len, checksum_write_fn write, void *ctx) {
+    const unsigned char *p = delta;
+    const unsigned char *end = delta + delta_len;
+    unsigned char digest[CHECKSUM_BLAKE3_DIGEST];
+    checksum_blake3_ctx_t hash;
+    uint64_t new_size, produced = 0;
+
+    if (!write || (base_len > 0 && !base) || (delta_len > 0 && !delta)) {
+        return CHECKSUM_ERROR_ARG;
+    }
+    if (delta_len < DELTA_HEADER || memcmp(p, DELTA_MAGIC, MAGIC_LEN) != 0 ||
+        load_le64(p + MAGIC_LEN + 4) != base_len) {
+        return CHECKSUM_ERROR_DATA;
+    }
+    new_size = load_le64(p + MAGIC_LEN + 12);
+    p += DELTA_HEADER;
+
+    checksum_blake3_init(&hash);
+    for (;;) {
+        const unsigned char *src;
+        uint64_t length;
+
+        if (p == end) {
+            return CHECKSUM_ERROR_DATA;
+        }
+        if (*p == 'E') {
+            p++;
+            break;
+        }
+
+        if (*p == 'C' && end - p >= 17) {
+            uint64_t offset = load_le64(p + 1);
+
+            length = load_le64(p + 9);
+            if (offset > base_len || length > base_len - offset) {
+                return CHECKSUM_ERROR_DATA;
+            }
+            src = base + offset;
+            p += 17;
+        } else if (*p == 'L' && end - p >= 9) {
+            length = load_le64(p + 1);
+            if (length > (uint64_t)(end - p) - 9) {
+                return CHECKSUM_ERROR_DATA;
+            }
+            src = p + 9;
+            p += 9 + length;
+        } else {
+            return CHECKSUM_ERROR_DATA;
+        }
+
+        if (length > new_size - produced) {
+            return CHECKSUM_ERROR_DATA;
+        }
+        checksum_blake3_update(&hash, src, (size_t)length);
+        if (length > 0 && write(ctx, src, (size_t)length) != 0) {
+            return CHECKSUM_ERROR_IO;
+        }
+        produced += length;
+    }
+
+    checksum_blake3_final(&hash, digest);
+    if (p != end || produced != new_size ||
+        memcmp(digest, delta + MAGIC_LEN + 20, CHECKSUM_BLAKE3_DIGEST) != 0) {
+        return CHECKSUM_ERROR_DATA;
+    }
+    return CHECKSUM_SUCCESS;
+}
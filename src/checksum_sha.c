@@ -0,0 +1,323 @@
+/*
+ * checksum_sha.c - SHA-1 and SHA-256 block functions with runtime dispatch
+ *
+ * Copyright (c) 2025 AnmiTaliDev
+ * Created: 2025-08-09
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdatomic.h>
+
+#include "checksum.h"
+#include "checksum_kernels.h"
+
+#if CHECKSUM_HAVE_X86_SIMD
+#include <immintrin.h>
+#endif
+
+typedef void (*sha_blocks_fn)(uint32_t *state, const unsigned char *data, size_t blocks);
+
+static const uint32_t sha256_k[64] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+};
+
+static inline uint32_t load_be32(const unsigned char *p) {
+    return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | p[3];
+}
+
+static inline uint32_t rotl32(uint32_t x, int n) {
+    return (x << n) | (x >> (32 - n));
+}
+
+static inline uint32_t rotr32(uint32_t x, int n) {
+    return (x >> n) | (x << (32 - n));
+}
+
+/* SHA-256 (FIPS 180-4) */
+
+void checksum_sha256_blocks_scalar(uint32_t *state, const unsigned char *data, size_t blocks) {
+    uint32_t w[64];
+
+    while (blocks--) {
+        uint32_t a = state[0], b = state[1], c = state[2], d = state[3];
+        uint32_t e = state[4], f = state[5], g = state[6], h = state[7];
+
+        for (int i = 0; i < 16; i++) {
+            w[i] = load_be32(data + 4 * i);
+        }
+        for (int i = 16; i < 64; i++) {
+            uint32_t s0 = rotr32(w[i - 15], 7) ^ rotr32(w[i - 15], 18) ^ (w[i - 15] >> 3);
+            uint32_t s1 = rotr32(w[i - 2], 17) ^ rotr32(w[i - 2], 19) ^ (w[i - 2] >> 10);
+
+            w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+        }
+
+        for (int i = 0; i < 64; i++) {
+            uint32_t s1 = rotr32(e, 6) ^ rotr32(e, 11) ^ rotr32(e, 25);
+            uint32_t ch = (e & f) ^ (~e & g);
+            uint32_t t1 = h + s1 + ch + sha256_k[i] + w[i];
+            uint32_t s0 = rotr32(a, 2) ^ rotr32(a, 13) ^ rotr32(a, 22);
+            uint32_t maj = (a & b) ^ (a & c) ^ (b & c);
+
+            h = g;
+            g = f;
+            f = e;
+            e = d + t1;
+            d = c;
+            c = b;
+            b = a;
+            a = t1 + s0 + maj;
+        }
+
+        state[0] += a; state[1] += b; state[2] += c; state[3] += d;
+        state[4] += e; state[5] += f; state[6] += g; state[7] += h;
+        data += 64;
+    }
+}
+
+#if CHECKSUM_HAVE_X86_SIMD
+/*
+ * Four rounds of SHA-256 on the message words in `cur`, interleaved with
+ * the schedule: msg2 finishes W[4g+4..4g+7] in `next`, msg1 starts the
+ * words that will replace `prev`. g is a literal, so the range checks fold.
+ */
+#define SHA256_QUAD(g, cur, prev, next) do { \
+    __m128i msg_ = _mm_add_epi32(cur, _mm_loadu_si128((const __m128i *)&sha256_k[4 * (g)])); \
+    state1 = _mm_sha256rnds2_epu32(state1, state0, msg_); \
+    if ((g) >= 3 && (g) <= 14) { \
+        next = _mm_add_epi32(next, _mm_alignr_epi8(cur, prev, 4)); \
+        next = _mm_sha256msg2_epu32(next, cur); \
+    } \
+    msg_ = _mm_shuffle_epi32(msg_, 0x0e); \
+    state0 = _mm_sha256rnds2_epu32(state0, state1, msg_); \
+    if ((g) >= 1 && (g) <= 12) { \
+        prev = _mm_sha256msg1_epu32(prev, cur); \
+    } \
+} while (0)
+
+__attribute__((target("sha,sse4.1")))
+void checksum_sha256_blocks_shani(uint32_t *state, const unsigned char *data, size_t blocks) {
+    const __m128i bswap = _mm_set_epi64x(0x0c0d0e0f08090a0bULL, 0x0405060700010203ULL);
+    __m128i state0, state1, tmp;
+
+    /* The rnds2 instruction wants the state as ABEF / CDGH */
+    tmp = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i *)&state[0]), 0xb1);
+    state1 = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i *)&state[4]), 0x1b);
+    state0 = _mm_alignr_epi8(tmp, state1, 8);
+    state1 = _mm_blend_epi16(state1, tmp, 0xf0);
+
+    while (blocks--) {
+        __m128i abef = state0, cdgh = state1;
+        __m128i m0 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(data + 0)), bswap);
+        __m128i m1 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(data + 16)), bswap);
+        __m128i m2 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(data + 32)), bswap);
+        __m128i m3 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(data + 48)), bswap);
+
+        SHA256_QUAD(0, m0, m3, m1);
+        SHA256_QUAD(1, m1, m0, m2);
+        SHA256_QUAD(2, m2, m1, m3);
+        SHA256_QUAD(3, m3, m2, m0);
+        SHA256_QUAD(4, m0, m3, m1);
+        SHA256_QUAD(5, m1, m0, m2);
+        SHA256_QUAD(6, m2, m1, m3);
+        SHA256_QUAD(7, m3, m2, m0);
+        SHA256_QUAD(8, m0, m3, m1);
+        SHA256_QUAD(9, m1, m0, m2);
+        SHA256_QUAD(10, m2, m1, m3);
+        SHA256_QUAD(11, m3, m2, m0);
+        SHA256_QUAD(12, m0, m3, m1);
+        SHA256_QUAD(13, m1, m0, m2);
+        SHA256_QUAD(14, m2, m1, m3);
+        SHA256_QUAD(15, m3, m2, m0);
+
+        state0 = _mm_add_epi32(state0, abef);
+        state1 = _mm_add_epi32(state1, cdgh);
+        data += 64;
+    }
+
+    tmp = _mm_shuffle_epi32(state0, 0x1b);
+    state1 = _mm_shuffle_epi32(state1, 0xb1);
+    state0 = _mm_blend_epi16(tmp, state1, 0xf0);
+    state1 = _mm_alignr_epi8(state1, tmp, 8);
+    _mm_storeu_si128((__m128i *)&state[0], state0);
+    _mm_storeu_si128((__m128i *)&state[4], state1);
+}
+#endif /* CHECKSUM_HAVE_X86_SIMD */
+
+static sha_blocks_fn sha256_resolve(void) {
+#if CHECKSUM_HAVE_X86_SIMD
+    unsigned int cpu = checksum_cpu_features();
+
+    if ((cpu & CHECKSUM_CPU_SHA) && (cpu & CHECKSUM_CPU_SSE41)) {
+        return checksum_sha256_blocks_shani;
+    }
+#endif
+    return checksum_sha256_blocks_scalar;
+}
+
+void checksum_sha256_blocks(uint32_t *state, const unsigned char *data, size_t blocks) {
+    static _Atomic(sha_blocks_fn) impl;
+    sha_blocks_fn fn = atomic_load_explicit(&impl, memory_order_relaxed);
+
+    if (!fn) {
+        fn = sha256_resolve();
+        atomic_store_explicit(&impl, fn, memory_order_relaxed);
+    }
+
+    fn(state, data, blocks);
+}
+
+/* SHA-1, kept for verifying legacy manifests */
+
+void checksum_sha1_blocks_scalar(uint32_t *state, const unsigned char *data, size_t blocks) {
+    uint32_t w[80];
+
+    while (blocks--) {
+        uint32_t a = state[0], b = state[1], c = state[2], d = state[3], e = state[4];
+
+        for (int i = 0; i < 16; i++) {
+            w[i] = load_be32(data + 4 * i);
+        }
+        for (int i = 16; i < 80; i++) {
+            w[i] = rotl32(w[i - 3] ^ w[i - 8] ^ w[i - 14] ^ w[i - 16], 1);
+        }
+
+        for (int i = 0; i < 80; i++) {
+            uint32_t f, k, t;
+
+            if (i < 20) {
+                f = (b & c) | (~b & d);
+                k = 0x5a827999;
+            } else if (i < 40) {
+                f = b ^ c ^ d;
+                k = 0x6ed9eba1;
+            } else if (i < 60) {
+                f = (b & c) | (b & d) | (c & d);
+                k = 0x8f1bbcdc;
+            } else {
+                f = b ^ c ^ d;
+                k = 0xca62c1d6;
+            }
+
+            t = rotl32(a, 5) + f + e + k + w[i];
+            e = d;
+            d = c;
+            c = rotl32(b, 30);
+            b = a;
+            a = t;
+        }
+
+        state[0] += a; state[1] += b; state[2] += c; state[3] += d; state[4] += e;
+        data += 64;
+    }
+}
+
+#if CHECKSUM_HAVE_X86_SIMD
+/*
+ * Four rounds of SHA-1 on the message words in `cur`. The E value
+ * alternates between two registers; the schedule for later groups is
+ * advanced with msg1/xor/msg2 in the same pattern as SHA256_QUAD.
+ */
+#define SHA1_QUAD(g, e_cur, e_next, cur, prev, prev2, next) do { \
+    e_cur = (g) == 0 ? _mm_add_epi32(e_cur, cur) : _mm_sha1nexte_epu32(e_cur, cur); \
+    e_next = abcd; \
+    if ((g) >= 3 && (g) <= 18) { \
+        next = _mm_sha1msg2_epu32(next, cur); \
+    } \
+    abcd = _mm_sha1rnds4_epu32(abcd, e_cur, (g) / 5); \
+    if ((g) >= 1 && (g) <= 16) { \
+        prev = _mm_sha1msg1_epu32(prev, cur); \
+    } \
+    if ((g) >= 2 && (g) <= 17) { \
+        prev2 = _mm_xor_si128(prev2, cur); \
+    } \
+} while (0)
+
+__attribute__((target("sha,sse4.1")))
+void checksum_sha1_blocks_shani(uint32_t *state, const unsigned char *data, size_t blocks) {
+    const __m128i bswap = _mm_set_epi64x(0x0001020304050607ULL, 0x08090a0b0c0d0e0fULL);
+    __m128i abcd = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i *)state), 0x1b);
+    __m128i e0 = _mm_set_epi32((int)state[4], 0, 0, 0);
+    __m128i e1;
+
+    while (blocks--) {
+        __m128i abcd_save = abcd, e0_save = e0;
+        __m128i m0 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(data + 0)), bswap);
+        __m128i m1 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(data + 16)), bswap);
+        __m128i m2 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(data + 32)), bswap);
+        __m128i m3 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(data + 48)), bswap);
+
+        SHA1_QUAD(0, e0, e1, m0, m3, m2, m1);
+        SHA1_QUAD(1, e1, e0, m1, m0, m3, m2);
+        SHA1_QUAD(2, e0, e1, m2, m1, m0, m3);
+        SHA1_QUAD(3, e1, e0, m3, m2, m1, m0);
+        SHA1_QUAD(4, e0, e1, m0, m3, m2, m1);
+        SHA1_QUAD(5, e1, e0, m1, m0, m3, m2);
+        SHA1_QUAD(6, e0, e1, m2, m1, m0, m3);
+        SHA1_QUAD(7, e1, e0, m3, m2, m1, m0);
+        SHA1_QUAD(8, e0, e1, m0, m3, m2, m1);
+        SHA1_QUAD(9, e1, e0, m1, m0, m3, m2);
+        SHA1_QUAD(10, e0, e1, m2, m1, m0, m3);
+        SHA1_QUAD(11, e1, e0, m3, m2, m1, m0);
+        SHA1_QUAD(12, e0, e1, m0, m3, m2, m1);
+        SHA1_QUAD(13, e1, e0, m1, m0, m3, m2);
+        SHA1_QUAD(14, e0, e1, m2, m1, m0, m3);
+        SHA1_QUAD(15, e1, e0, m3, m2, m1, m0);
+        SHA1_QUAD(16, e0, e1, m0, m3, m2, m1);
+        SHA1_QUAD(17, e1, e0, m1, m0, m3, m2);
+        SHA1_QUAD(18, e0, e1, m2, m1, m0, m3);
+        SHA1_QUAD(19, e1, e0, m3, m2, m1, m0);
+
+        e0 = _mm_sha1nexte_epu32(e0, e0_save);
+        abcd = _mm_add_epi32(abcd, abcd_save);
+        data += 64;
+    }
+
+    _mm_storeu_si128((__m128i *)state, _mm_shuffle_epi32(abcd, 0x1b));
+    state[4] = (uint32_t)_mm_extract_epi32(e0, 3);
+}
+#endif /* CHECKSUM_HAVE_X86_SIMD */
+
+static sha_blocks_fn sha1_resolve(void) {
+#if CHECKSUM_HAVE_X86_SIMD
+    unsigned int cpu = checksum_cpu_features();
+
+    if ((cpu & CHECKSUM_CPU_SHA) && (cpu & CHECKSUM_CPU_SSE41)) {
+        return checksum_sha1_blocks_shani;
+    }
+#endif
+    return checksum_sha1_blocks_scalar;
+}
+
+void checksum_sha1_blocks(uint32_t *state, const unsigned char *data, size_t blocks) {
+    static _Atomic(sha_blocks_fn) impl;
+    sha_blocks_fn fn = atomic_load_explicit(&impl, memory_order_relaxed);
+
+    if (!fn) {
+        fn = sha1_resolve();
+        atomic_store_explicit(&impl, fn, memory_order_relaxed);
+    }
+
+    fn(state, data, blocks);
+}
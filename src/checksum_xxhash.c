@@ -0,0 +1,774 @@
+/*
+ * checksum_xxhash.c - XXH64 and XXH3 (64/128-bit) with vectorized accumulators
+ *
+ * Copyright (c) 2025 AnmiTaliDev
+ * Created: 2025-08-09
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <stdatomic.h>
+
+#include "checksum.h"
+#include "checksum_kernels.h"
+
+#if CHECKSUM_HAVE_X86_SIMD
+#include <immintrin.h>
+#endif
+
+#define PRIME32_1  0x9e3779b1U
+#define PRIME32_2  0x85ebca77U
+#define PRIME32_3  0xc2b2ae3dU
+#define PRIME64_1  0x9e3779b185ebca87ULL
+#define PRIME64_2  0xc2b2ae3d27d4eb4fULL
+#define PRIME64_3  0x165667b19e3779f9ULL
+#define PRIME64_4  0x85ebca77c2b2ae63ULL
+#define PRIME64_5  0x27d4eb2f165667c5ULL
+#define PRIME_MX1  0x165667919e3779f9ULL
+#define PRIME_MX2  0x9fb21c651e98df25ULL
+
+/* XXH3 geometry for the default 192-byte secret */
+#define XXH3_SECRET_SIZE      192
+#define XXH3_STRIPE_LEN       64
+#define XXH3_SECRET_RATE      8       /* secret bytes advanced per stripe */
+#define XXH3_STRIPES_PER_BLOCK ((XXH3_SECRET_SIZE - XXH3_STRIPE_LEN) / XXH3_SECRET_RATE)
+#define XXH3_BLOCK_LEN        (XXH3_STRIPE_LEN * XXH3_STRIPES_PER_BLOCK)
+#define XXH3_MIDSIZE_MAX      240
+#define XXH3_BUFFER_STRIPES   (CHECKSUM_XXH3_BUFFER / XXH3_STRIPE_LEN)
+
+static const unsigned char xxh3_secret[XXH3_SECRET_SIZE] = {
+    0xb8, 0xfe, 0x6c, 0x39, 0x23, 0xa4, 0x4b, 0xbe, 0x7c, 0x01, 0x81, 0x2c, 0xf7, 0x21, 0xad, 0x1c,
+    0xde, 0xd4, 0x6d, 0xe9, 0x83, 0x90, 0x97, 0xdb, 0x72, 0x40, 0xa4, 0xa4, 0xb7, 0xb3, 0x67, 0x1f,
+    0xcb, 0x79, 0xe6, 0x4e, 0xcc, 0xc0, 0xe5, 0x78, 0x82, 0x5a, 0xd0, 0x7d, 0xcc, 0xff, 0x72, 0x21,
+    0xb8, 0x08, 0x46, 0x74, 0xf7, 0x43, 0x24, 0x8e, 0xe0, 0x35, 0x90, 0xe6, 0x81, 0x3a, 0x26, 0x4c,
+    0x3c, 0x28, 0x52, 0xbb, 0x91, 0xc3, 0x00, 0xcb, 0x88, 0xd0, 0x65, 0x8b, 0x1b, 0x53, 0x2e, 0xa3,
+    0x71, 0x64, 0x48, 0x97, 0xa2, 0x0d, 0xf9, 0x4e, 0x38, 0x19, 0xef, 0x46, 0xa9, 0xde, 0xac, 0xd8,
+    0xa8, 0xfa, 0x76, 0x3f, 0xe3, 0x9c, 0x34, 0x3f, 0xf9, 0xdc, 0xbb, 0xc7, 0xc7, 0x0b, 0x4f, 0x1d,
+    0x8a, 0x51, 0xe0, 0x4b, 0xcd, 0xb4, 0x59, 0x31, 0xc8, 0x9f, 0x7e, 0xc9, 0xd9, 0x78, 0x73, 0x64,
+    0xea, 0xc5, 0xac, 0x83, 0x34, 0xd3, 0xeb, 0xc3, 0xc5, 0x81, 0xa0, 0xff, 0xfa, 0x13, 0x63, 0xeb,
+    0x17, 0x0d, 0xdd, 0x51, 0xb7, 0xf0, 0xda, 0x49, 0xd3, 0x16, 0x55, 0x26, 0x29, 0xd4, 0x68, 0x9e,
+    0x2b, 0x16, 0xbe, 0x58, 0x7d, 0x47, 0xa1, 0xfc, 0x8f, 0xf8, 0xb8, 0xd1, 0x7a, 0xd0, 0x31, 0xce,
+    0x45, 0xcb, 0x3a, 0x8f, 0x95, 0x16, 0x04, 0x28, 0xaf, 0xd7, 0xfb, 0xca, 0xbb, 0x4b, 0x40, 0x7e,
+};
+
+typedef void (*xxh3_accumulate_fn)(uint64_t acc[8], const unsigned char *input,
+                                   const unsigned char *secret, size_t stripes);
+typedef void (*xxh3_scramble_fn)(uint64_t acc[8], const unsigned char *secret);
+
+typedef struct {
+    xxh3_accumulate_fn accumulate;
+    xxh3_scramble_fn scramble;
+} xxh3_impl_t;
+
+typedef struct {
+    uint64_t low;
+    uint64_t high;
+} xxh_u128_t;
+
+static inline uint32_t read_le32(const unsigned char *p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static inline uint64_t read_le64(const unsigned char *p) {
+    return (uint64_t)read_le32(p) | ((uint64_t)read_le32(p + 4) << 32);
+}
+
+static inline uint64_t rotl64(uint64_t x, int n) {
+    return (x << n) | (x >> (64 - n));
+}
+
+static inline uint32_t rotl32(uint32_t x, int n) {
+    return (x << n) | (x >> (32 - n));
+}
+
+static inline uint32_t swap32(uint32_t x) {
+    return ((x << 24) & 0xff000000U) | ((x << 8) & 0x00ff0000U) |
+           ((x >> 8) & 0x0000ff00U) | ((x >> 24) & 0x000000ffU);
+}
+
+static inline uint64_t swap64(uint64_t x) {
+    return ((uint64_t)swap32((uint32_t)x) << 32) | swap32((uint32_t)(x >> 32));
+}
+
+#if defined(__SIZEOF_INT128__)
+__extension__ typedef unsigned __int128 xxh_uint128;
+#endif
+
+static inline xxh_u128_t mult64to128(uint64_t a, uint64_t b) {
+    xxh_u128_t r;
+#if defined(__SIZEOF_INT128__)
+    xxh_uint128 p = (xxh_uint128)a * b;
+
+    r.low = (uint64_t)p;
+    r.high = (uint64_t)(p >> 64);
+#else
+    uint64_t lo_lo = (a & 0xffffffff) * (b & 0xffffffff);
+    uint64_t hi_lo = (a >> 32) * (b & 0xffffffff);
+    uint64_t lo_hi = (a & 0xffffffff) * (b >> 32);
+    uint64_t hi_hi = (a >> 32) * (b >> 32);
+    uint64_t cross = (lo_lo >> 32) + (hi_lo & 0xffffffff) + lo_hi;
+
+    r.high = (hi_lo >> 32) + (cross >> 32) + hi_hi;
+    r.low = (cross << 32) | (lo_lo & 0xffffffff);
+#endif
+    return r;
+}
+
+static inline uint64_t mul128_fold64(uint64_t a, uint64_t b) {
+    xxh_u128_t p = mult64to128(a, b);
+
+    return p.low ^ p.high;
+}
+
+/* XXH64 */
+
+static inline uint64_t xxh64_round(uint64_t acc, uint64_t input) {
+    acc += input * PRIME64_2;
+    acc = rotl64(acc, 31);
+    return acc * PRIME64_1;
+}
+
+static inline uint64_t xxh64_merge_round(uint64_t acc, uint64_t val) {
+    acc ^= xxh64_round(0, val);
+    return acc * PRIME64_1 + PRIME64_4;
+}
+
+static inline uint64_t xxh64_avalanche(uint64_t h) {
+    h ^= h >> 33;
+    h *= PRIME64_2;
+    h ^= h >> 29;
+    h *= PRIME64_3;
+    h ^= h >> 32;
+    return h;
+}
+
+/* Mix in the final 0..31 bytes */
+static uint64_t xxh64_finalize(uint64_t h, const unsigned char *p, size_t len) {
+    while (len >= 8) {
+        h ^= xxh64_round(0, read_le64(p));
+        h = rotl64(h, 27) * PRIME64_1 + PRIME64_4;
+        p += 8;
+        len -= 8;
+    }
+    if (len >= 4) {
+        h ^= (uint64_t)read_le32(p) * PRIME64_1;
+        h = rotl64(h, 23) * PRIME64_2 + PRIME64_3;
+        p += 4;
+        len -= 4;
+    }
+    while (len > 0) {
+        h ^= *p++ * PRIME64_5;
+        h = rotl64(h, 11) * PRIME64_1;
+        len--;
+    }
+    return xxh64_avalanche(h);
+}
+
+static const unsigned char *xxh64_stripes(uint64_t v[4], const unsigned char *p, size_t stripes) {
+    while (stripes--) {
+        v[0] = xxh64_round(v[0], read_le64(p));
+        v[1] = xxh64_round(v[1], read_le64(p + 8));
+        v[2] = xxh64_round(v[2], read_le64(p + 16));
+        v[3] = xxh64_round(v[3], read_le64(p + 24));
+        p += 32;
+    }
+    return p;
+}
+
+void checksum_xxh64_init(checksum_xxh64_ctx_t *ctx) {
+    memset(ctx, 0, sizeof(*ctx));
+    ctx->v[0] = PRIME64_1 + PRIME64_2;
+    ctx->v[1] = PRIME64_2;
+    ctx->v[2] = 0;
+    ctx->v[3] = 0 - PRIME64_1;
+}
+
+void checksum_xxh64_update(checksum_xxh64_ctx_t *ctx, const void *data, size_t len) {
+    const unsigned char *p = data;
+
+    ctx->total_len += len;
+
+    if (ctx->buffered + len < 32) {
+        memcpy(ctx->buffer + ctx->buffered, p, len);
+        ctx->buffered += (uint32_t)len;
+        return;
+    }
+
+    if (ctx->buffered) {
+        size_t take = 32 - ctx->buffered;
+
+        memcpy(ctx->buffer + ctx->buffered, p, take);
+        xxh64_stripes(ctx->v, ctx->buffer, 1);
+        p += take;
+        len -= take;
+        ctx->buffered = 0;
+    }
+
+    p = xxh64_stripes(ctx->v, p, len / 32);
+    len %= 32;
+    memcpy(ctx->buffer, p, len);
+    ctx->buffered = (uint32_t)len;
+}
+
+uint64_t checksum_xxh64_final(const checksum_xxh64_ctx_t *ctx) {
+    uint64_t h;
+
+    if (ctx->total_len >= 32) {
+        h = rotl64(ctx->v[0], 1) + rotl64(ctx->v[1], 7) + rotl64(ctx->v[2], 12) +
+            rotl64(ctx->v[3], 18);
+        h = xxh64_merge_round(h, ctx->v[0]);
+        h = xxh64_merge_round(h, ctx->v[1]);
+        h = xxh64_merge_round(h, ctx->v[2]);
+        h = xxh64_merge_round(h, ctx->v[3]);
+    } else {
+        h = PRIME64_5;
+    }
+
+    h += ctx->total_len;
+    return xxh64_finalize(h, ctx->buffer, ctx->buffered);
+}
+
+uint64_t checksum_xxh64(const unsigned char *data, size_t len) {
+    checksum_xxh64_ctx_t ctx;
+
+    checksum_xxh64_init(&ctx);
+    checksum_xxh64_update(&ctx, data, len);
+    return checksum_xxh64_final(&ctx);
+}
+
+/*
+ * XXH3 long-input kernels. Eight 64-bit accumulators take one 64-byte
+ * stripe at a time; every XXH3_BLOCK_LEN bytes they are scrambled.
+ */
+
+void checksum_xxh3_accumulate_scalar(uint64_t acc[8], const unsigned char *input,
+                                     const unsigned char *secret, size_t stripes) {
+    for (size_t s = 0; s < stripes; s++) {
+        const unsigned char *in = input + s * XXH3_STRIPE_LEN;
+        const unsigned char *key = secret + s * XXH3_SECRET_RATE;
+
+        for (int i = 0; i < 8; i++) {
+            uint64_t data_val = read_le64(in + 8 * i);
+            uint64_t data_key = data_val ^ read_le64(key + 8 * i);
+
+            acc[i ^ 1] += data_val;
+            acc[i] += (data_key & 0xffffffff) * (data_key >> 32);
+        }
+    }
+}
+
+void checksum_xxh3_scramble_scalar(uint64_t acc[8], const unsigned char *secret) {
+    for (int i = 0; i < 8; i++) {
+        uint64_t a = acc[i];
+
+        a ^= a >> 47;
+        a ^= read_le64(secret + 8 * i);
+        acc[i] = a * PRIME32_1;
+    }
+}
+
+#if CHECKSUM_HAVE_X86_SIMD
+__attribute__((target("sse2")))
+void checksum_xxh3_accumulate_sse2(uint64_t acc[8], const unsigned char *input,
+                                   const unsigned char *secret, size_t stripes) {
+    __m128i a[4];
+
+    for (int i = 0; i < 4; i++) {
+        a[i] = _mm_loadu_si128((const __m128i *)(acc + 2 * i));
+    }
+
+    for (size_t s = 0; s < stripes; s++) {
+        const unsigned char *in = input + s * XXH3_STRIPE_LEN;
+        const unsigned char *key = secret + s * XXH3_SECRET_RATE;
+
+        for (int i = 0; i < 4; i++) {
+            __m128i data = _mm_loadu_si128((const __m128i *)(in + 16 * i));
+            __m128i data_key = _mm_xor_si128(data, _mm_loadu_si128((const __m128i *)(key + 16 * i)));
+            /* low * high half of each 64-bit key word */
+            __m128i product = _mm_mul_epu32(data_key, _mm_shuffle_epi32(data_key, 0x31));
+            /* acc[i ^ 1] += data: swap the two 64-bit lanes */
+            __m128i swapped = _mm_shuffle_epi32(data, 0x4e);
+
+            a[i] = _mm_add_epi64(a[i], _mm_add_epi64(product, swapped));
+        }
+    }
+
+    for (int i = 0; i < 4; i++) {
+        _mm_storeu_si128((__m128i *)(acc + 2 * i), a[i]);
+    }
+}
+
+__attribute__((target("sse2")))
+void checksum_xxh3_scramble_sse2(uint64_t acc[8], const unsigned char *secret) {
+    const __m128i prime = _mm_set1_epi32((int)PRIME32_1);
+
+    for (int i = 0; i < 4; i++) {
+        __m128i a = _mm_loadu_si128((const __m128i *)(acc + 2 * i));
+        __m128i key = _mm_loadu_si128((const __m128i *)(secret + 16 * i));
+
+        a = _mm_xor_si128(_mm_xor_si128(a, _mm_srli_epi64(a, 47)), key);
+        /* 64x32-bit multiply from two 32x32 products */
+        a = _mm_add_epi64(_mm_mul_epu32(a, prime),
+                          _mm_slli_epi64(_mm_mul_epu32(_mm_shuffle_epi32(a, 0x31), prime), 32));
+        _mm_storeu_si128((__m128i *)(acc + 2 * i), a);
+    }
+}
+
+__attribute__((target("avx2")))
+void checksum_xxh3_accumulate_avx2(uint64_t acc[8], const unsigned char *input,
+                                   const unsigned char *secret, size_t stripes) {
+    __m256i a0 = _mm256_loadu_si256((const __m256i *)acc);
+    __m256i a1 = _mm256_loadu_si256((const __m256i *)(acc + 4));
+
+    for (size_t s = 0; s < stripes; s++) {
+        const unsigned char *in = input + s * XXH3_STRIPE_LEN;
+        const unsigned char *key = secret + s * XXH3_SECRET_RATE;
+        __m256i d0 = _mm256_loadu_si256((const __m256i *)in);
+        __m256i d1 = _mm256_loadu_si256((const __m256i *)(in + 32));
+        __m256i k0 = _mm256_xor_si256(d0, _mm256_loadu_si256((const __m256i *)key));
+        __m256i k1 = _mm256_xor_si256(d1, _mm256_loadu_si256((const __m256i *)(key + 32)));
+        __m256i p0 = _mm256_mul_epu32(k0, _mm256_shuffle_epi32(k0, 0x31));
+        __m256i p1 = _mm256_mul_epu32(k1, _mm256_shuffle_epi32(k1, 0x31));
+
+        a0 = _mm256_add_epi64(a0, _mm256_add_epi64(p0, _mm256_shuffle_epi32(d0, 0x4e)));
+        a1 = _mm256_add_epi64(a1, _mm256_add_epi64(p1, _mm256_shuffle_epi32(d1, 0x4e)));
+    }
+
+    _mm256_storeu_si256((__m256i *)acc, a0);
+    _mm256_storeu_si256((__m256i *)(acc + 4), a1);
+}
+
+__attribute__((target("avx2")))
+void checksum_xxh3_scramble_avx2(uint64_t acc[8], const unsigned char *secret) {
+    const __m256i prime = _mm256_set1_epi32((int)PRIME32_1);
+
+    for (int i = 0; i < 2; i++) {
+        __m256i a = _mm256_loadu_si256((const __m256i *)(acc + 4 * i));
+        __m256i key = _mm256_loadu_si256((const __m256i *)(secret + 32 * i));
+
+        a = _mm256_xor_si256(_mm256_xor_si256(a, _mm256_srli_epi64(a, 47)), key);
+        a = _mm256_add_epi64(_mm256_mul_epu32(a, prime),
+                             _mm256_slli_epi64(_mm256_mul_epu32(_mm256_shuffle_epi32(a, 0x31), prime), 32));
+        _mm256_storeu_si256((__m256i *)(acc + 4 * i), a);
+    }
+}
+#endif /* CHECKSUM_HAVE_X86_SIMD */
+
+static const xxh3_impl_t *xxh3_resolve(void) {
+    static const xxh3_impl_t scalar = {
+        checksum_xxh3_accumulate_scalar, checksum_xxh3_scramble_scalar
+    };
+#if CHECKSUM_HAVE_X86_SIMD
+    static const xxh3_impl_t sse2 = {checksum_xxh3_accumulate_sse2, checksum_xxh3_scramble_sse2};
+    static const xxh3_impl_t avx2 = {checksum_xxh3_accumulate_avx2, checksum_xxh3_scramble_avx2};
+    unsigned int cpu = checksum_cpu_features();
+
+    if (cpu & CHECKSUM_CPU_AVX2) {
+        return &avx2;
+    }
+    if (cpu & CHECKSUM_CPU_SSE2) {
+        return &sse2;
+    }
+#endif
+    return &scalar;
+}
+
+static const xxh3_impl_t *xxh3_impl(void) {
+    static _Atomic(const xxh3_impl_t *) impl;
+    const xxh3_impl_t *p = atomic_load_explicit(&impl, memory_order_relaxed);
+
+    if (!p) {
+        p = xxh3_resolve();
+        atomic_store_explicit(&impl, p, memory_order_relaxed);
+    }
+    return p;
+}
+
+/* XXH3 helpers shared by the 64- and 128-bit variants */
+
+static inline uint64_t xxh3_avalanche(uint64_t h) {
+    h ^= h >> 37;
+    h *= PRIME_MX1;
+    h ^= h >> 32;
+    return h;
+}
+
+static inline uint64_t xxh3_rrmxmx(uint64_t h, uint64_t len) {
+    h ^= rotl64(h, 49) ^ rotl64(h, 24);
+    h *= PRIME_MX2;
+    h ^= (h >> 35) + len;
+    h *= PRIME_MX2;
+    return h ^ (h >> 28);
+}
+
+static inline uint64_t xxh3_mix16(const unsigned char *input, const unsigned char *secret) {
+    return mul128_fold64(read_le64(input) ^ read_le64(secret),
+                         read_le64(input + 8) ^ read_le64(secret + 8));
+}
+
+static inline uint64_t xxh3_mix2accs(const uint64_t *acc, const unsigned char *secret) {
+    return mul128_fold64(acc[0] ^ read_le64(secret), acc[1] ^ read_le64(secret + 8));
+}
+
+static uint64_t xxh3_merge_accs(const uint64_t acc[8], const unsigned char *secret, uint64_t start) {
+    uint64_t result = start;
+
+    for (int i = 0; i < 4; i++) {
+        result += xxh3_mix2accs(acc + 2 * i, secret + 16 * i);
+    }
+    return xxh3_avalanche(result);
+}
+
+static void xxh3_init_acc(uint64_t acc[8]) {
+    acc[0] = PRIME32_3;
+    acc[1] = PRIME64_1;
+    acc[2] = PRIME64_2;
+    acc[3] = PRIME64_3;
+    acc[4] = PRIME64_4;
+    acc[5] = PRIME32_2;
+    acc[6] = PRIME64_5;
+    acc[7] = PRIME32_1;
+}
+
+/* Run the stripes of a long input, leaving its last stripe to the caller */
+static void xxh3_hash_long(uint64_t acc[8], const unsigned char *input, size_t len) {
+    const xxh3_impl_t *impl = xxh3_impl();
+    size_t blocks = (len - 1) / XXH3_BLOCK_LEN;
+    size_t stripes;
+
+    xxh3_init_acc(acc);
+    for (size_t n = 0; n < blocks; n++) {
+        impl->accumulate(acc, input + n * XXH3_BLOCK_LEN, xxh3_secret, XXH3_STRIPES_PER_BLOCK);
+        impl->scramble(acc, xxh3_secret + XXH3_SECRET_SIZE - XXH3_STRIPE_LEN);
+    }
+
+    stripes = ((len - 1) - blocks * XXH3_BLOCK_LEN) / XXH3_STRIPE_LEN;
+    impl->accumulate(acc, input + blocks * XXH3_BLOCK_LEN, xxh3_secret, stripes);
+    impl->accumulate(acc, input + len - XXH3_STRIPE_LEN,
+                     xxh3_secret + XXH3_SECRET_SIZE - XXH3_STRIPE_LEN - 7, 1);
+}
+
+static uint64_t xxh3_64_short(const unsigned char *input, size_t len) {
+    const unsigned char *secret = xxh3_secret;
+
+    if (len > 16) {
+        uint64_t acc = len * PRIME64_1;
+
+        if (len > 128) {
+            size_t rounds = len / 16;
+            uint64_t acc_end = xxh3_mix16(input + len - 16, secret + 136 - 17);
+
+            for (size_t i = 0; i < 8; i++) {
+                acc += xxh3_mix16(input + 16 * i, secret + 16 * i);
+            }
+            acc = xxh3_avalanche(acc);
+            for (size_t i = 8; i < rounds; i++) {
+                acc_end += xxh3_mix16(input + 16 * i, secret + 16 * (i - 8) + 3);
+            }
+            return xxh3_avalanche(acc + acc_end);
+        }
+
+        if (len > 32) {
+            if (len > 64) {
+                if (len > 96) {
+                    acc += xxh3_mix16(input + 48, secret + 96);
+                    acc += xxh3_mix16(input + len - 64, secret + 112);
+                }
+                acc += xxh3_mix16(input + 32, secret + 64);
+                acc += xxh3_mix16(input + len - 48, secret + 80);
+            }
+            acc += xxh3_mix16(input + 16, secret + 32);
+            acc += xxh3_mix16(input + len - 32, secret + 48);
+        }
+        acc += xxh3_mix16(input, secret);
+        acc += xxh3_mix16(input + len - 16, secret + 16);
+        return xxh3_avalanche(acc);
+    }
+
+    if (len > 8) {
+        uint64_t lo = read_le64(input) ^ (read_le64(secret + 24) ^ read_le64(secret + 32));
+        uint64_t hi = read_le64(input + len - 8) ^ (read_le64(secret + 40) ^ read_le64(secret + 48));
+
+        return xxh3_avalanche(len + swap64(lo) + hi + mul128_fold64(lo, hi));
+    }
+    if (len >= 4) {
+        uint64_t in64 = read_le32(input + len - 4) + ((uint64_t)read_le32(input) << 32);
+        uint64_t bitflip = read_le64(secret + 8) ^ read_le64(secret + 16);
+
+        return xxh3_rrmxmx(in64 ^ bitflip, len);
+    }
+    if (len > 0) {
+        uint32_t combined = ((uint32_t)input[0] << 16) | ((uint32_t)input[len >> 1] << 24) |
+                            input[len - 1] | ((uint32_t)len << 8);
+        uint64_t bitflip = read_le32(secret) ^ read_le32(secret + 4);
+
+        return xxh64_avalanche(combined ^ bitflip);
+    }
+    return xxh64_avalanche(read_le64(secret + 56) ^ read_le64(secret + 64));
+}
+
+/* Two 16-byte mixes cross-fed into a 128-bit accumulator */
+static inline void xxh3_mix32(xxh_u128_t *acc, const unsigned char *in1, const unsigned char *in2,
+                              const unsigned char *secret) {
+    acc->low += xxh3_mix16(in1, secret);
+    acc->low ^= read_le64(in2) + read_le64(in2 + 8);
+    acc->high += xxh3_mix16(in2, secret + 16);
+    acc->high ^= read_le64(in1) + read_le64(in1 + 8);
+}
+
+static xxh_u128_t xxh3_128_short(const unsigned char *input, size_t len) {
+    const unsigned char *secret = xxh3_secret;
+    xxh_u128_t h;
+
+    if (len > 16) {
+        xxh_u128_t acc = {len * PRIME64_1, 0};
+
+        if (len > 128) {
+            size_t rounds = len / 32;
+
+            for (size_t i = 0; i < 4; i++) {
+                xxh3_mix32(&acc, input + 32 * i, input + 32 * i + 16, secret + 32 * i);
+            }
+            acc.low = xxh3_avalanche(acc.low);
+            acc.high = xxh3_avalanche(acc.high);
+            for (size_t i = 4; i < rounds; i++) {
+                xxh3_mix32(&acc, input + 32 * i, input + 32 * i + 16, secret + 3 + 32 * (i - 4));
+            }
+            xxh3_mix32(&acc, input + len - 16, input + len - 32, secret + 136 - 17 - 16);
+        } else {
+            if (len > 32) {
+                if (len > 64) {
+                    if (len > 96) {
+                        xxh3_mix32(&acc, input + 48, input + len - 64, secret + 96);
+                    }
+                    xxh3_mix32(&acc, input + 32, input + len - 48, secret + 64);
+                }
+                xxh3_mix32(&acc, input + 16, input + len - 32, secret + 32);
+            }
+            xxh3_mix32(&acc, input, input + len - 16, secret);
+        }
+
+        h.low = xxh3_avalanche(acc.low + acc.high);
+        h.high = 0 - xxh3_avalanche(acc.low * PRIME64_1 + acc.high * PRIME64_4 + len * PRIME64_2);
+        return h;
+    }
+
+    if (len > 8) {
+        uint64_t bitflip_lo = read_le64(secret + 32) ^ read_le64(secret + 40);
+        uint64_t bitflip_hi = read_le64(secret + 48) ^ read_le64(secret + 56);
+        uint64_t in_lo = read_le64(input);
+        uint64_t in_hi = read_le64(input + len - 8);
+        xxh_u128_t m = mult64to128(in_lo ^ in_hi ^ bitflip_lo, PRIME64_1);
+
+        m.low += (uint64_t)(len - 1) << 54;
+        in_hi ^= bitflip_hi;
+        m.high += in_hi + (uint64_t)(uint32_t)in_hi * (PRIME32_2 - 1);
+        m.low ^= swap64(m.high);
+        h = mult64to128(m.low, PRIME64_2);
+        h.high += m.high * PRIME64_2;
+        h.low = xxh3_avalanche(h.low);
+        h.high = xxh3_avalanche(h.high);
+        return h;
+    }
+    if (len >= 4) {
+        uint64_t in64 = read_le32(input) + ((uint64_t)read_le32(input + len - 4) << 32);
+        uint64_t bitflip = read_le64(secret + 16) ^ read_le64(secret + 24);
+
+        h = mult64to128(in64 ^ bitflip, PRIME64_1 + (len << 2));
+        h.high += h.low << 1;
+        h.low ^= h.high >> 3;
+        h.low ^= h.low >> 35;
+        h.low *= PRIME_MX2;
+        h.low ^= h.low >> 28;
+        h.high = xxh3_avalanche(h.high);
+        return h;
+    }
+    if (len > 0) {
+        uint32_t combined_lo = ((uint32_t)input[0] << 16) | ((uint32_t)input[len >> 1] << 24) |
+                               input[len - 1] | ((uint32_t)len << 8);
+        uint32_t combined_hi = rotl32(swap32(combined_lo), 13);
+
+        h.low = xxh64_avalanche(combined_lo ^ (uint64_t)(read_le32(secret) ^ read_le32(secret + 4)));
+        h.high = xxh64_avalanche(combined_hi ^
+                                 (uint64_t)(read_le32(secret + 8) ^ read_le32(secret + 12)));
+        return h;
+    }
+
+    h.low = xxh64_avalanche(read_le64(secret + 64) ^ read_le64(secret + 72));
+    h.high = xxh64_avalanche(read_le64(secret + 80) ^ read_le64(secret + 88));
+    return h;
+}
+
+static uint64_t xxh3_64_from_accs(const uint64_t acc[8], uint64_t len) {
+    return xxh3_merge_accs(acc, xxh3_secret + 11, len * PRIME64_1);
+}
+
+static xxh_u128_t xxh3_128_from_accs(const uint64_t acc[8], uint64_t len) {
+    xxh_u128_t h;
+
+    h.low = xxh3_merge_accs(acc, xxh3_secret + 11, len * PRIME64_1);
+    h.high = xxh3_merge_accs(acc, xxh3_secret + XXH3_SECRET_SIZE - XXH3_STRIPE_LEN - 11,
+                             ~(len * PRIME64_2));
+    return h;
+}
+
+static void store_be64(unsigned char *p, uint64_t v) {
+    for (int i = 0; i < 8; i++) {
+        p[i] = (unsigned char)(v >> (56 - 8 * i));
+    }
+}
+
+/* Canonical XXH128 form: high half first, both big-endian */
+static void store_u128(unsigned char digest[CHECKSUM_XXH128_DIGEST], xxh_u128_t h) {
+    store_be64(digest, h.high);
+    store_be64(digest + 8, h.low);
+}
+
+uint64_t checksum_xxh3_64(const unsigned char *data, size_t len) {
+    uint64_t acc[8];
+
+    if (len <= XXH3_MIDSIZE_MAX) {
+        return xxh3_64_short(data, len);
+    }
+    xxh3_hash_long(acc, data, len);
+    return xxh3_64_from_accs(acc, len);
+}
+
+void checksum_xxh3_128(const unsigned char *data, size_t len,
+                       unsigned char digest[CHECKSUM_XXH128_DIGEST]) {
+    uint64_t acc[8];
+
+    if (len <= XXH3_MIDSIZE_MAX) {
+        store_u128(digest, xxh3_128_short(data, len));
+        return;
+    }
+    xxh3_hash_long(acc, data, len);
+    store_u128(digest, xxh3_128_from_accs(acc, len));
+}
+
+/*
+ * XXH3 streaming. Input is staged through a buffer of whole stripes; a
+ * stripe is only consumed once more input follows it, because the last
+ * stripe of the message is hashed with a different secret offset.
+ */
+
+static void xxh3_consume(const xxh3_impl_t *impl, uint64_t acc[8], uint32_t *stripes_so_far,
+                         const unsigned char *input, size_t stripes) {
+    size_t to_block_end = XXH3_STRIPES_PER_BLOCK - *stripes_so_far;
+
+    if (stripes >= to_block_end) {
+        impl->accumulate(acc, input, xxh3_secret + *stripes_so_far * XXH3_SECRET_RATE, to_block_end);
+        impl->scramble(acc, xxh3_secret + XXH3_SECRET_SIZE - XXH3_STRIPE_LEN);
+        impl->accumulate(acc, input + to_block_end * XXH3_STRIPE_LEN, xxh3_secret,
+                         stripes - to_block_end);
+        *stripes_so_far = (uint32_t)(stripes - to_block_end);
+    } else {
+        impl->accumulate(acc, input, xxh3_secret + *stripes_so_far * XXH3_SECRET_RATE, stripes);
+        *stripes_so_far += (uint32_t)stripes;
+    }
+}
+
+void checksum_xxh3_init(checksum_xxh3_ctx_t *ctx) {
+    memset(ctx, 0, sizeof(*ctx));
+    xxh3_init_acc(ctx->acc);
+}
+
+void checksum_xxh3_update(checksum_xxh3_ctx_t *ctx, const void *data, size_t len) {
+    const xxh3_impl_t *impl = xxh3_impl();
+    const unsigned char *p = data;
+    const unsigned char *end = p + len;
+
+    ctx->total_len += len;
+
+    if (len <= CHECKSUM_XXH3_BUFFER - ctx->buffered) {
+        memcpy(ctx->buffer + ctx->buffered, p, len);
+        ctx->buffered += (uint32_t)len;
+        return;
+    }
+
+    if (ctx->buffered) {
+        size_t take = CHECKSUM_XXH3_BUFFER - ctx->buffered;
+
+        memcpy(ctx->buffer + ctx->buffered, p, take);
+        p += take;
+        xxh3_consume(impl, ctx->acc, &ctx->stripes, ctx->buffer, XXH3_BUFFER_STRIPES);
+        ctx->buffered = 0;
+    }
+
+    /* Large input goes straight from the caller's buffer, whole blocks at a time */
+    if ((size_t)(end - p) > CHECKSUM_XXH3_BUFFER) {
+        size_t stripes = ((size_t)(end - p) - 1) / XXH3_STRIPE_LEN;
+
+        while (stripes >= XXH3_STRIPES_PER_BLOCK - ctx->stripes) {
+            size_t n = XXH3_STRIPES_PER_BLOCK - ctx->stripes;
+
+            xxh3_consume(impl, ctx->acc, &ctx->stripes, p, n);
+            p += n * XXH3_STRIPE_LEN;
+            stripes -= n;
+        }
+        xxh3_consume(impl, ctx->acc, &ctx->stripes, p, stripes);
+        p += stripes * XXH3_STRIPE_LEN;
+        /* Keep the stripe before the tail for digests of a short tail */
+        memcpy(ctx->buffer + CHECKSUM_XXH3_BUFFER - XXH3_STRIPE_LEN, p - XXH3_STRIPE_LEN, XXH3_STRIPE_LEN);
+    }
+
+    memcpy(ctx->buffer, p, (size_t)(end - p));
+    ctx->buffered = (uint32_t)(end - p);
+}
+
+/* Replay the buffered tail into a copy of the accumulators */
+static void xxh3_digest_accs(const checksum_xxh3_ctx_t *ctx, uint64_t acc[8]) {
+    const xxh3_impl_t *impl = xxh3_impl();
+    unsigned char last[XXH3_STRIPE_LEN];
+    const unsigned char *last_stripe;
+    uint32_t stripes = ctx->stripes;
+
+    memcpy(acc, ctx->acc, sizeof(ctx->acc));
+    if (ctx->buffered >= XXH3_STRIPE_LEN) {
+        xxh3_consume(impl, acc, &stripes, ctx->buffer, (ctx->buffered - 1) / XXH3_STRIPE_LEN);
+        last_stripe = ctx->buffer + ctx->buffered - XXH3_STRIPE_LEN;
+    } else {
+        size_t catchup = XXH3_STRIPE_LEN - ctx->buffered;
+
+        memcpy(last, ctx->buffer + CHECKSUM_XXH3_BUFFER - catchup, catchup);
+        memcpy(last + catchup, ctx->buffer, ctx->buffered);
+        last_stripe = last;
+    }
+    impl->accumulate(acc, last_stripe, xxh3_secret + XXH3_SECRET_SIZE - XXH3_STRIPE_LEN - 7, 1);
+}
+
+uint64_t checksum_xxh3_64_final(const checksum_xxh3_ctx_t *ctx) {
+    uint64_t acc[8];
+
+    if (ctx->total_len <= XXH3_MIDSIZE_MAX) {
+        return xxh3_64_short(ctx->buffer, (size_t)ctx->total_len);
+    }
+    xxh3_digest_accs(ctx, acc);
+    return xxh3_64_from_accs(acc, ctx->total_len);
+}
+
+void checksum_xxh3_128_final(const checksum_xxh3_ctx_t *ctx,
+                             unsigned char digest[CHECKSUM_XXH128_DIGEST]) {
+    uint64_t acc[8];
+
+    if (ctx->total_len <= XXH3_MIDSIZE_MAX) {
+        store_u128(digest, xxh3_128_short(ctx->buffer, (size_t)ctx->total_len));
+        return;
+    }
+    xxh3_digest_accs(ctx, acc);
+    store_u128(digest, xxh3_128_from_accs(acc, ctx->total_len));
+}
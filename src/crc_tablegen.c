@@ -0,0 +1,291 @@
+/*
+ * crc_tablegen.c - Build-time generator for sliced CRC lookup tables
+ *
+ * Copyright (c) 2025 AnmiTaliDev
+ * Created: 2025-08-09
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Usage: crc_tablegen OUTPUT SPEC...
+ *
+ * Writes a C header with one table per SPEC, for a reflected 32-bit
+ * polynomial POLY (e.g. 0xedb88320 for CRC-32):
+ *
+ *   slice:NAME:POLY        "static const uint32_t NAME[16][256]"
+ *                          slicing-by-16 table. Row 0 is the classic
+ *                          byte-at-a-time table; row k advances a CRC
+ *                          by k additional zero bytes.
+ *   shift:NAME:POLY:BYTES  "static const uint32_t NAME[4][256]" table
+ *                          that advances a CRC register over BYTES zero
+ *                          bytes, one lookup per register byte.
+ *
+ * and, for any Rocksoft-model CRC of WIDTH 8 to 64 bits with its POLY in
+ * normal (MSB-first) form and REFIN 0 or 1:
+ *
+ *   crc:NAME:WIDTH:POLY:REFIN
+ *                          "static const uint64_t NAME[8][256]" slicing-by-8
+ *                          table (reflected in the low WIDTH bits, or
+ *                          left-aligned in 64 bits when REFIN is 0), and
+ *                          "static const uint64_t NAME_fold[8]" PCLMUL
+ *                          folding constants for 128, 256, 384 and 512 bit
+ *                          distances: reflect64(x^(d+63) mod P) and
+ *                          reflect64(x^(d-1) mod P) for each distance d.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <stdint.h>
+
+#define SLICES 16
+
+static void make_slice_table(uint32_t poly, uint32_t table[SLICES][256]) {
+    for (uint32_t n = 0; n < 256; n++) {
+        uint32_t c = n;
+        for (int k = 0; k < 8; k++) {
+            c = (c & 1) ? poly ^ (c >> 1) : c >> 1;
+        }
+        table[0][n] = c;
+    }
+
+    for (int s = 1; s < SLICES; s++) {
+        for (int n = 0; n < 256; n++) {
+            uint32_t c = table[s - 1][n];
+            table[s][n] = (c >> 8) ^ table[0][c & 0xff];
+        }
+    }
+}
+
+/* Advance a CRC register over the given number of zero bytes */
+static uint32_t shift_zeros(uint32_t crc, uint32_t poly, unsigned long bytes) {
+    for (unsigned long i = 0; i < bytes * 8; i++) {
+        crc = (crc & 1) ? poly ^ (crc >> 1) : crc >> 1;
+    }
+    return crc;
+}
+
+/* The shift is linear over GF(2): build it from the 32 single-bit images */
+static void make_shift_table(uint32_t poly, unsigned long bytes, uint32_t table[4][256]) {
+    uint32_t basis[32];
+
+    for (int bit = 0; bit < 32; bit++) {
+        basis[bit] = shift_zeros((uint32_t)1 << bit, poly, bytes);
+    }
+
+    for (int k = 0; k < 4; k++) {
+        for (int n = 0; n < 256; n++) {
+            uint32_t c = 0;
+            for (int bit = 0; bit < 8; bit++) {
+                if (n & (1 << bit)) {
+                    c ^= basis[k * 8 + bit];
+                }
+            }
+            table[k][n] = c;
+        }
+    }
+}
+
+static uint64_t reflect(uint64_t value, unsigned int width) {
+    uint64_t r = 0;
+
+    for (unsigned int i = 0; i < width; i++) {
+        if (value & ((uint64_t)1 << i)) {
+            r |= (uint64_t)1 << (width - 1 - i);
+        }
+    }
+    return r;
+}
+
+static void make_crc_table(unsigned int width, uint64_t poly, int refin, uint64_t table[8][256]) {
+    uint64_t rpoly = reflect(poly, width);
+    uint64_t lpoly = poly << (64 - width);
+
+    for (uint64_t n = 0; n < 256; n++) {
+        uint64_t c = refin ? n : n << 56;
+
+        for (int k = 0; k < 8; k++) {
+            if (refin) {
+                c = (c & 1) ? rpoly ^ (c >> 1) : c >> 1;
+            } else {
+                c = (c >> 63) ? lpoly ^ (c << 1) : c << 1;
+            }
+        }
+        table[0][n] = c;
+    }
+
+    for (int s = 1; s < 8; s++) {
+        for (int n = 0; n < 256; n++) {
+            uint64_t c = table[s - 1][n];
+
+            table[s][n] = refin ? (c >> 8) ^ table[0][c & 0xff]
+                                : (c << 8) ^ table[0][c >> 56];
+        }
+    }
+}
+
+/* x^n mod P in normal form, P of the given width without its x^width term */
+static uint64_t xn_mod_p(unsigned long n, unsigned int width, uint64_t poly) {
+    uint64_t top = (uint64_t)1 << (width - 1);
+    uint64_t mask = width == 64 ? ~(uint64_t)0 : ((uint64_t)1 << width) - 1;
+    uint64_t r = 1;
+
+    for (unsigned long i = 0; i < n; i++) {
+        r = (r & top) ? ((r << 1) & mask) ^ poly : (r << 1) & mask;
+    }
+    return r;
+}
+
+static void write_crc_table(FILE *out, const char *name, unsigned int width, uint64_t poly,
+                            int refin) {
+    static uint64_t table[8][256];
+
+    make_crc_table(width, poly, refin, table);
+    fprintf(out, "/* %u-bit polynomial 0x%llx, %s, slicing-by-8 */\n", width,
+            (unsigned long long)poly, refin ? "reflected" : "left-aligned");
+    fprintf(out, "static const uint64_t %s[8][256] = {\n", name);
+    for (int s = 0; s < 8; s++) {
+        fprintf(out, "    {\n");
+        for (int n = 0; n < 256; n += 2) {
+            fprintf(out, "        0x%016llxULL, 0x%016llxULL%s\n",
+                    (unsigned long long)table[s][n], (unsigned long long)table[s][n + 1],
+                    n + 2 < 256 ? "," : "");
+        }
+        fprintf(out, "    }%s\n", s + 1 < 8 ? "," : "");
+    }
+    fprintf(out, "};\n\n");
+
+    fprintf(out, "static const uint64_t %s_fold[8] = {\n", name);
+    for (unsigned long d = 128; d <= 512; d += 128) {
+        fprintf(out, "    0x%016llxULL, 0x%016llxULL%s\n",
+                (unsigned long long)reflect(xn_mod_p(d + 63, width, poly), 64),
+                (unsigned long long)reflect(xn_mod_p(d - 1, width, poly), 64),
+                d < 512 ? "," : "");
+    }
+    fprintf(out, "};\n\n");
+}
+
+static void write_rows(FILE *out, const char *name, const uint32_t (*table)[256], int rows) {
+    fprintf(out, "static const uint32_t %s[%d][256] = {\n", name, rows);
+    for (int s = 0; s < rows; s++) {
+        fprintf(out, "    {\n");
+        for (int n = 0; n < 256; n += 4) {
+            fprintf(out, "        0x%08x, 0x%08x, 0x%08x, 0x%08x%s\n",
+                    table[s][n], table[s][n + 1], table[s][n + 2], table[s][n + 3],
+                    n + 4 < 256 ? "," : "");
+        }
+        fprintf(out, "    }%s\n", s + 1 < rows ? "," : "");
+    }
+    fprintf(out, "};\n\n");
+}
+
+static int parse_number(const char *prog, const char *text, unsigned long max, unsigned long *value) {
+    char *end;
+
+    errno = 0;
+    *value = strtoul(text, &end, 0);
+    if (errno != 0 || end == text || *end != '\0' || *value > max) {
+        fprintf(stderr, "%s: invalid number '%s'\n", prog, text);
+        return -1;
+    }
+    return 0;
+}
+
+static int write_spec(FILE *out, const char *prog, char *spec) {
+    static uint32_t slices[SLICES][256];
+    static uint32_t shift[4][256];
+    char *kind = strtok(spec, ":");
+    char *name = strtok(NULL, ":");
+    char *poly_text = strtok(NULL, ":");
+    char *bytes_text = strtok(NULL, ":");
+    unsigned long poly, bytes;
+
+    if (kind && strcmp(kind, "crc") == 0) {
+        char *refin_text = strtok(NULL, ":");
+        unsigned long width, refin;
+        unsigned long long poly64;
+        char *end;
+
+        errno = 0;
+        poly64 = bytes_text ? strtoull(bytes_text, &end, 0) : 0;
+        if (!name || !poly_text || !bytes_text || !refin_text || errno != 0 ||
+            *end != '\0' || parse_number(prog, poly_text, 64, &width) != 0 || width < 8 ||
+            parse_number(prog, refin_text, 1, &refin) != 0 ||
+            (width < 64 && poly64 >> width) || !(poly64 & 1)) {
+            fprintf(stderr, "%s: invalid crc spec\n", prog);
+            return -1;
+        }
+        write_crc_table(out, name, (unsigned int)width, (uint64_t)poly64, (int)refin);
+        return 0;
+    }
+
+    if (!kind || !name || !poly_text ||
+        parse_number(prog, poly_text, 0xffffffffUL, &poly) != 0) {
+        fprintf(stderr, "%s: invalid table spec\n", prog);
+        return -1;
+    }
+
+    if (strcmp(kind, "slice") == 0 && !bytes_text) {
+        make_slice_table((uint32_t)poly, slices);
+        fprintf(out, "/* Reflected polynomial 0x%08lx, slicing-by-%d */\n", poly, SLICES);
+        write_rows(out, name, (const uint32_t (*)[256])slices, SLICES);
+        return 0;
+    }
+
+    if (strcmp(kind, "shift") == 0 && bytes_text &&
+        parse_number(prog, bytes_text, 1UL << 30, &bytes) == 0) {
+        make_shift_table((uint32_t)poly, bytes, shift);
+        fprintf(out, "/* Reflected polynomial 0x%08lx, shift by %lu zero bytes */\n", poly, bytes);
+        write_rows(out, name, (const uint32_t (*)[256])shift, 4);
+        return 0;
+    }
+
+    fprintf(stderr, "%s: invalid table spec '%s'\n", prog, kind);
+    return -1;
+}
+
+int main(int argc, char *argv[]) {
+    FILE *out;
+
+    if (argc < 3) {
+        fprintf(stderr, "Usage: %s OUTPUT SPEC...\n", argv[0]);
+        return 1;
+    }
+
+    out = fopen(argv[1], "w");
+    if (!out) {
+        fprintf(stderr, "%s: %s: %s\n", argv[0], argv[1], strerror(errno));
+        return 1;
+    }
+
+    fprintf(out, "/* Generated by crc_tablegen - do not edit */\n\n");
+    fprintf(out, "#include <stdint.h>\n\n");
+
+    for (int i = 2; i < argc; i++) {
+        if (write_spec(out, argv[0], argv[i]) != 0) {
+            fclose(out);
+            remove(argv[1]);
+            return 1;
+        }
+    }
+
+    if (fclose(out) != 0) {
+        fprintf(stderr, "%s: %s: %s\n", argv[0], argv[1], strerror(errno));
+        return 1;
+    }
+
+    return 0;
+}
@@ -25,6 +25,7 @@
 #include <stddef.h>
 #include <stdint.h>
 #include <sys/types.h>
+#include <sys/uio.h>
 
 #ifdef __cplusplus
 extern "C" {
@@ -32,24 +33,529 @@ extern "C" {
 
 #define CHECKSUM_VERSION "1.0.0"
 
+/* Error codes */
+#define CHECKSUM_SUCCESS       0   /* Operation successful */
+#define CHECKSUM_ERROR_IO     -1   /* I/O error occurred */
+#define CHECKSUM_ERROR_MEM    -2   /* Memory allocation failed */
+#define CHECKSUM_ERROR_ARG    -3   /* Invalid argument */
+#define CHECKSUM_ERROR_DATA   -4   /* Malformed or mismatched input data */
+
 typedef enum {
     CHECKSUM_CRC32,
     CHECKSUM_ADLER32,
-    CHECKSUM_BSD_SUM
+    CHECKSUM_BSD_SUM,
+    CHECKSUM_CRC32C,
+    CHECKSUM_SHA256,
+    CHECKSUM_SHA1,
+    CHECKSUM_BLAKE3,
+    CHECKSUM_XXH64,
+    CHECKSUM_XXH3_64,
+    CHECKSUM_XXH3_128
 } checksum_type_t;
 
+/* Digest sizes in bytes */
+#define CHECKSUM_SHA256_DIGEST 32
+#define CHECKSUM_SHA1_DIGEST   20
+#define CHECKSUM_BLAKE3_DIGEST 32
+#define CHECKSUM_XXH64_DIGEST  8
+#define CHECKSUM_XXH3_DIGEST   8
+#define CHECKSUM_XXH128_DIGEST 16
+#define CHECKSUM_MAX_DIGEST    32
+
 typedef struct {
-    uint32_t value;
+    uint32_t value;             /* the checksum; leading 32 bits of wider digests */
     checksum_type_t type;
     size_t bytes_processed;
+    size_t digest_len;          /* bytes used in digest */
+    unsigned char digest[CHECKSUM_MAX_DIGEST];  /* big-endian, as printed in hex */
 } checksum_result_t;
 
+/* Per-algorithm streaming contexts */
+typedef struct {
+    uint32_t crc;           /* raw CRC register */
+} checksum_crc32_ctx_t;
+
+typedef struct {
+    uint32_t crc;           /* raw CRC register */
+} checksum_crc32c_ctx_t;
+
+typedef struct {
+    uint32_t adler;         /* (b << 16) | a */
+} checksum_adler32_ctx_t;
+
+typedef struct {
+    uint32_t sum;
+} checksum_bsd_sum_ctx_t;
+
+typedef struct {
+    uint32_t state[8];
+    uint64_t length;        /* bytes fed so far */
+    unsigned char block[64];
+} checksum_sha256_ctx_t;
+
+typedef struct {
+    uint32_t state[5];
+    uint64_t length;        /* bytes fed so far */
+    unsigned char block[64];
+} checksum_sha1_ctx_t;
+
+typedef struct {
+    uint32_t cv[8];             /* chaining value of the current chunk */
+    uint64_t chunk_counter;
+    unsigned char block[64];
+    uint8_t block_len;
+    uint8_t blocks_compressed;
+    uint8_t cv_stack_len;
+    unsigned char cv_stack[55 * 32];    /* one subtree per level of the chunk tree */
+} checksum_blake3_ctx_t;
+
+typedef struct {
+    uint64_t v[4];
+    uint64_t total_len;
+    unsigned char buffer[32];
+    uint32_t buffered;
+} checksum_xxh64_ctx_t;
+
+/* Shared by XXH3-64 and XXH3-128, which differ only in finalization */
+#define CHECKSUM_XXH3_BUFFER 256
+typedef struct {
+    uint64_t acc[8];
+    uint64_t total_len;
+    unsigned char buffer[CHECKSUM_XXH3_BUFFER];
+    uint32_t buffered;
+    uint32_t stripes;           /* stripes accumulated in the current block */
+} checksum_xxh3_ctx_t;
+
+/* Algorithm-independent streaming context */
+typedef struct {
+    checksum_type_t type;
+    uint64_t bytes;
+    union {
+        checksum_crc32_ctx_t crc32;
+        checksum_crc32c_ctx_t crc32c;
+        checksum_adler32_ctx_t adler32;
+        checksum_bsd_sum_ctx_t bsd_sum;
+        checksum_sha256_ctx_t sha256;
+        checksum_sha1_ctx_t sha1;
+        checksum_blake3_ctx_t blake3;
+        checksum_xxh64_ctx_t xxh64;
+        checksum_xxh3_ctx_t xxh3;
+    } u;
+} checksum_ctx_t;
+
+/*
+ * One-shot checksums of a single buffer
+ */
 uint32_t checksum_crc32(const unsigned char *data, size_t len);
 uint32_t checksum_adler32(const unsigned char *data, size_t len);
 uint32_t checksum_bsd_sum(const unsigned char *data, size_t len);
+uint32_t checksum_crc32c(const unsigned char *data, size_t len);
+void checksum_sha256(const unsigned char *data, size_t len,
+                     unsigned char digest[CHECKSUM_SHA256_DIGEST]);
+void checksum_sha1(const unsigned char *data, size_t len,
+                   unsigned char digest[CHECKSUM_SHA1_DIGEST]);
+void checksum_blake3(const unsigned char *data, size_t len,
+                     unsigned char digest[CHECKSUM_BLAKE3_DIGEST]);
+uint64_t checksum_xxh64(const unsigned char *data, size_t len);
+uint64_t checksum_xxh3_64(const unsigned char *data, size_t len);
+void checksum_xxh3_128(const unsigned char *data, size_t len,
+                       unsigned char digest[CHECKSUM_XXH128_DIGEST]);
+
+/*
+ * Per-algorithm streaming API
+ *
+ * Call *_init() once, *_update() for each consecutive piece of input, and
+ * *_final() to obtain the checksum. final() does not modify the context,
+ * so a running checksum can be read and then extended further.
+ */
+void checksum_crc32_init(checksum_crc32_ctx_t *ctx);
+void checksum_crc32_update(checksum_crc32_ctx_t *ctx, const void *data, size_t len);
+uint32_t checksum_crc32_final(const checksum_crc32_ctx_t *ctx);
+
+void checksum_crc32c_init(checksum_crc32c_ctx_t *ctx);
+void checksum_crc32c_update(checksum_crc32c_ctx_t *ctx, const void *data, size_t len);
+uint32_t checksum_crc32c_final(const checksum_crc32c_ctx_t *ctx);
+
+void checksum_adler32_init(checksum_adler32_ctx_t *ctx);
+void checksum_adler32_update(checksum_adler32_ctx_t *ctx, const void *data, size_t len);
+uint32_t checksum_adler32_final(const checksum_adler32_ctx_t *ctx);
+
+void checksum_bsd_sum_init(checksum_bsd_sum_ctx_t *ctx);
+void checksum_bsd_sum_update(checksum_bsd_sum_ctx_t *ctx, const void *data, size_t len);
+uint32_t checksum_bsd_sum_final(const checksum_bsd_sum_ctx_t *ctx);
+
+void checksum_sha256_init(checksum_sha256_ctx_t *ctx);
+void checksum_sha256_update(checksum_sha256_ctx_t *ctx, const void *data, size_t len);
+void checksum_sha256_final(const checksum_sha256_ctx_t *ctx,
+                           unsigned char digest[CHECKSUM_SHA256_DIGEST]);
+
+void checksum_sha1_init(checksum_sha1_ctx_t *ctx);
+void checksum_sha1_update(checksum_sha1_ctx_t *ctx, const void *data, size_t len);
+void checksum_sha1_final(const checksum_sha1_ctx_t *ctx, unsigned char digest[CHECKSUM_SHA1_DIGEST]);
+
+void checksum_blake3_init(checksum_blake3_ctx_t *ctx);
+void checksum_blake3_update(checksum_blake3_ctx_t *ctx, const void *data, size_t len);
+void checksum_blake3_final(const checksum_blake3_ctx_t *ctx,
+                           unsigned char digest[CHECKSUM_BLAKE3_DIGEST]);
+
+void checksum_xxh64_init(checksum_xxh64_ctx_t *ctx);
+void checksum_xxh64_update(checksum_xxh64_ctx_t *ctx, const void *data, size_t len);
+uint64_t checksum_xxh64_final(const checksum_xxh64_ctx_t *ctx);
+
+/* One XXH3 context serves both widths; pick the width at final() */
+void checksum_xxh3_init(checksum_xxh3_ctx_t *ctx);
+void checksum_xxh3_update(checksum_xxh3_ctx_t *ctx, const void *data, size_t len);
+uint64_t checksum_xxh3_64_final(const checksum_xxh3_ctx_t *ctx);
+void checksum_xxh3_128_final(const checksum_xxh3_ctx_t *ctx,
+                             unsigned char digest[CHECKSUM_XXH128_DIGEST]);
+
+/*
+ * Feed a large in-memory input (e.g. a mapped file) to a BLAKE3 context,
+ * hashing independent subtrees of the chunk tree on up to `threads`
+ * threads. The result is identical to checksum_blake3_update().
+ *
+ * @param ctx Initialized context
+ * @param data Input bytes
+ * @param len Number of bytes
+ * @param threads Maximum number of threads to use, including the caller
+ */
+void checksum_blake3_update_parallel(checksum_blake3_ctx_t *ctx, const void *data, size_t len,
+                                     unsigned int threads);
 
+/*
+ * Initialize a streaming context for any algorithm
+ *
+ * @param ctx Context to initialize
+ * @param type Checksum algorithm
+ * @return CHECKSUM_SUCCESS, or CHECKSUM_ERROR_ARG for an unknown type
+ */
+int checksum_init(checksum_ctx_t *ctx, checksum_type_t type);
+
+/*
+ * Feed the next piece of input into a streaming context
+ *
+ * @param ctx Initialized context
+ * @param data Input bytes
+ * @param len Number of bytes
+ */
+void checksum_update(checksum_ctx_t *ctx, const void *data, size_t len);
+
+/*
+ * Feed len zero bytes, as for a hole in a sparse file
+ *
+ * CRC32 and CRC32C advance in O(log len) time, Adler-32 and BSD sum in
+ * constant time; other algorithms are fed from a zero buffer.
+ *
+ * @param ctx Initialized context
+ * @param len Number of zero bytes
+ */
+void checksum_update_zeros(checksum_ctx_t *ctx, uint64_t len);
+
+/*
+ * Feed a large in-memory input, using up to `threads` threads where the
+ * algorithm allows it (BLAKE3); otherwise the same as checksum_update()
+ *
+ * @param ctx Initialized context
+ * @param data Input bytes
+ * @param len Number of bytes
+ * @param threads Maximum number of threads to use, including the caller
+ */
+void checksum_update_parallel(checksum_ctx_t *ctx, const void *data, size_t len,
+                              unsigned int threads);
+
+/*
+ * Produce the checksum of everything fed so far
+ *
+ * @param ctx Initialized context (left unchanged)
+ * @param result Filled with the value, type and byte count
+ */
+void checksum_final(const checksum_ctx_t *ctx, checksum_result_t *result);
+
+/*
+ * Checksum a scattered buffer in one call
+ *
+ * The buffers are processed in order as if they were one contiguous block.
+ *
+ * @param type Checksum algorithm
+ * @param iov Array of buffers
+ * @param iovcnt Number of buffers
+ * @param result Filled with the checksum of the concatenation
+ * @return CHECKSUM_SUCCESS, or CHECKSUM_ERROR_ARG on invalid arguments
+ */
+int checksum_buffers(checksum_type_t type, const struct iovec *iov, size_t iovcnt,
+                     checksum_result_t *result);
+
+/*
+ * Get the display name of an algorithm ("CRC32", "ADLER32", ...)
+ *
+ * @param type Checksum algorithm
+ * @return Constant string, "UNKNOWN" for invalid types
+ */
+const char *checksum_name(checksum_type_t type);
+
+/*
+ * Get the digest size of an algorithm
+ *
+ * @param type Checksum algorithm
+ * @return Digest length in bytes (4 for the 32-bit checksums), 0 for
+ *         invalid types
+ */
+size_t checksum_digest_size(checksum_type_t type);
+
+/*
+ * Look up an algorithm by name, ignoring case
+ *
+ * Accepts the display names plus the command-line spellings ("crc32",
+ * "crc32c", "adler32", "sum", "sha256", "sha1", "blake3", "xxh64", "xxh3",
+ * "xxh128").
+ *
+ * @param name Algorithm name
+ * @param type Set to the matching algorithm
+ * @return CHECKSUM_SUCCESS, or CHECKSUM_ERROR_ARG for unknown names
+ */
+int checksum_type_from_name(const char *name, checksum_type_t *type);
+
+/*
+ * Get string representation of an error code
+ *
+ * @param error CHECKSUM_* error code
+ * @return Constant string describing the error
+ */
+const char *checksum_strerror(int error);
+
+/*
+ * Combine checksums of two adjacent blocks
+ *
+ * Given the checksums of block A and block B, return the checksum of A
+ * followed by B, as zlib's crc32_combine()/adler32_combine() do.
+ *
+ * @param sum1 Checksum of the first block
+ * @param sum2 Checksum of the second block
+ * @param len2 Length of the second block in bytes
+ * @return Checksum of the concatenation
+ */
+uint32_t checksum_crc32_combine(uint32_t sum1, uint32_t sum2, uint64_t len2);
+uint32_t checksum_crc32c_combine(uint32_t sum1, uint32_t sum2, uint64_t len2);
+uint32_t checksum_adler32_combine(uint32_t sum1, uint32_t sum2, uint64_t len2);
+
+/*
+ * Slide an Adler-32 window one byte forward
+ *
+ * @param adler Adler-32 of the current window
+ * @param out Byte leaving the window (its first byte)
+ * @param in Byte entering the window
+ * @param window Window length in bytes
+ * @return Adler-32 of the window shifted by one byte
+ */
+uint32_t checksum_adler32_roll(uint32_t adler, unsigned char out, unsigned char in, size_t window);
+
+/*
+ * rsync-style delta encoding
+ *
+ * A signature lists, for each block of a base file, a rolling Adler-32
+ * weak sum and a truncated BLAKE3 strong sum. A delta against it encodes a
+ * new file as copies of base ranges and literal bytes, plus the BLAKE3 of
+ * the new file, which checksum_patch() checks after rebuilding it.
+ */
+#define CHECKSUM_DELTA_STRONG  16   /* strong sum bytes kept per block */
+
+typedef struct {
+    uint32_t block_size;
+    uint64_t base_size;
+    size_t count;               /* blocks, the last may be short */
+    uint32_t *weak;
+    unsigned char *strong;      /* count * CHECKSUM_DELTA_STRONG bytes */
+    uint32_t *buckets;          /* weak sum hash table: block + 1, 0 if empty */
+    uint32_t *chain;            /* next block with the same bucket, + 1 */
+    size_t mask;
+} checksum_signature_t;
+
+/* Receives encoded output; returns 0, or nonzero to abort with CHECKSUM_ERROR_IO */
+typedef int (*checksum_write_fn)(void *ctx, const void *data, size_t len);
+
+/*
+ * Compute the signature of a base file held in memory
+ *
+ * @param sig Signature to fill; release with checksum_signature_free()
+ * @param base Base file contents
+ * @param len Base file length
+ * @param block_size Block length, or 0 to pick one from the file size
+ * @return CHECKSUM_SUCCESS, CHECKSUM_ERROR_ARG or CHECKSUM_ERROR_MEM
+ */
+int checksum_signature_build(checksum_signature_t *sig, const unsigned char *base, size_t len,
+                             uint32_t block_size);
+
+/*
+ * Serialize a signature, or parse one produced by checksum_signature_write()
+ *
+ * @return CHECKSUM_SUCCESS, CHECKSUM_ERROR_IO if write failed,
+ *         CHECKSUM_ERROR_DATA for a malformed signature, or CHECKSUM_ERROR_MEM
+ */
+int checksum_signature_write(const checksum_signature_t *sig, checksum_write_fn write, void *ctx);
+int checksum_signature_load(checksum_signature_t *sig, const void *data, size_t len);
+void checksum_signature_free(checksum_signature_t *sig);
+
+/*
+ * Encode a new file as a delta against a signature
+ *
+ * @param sig Signature of the base file
+ * @param data New file contents
+ * @param len New file length
+ * @param write Output callback
+ * @param ctx Passed to write
+ * @return CHECKSUM_SUCCESS, CHECKSUM_ERROR_IO or CHECKSUM_ERROR_MEM
+ */
+int checksum_delta(const checksum_signature_t *sig, const unsigned char *data, size_t len,
+                   checksum_write_fn write, void *ctx);
+
+/*
+ * Rebuild the new file from the base file and a delta
+ *
+ * Output is written as it is decoded; the caller must discard it unless
+ * CHECKSUM_SUCCESS is returned.
+ *
+ * @return CHECKSUM_SUCCESS, CHECKSUM_ERROR_IO if write failed, or
+ *         CHECKSUM_ERROR_DATA if the delta is malformed, was made for a
+ *         different base, or the result fails its BLAKE3 check
+ */
+int checksum_patch(const unsigned char *base, size_t base_len, const unsigned char *delta,
+                   size_t delta_len, checksum_write_fn write, void *ctx);
+
+/*
+ * Content-defined chunking (FastCDC)
+ *
+ * A gear hash over the last 64 bytes picks chunk boundaries from the
+ * content itself, so an insertion or deletion only moves the boundaries
+ * next to it. Normalized chunking uses a stricter mask below the average
+ * size and a looser one above it, keeping chunk sizes close to the average.
+ */
+typedef struct {
+    uint32_t min_size;
+    uint32_t avg_size;
+    uint32_t max_size;
+    uint64_t mask_small;        /* used before avg_size bytes */
+    uint64_t mask_large;        /* used after avg_size bytes */
+    uint64_t gear[256];
+} checksum_cdc_t;
+
+/*
+ * Set up a chunker
+ *
+ * @param cdc Chunker to initialize
+ * @param min_size Smallest chunk, except at the end of the input (at least 64)
+ * @param avg_size Target average chunk size
+ * @param max_size Largest chunk (at most 1 GiB)
+ * @return CHECKSUM_SUCCESS, or CHECKSUM_ERROR_ARG unless min <= avg <= max
+ */
+int checksum_cdc_init(checksum_cdc_t *cdc, uint32_t min_size, uint32_t avg_size,
+                      uint32_t max_size);
+
+/*
+ * Find the end of the chunk starting at data
+ *
+ * @param cdc Initialized chunker
+ * @param data Remaining input
+ * @param len Remaining input length
+ * @return Length of the next chunk, len if the input ends first (0 only if len is 0)
+ */
+size_t checksum_cdc_next(const checksum_cdc_t *cdc, const unsigned char *data, size_t len);
+
+/*
+ * Generic CRC engine (Rocksoft model)
+ *
+ * A CRC is described by its width, polynomial (normal form, without the
+ * x^width term), initial register, input/output reflection and final XOR.
+ * Every catalog entry carries slicing-by-8 tables generated at build time;
+ * reflected variants also use PCLMULQDQ folding where the CPU has it.
+ */
+typedef struct {
+    const char *name;           /* e.g. "CRC-16/ARC" */
+    const char *alias;          /* common alternative name, or NULL */
+    unsigned int width;         /* 8..64 bits */
+    uint64_t poly;
+    uint64_t init;
+    int refin;
+    int refout;
+    uint64_t xorout;
+    uint64_t check;             /* CRC of the ASCII string "123456789" */
+    const uint64_t (*table)[256];   /* generated slicing-by-8 table */
+    const uint64_t *fold;           /* generated PCLMUL folding constants */
+} checksum_crc_params_t;
+
+typedef struct {
+    const checksum_crc_params_t *params;
+    uint64_t crc;               /* raw register, reflected or left-aligned */
+} checksum_crc_ctx_t;
+
+/*
+ * List the built-in CRC variants
+ *
+ * @param count Set to the number of entries
+ * @return The catalog, in display order
+ */
+const checksum_crc_params_t *checksum_crc_catalog(size_t *count);
+
+/*
+ * Look up a CRC variant by name or alias, ignoring case
+ *
+ * "CRC-" may be omitted, so "16/arc" finds CRC-16/ARC.
+ *
+ * @param name Variant name
+ * @return The catalog entry, or NULL if there is none
+ */
+const checksum_crc_params_t *checksum_crc_find(const char *name);
+
+void checksum_crc_init(checksum_crc_ctx_t *ctx, const checksum_crc_params_t *params);
+void checksum_crc_update(checksum_crc_ctx_t *ctx, const unsigned char *data, size_t len);
+
+/*
+ * Finish a CRC; the context is left unchanged and may be updated further
+ *
+ * @return The CRC in the low params->width bits
+ */
+uint64_t checksum_crc_final(const checksum_crc_ctx_t *ctx);
+
+/* One-shot CRC of a buffer */
+uint64_t checksum_crc(const checksum_crc_params_t *params, const unsigned char *data, size_t len);
+
+/*
+ * Checksum everything readable from a stdio stream
+ *
+ * @param stream Stream to read until EOF
+ * @param type Checksum algorithm
+ * @param result Filled with the checksum
+ * @return CHECKSUM_SUCCESS on success, error code otherwise
+ */
 int checksum_file_stream(FILE *stream, checksum_type_t type, checksum_result_t *result);
-int checksum_verify_file(const char *checksum_file);
+
+/* checksum_verify_options_t.cache */
+#define CHECKSUM_CACHE_OFF      0   /* never read or write cached digests */
+#define CHECKSUM_CACHE_USE      1   /* reuse user.checksum.* xattr digests, store new ones */
+#define CHECKSUM_CACHE_REFRESH  2   /* recompute every digest and store it */
+
+/* How checksum_verify_file() reads the list and reports */
+typedef struct {
+    const checksum_type_t *algos;   /* one HEX column per algorithm, in order */
+    size_t nalgos;                  /* 1 to 8 */
+    unsigned int jobs;              /* files hashed in parallel; 0 or 1 for one thread */
+    int quiet;                      /* report failures only, without the summary */
+    int fail_fast;                  /* stop at the first failure */
+    int zero;                       /* end report lines with NUL, names unescaped */
+    int cache;                      /* CHECKSUM_CACHE_* */
+} checksum_verify_options_t;
+
+/*
+ * Verify every entry of a checksum list, printing a report to stdout
+ *
+ * Each call has its own buffers, so several threads may verify at once.
+ *
+ * @param checksum_file Path of the list, or "-" for standard input
+ * @param options Algorithms, reporting and caching, or NULL for CRC32 lines on
+ *        one thread without the cache
+ * @return 0 if every listed file matched, 1 otherwise, or
+ *         CHECKSUM_ERROR_ARG for invalid options
+ */
+int checksum_verify_file(const char *checksum_file, const checksum_verify_options_t *options);
 
 #ifdef __cplusplus
 }
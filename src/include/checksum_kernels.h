@@ -0,0 +1,193 @@
+/*
+ * checksum_kernels.h - Internal checksum kernels and CPU feature detection
+ *
+ * Copyright (c) 2025 AnmiTaliDev
+ * Created: 2025-08-09
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef CHECKSUM_KERNELS_H
+#define CHECKSUM_KERNELS_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "checksum.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* x86 SIMD kernels are built with per-function target attributes */
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#define CHECKSUM_HAVE_X86_SIMD 1
+#else
+#define CHECKSUM_HAVE_X86_SIMD 0
+#endif
+
+/* CPU feature flags returned by checksum_cpu_features() */
+#define CHECKSUM_CPU_SSE2      (1u << 0)
+#define CHECKSUM_CPU_SSSE3     (1u << 1)
+#define CHECKSUM_CPU_SSE41     (1u << 2)
+#define CHECKSUM_CPU_SSE42     (1u << 3)
+#define CHECKSUM_CPU_PCLMUL    (1u << 4)
+#define CHECKSUM_CPU_AVX       (1u << 5)
+#define CHECKSUM_CPU_AVX2      (1u << 6)
+#define CHECKSUM_CPU_AVX512F   (1u << 7)
+#define CHECKSUM_CPU_AVX512BW  (1u << 8)
+#define CHECKSUM_CPU_AVX512VL  (1u << 9)
+#define CHECKSUM_CPU_VPCLMUL   (1u << 10)
+#define CHECKSUM_CPU_SHA       (1u << 11)
+
+/*
+ * Detect CPU features usable by the SIMD kernels
+ *
+ * Queries cpuid once and caches the result. AVX and AVX-512 features
+ * are only reported when the OS saves the corresponding register state.
+ * A CHECKSUM_CPU_MASK environment variable (e.g. "0" or "0x7f") masks the
+ * result, to force the portable or an older kernel set for testing.
+ *
+ * @return Bitmask of CHECKSUM_CPU_* flags (0 on non-x86 targets)
+ */
+unsigned int checksum_cpu_features(void);
+
+/*
+ * CRC32 (IEEE 802.3, reflected 0xedb88320) kernels
+ *
+ * All kernels operate on the raw CRC register: start from 0xffffffff and
+ * invert the final value. The PCLMULQDQ kernels may only be called when
+ * checksum_cpu_features() reports the matching flags; they handle any
+ * length and alignment, falling back to the table kernel for short tails.
+ */
+uint32_t checksum_crc32_raw(uint32_t crc, const unsigned char *data, size_t len);
+uint32_t checksum_crc32_raw_table(uint32_t crc, const unsigned char *data, size_t len);
+#if CHECKSUM_HAVE_X86_SIMD
+uint32_t checksum_crc32_raw_pclmul(uint32_t crc, const unsigned char *data, size_t len);
+uint32_t checksum_crc32_raw_vpclmul(uint32_t crc, const unsigned char *data, size_t len);
+uint32_t checksum_crc32_raw_vpclmul_avx2(uint32_t crc, const unsigned char *data, size_t len);
+#endif
+
+/*
+ * GF(2) arithmetic modulo a reflected 32-bit CRC polynomial
+ *
+ * multmodp() returns a * b mod P; x8nmodp() returns x^(8n) mod P, the
+ * operator that advances a CRC register over n zero bytes.
+ */
+uint32_t checksum_gf2_multmodp(uint32_t a, uint32_t b, uint32_t poly);
+uint32_t checksum_gf2_x8nmodp(uint64_t n, uint32_t poly);
+
+/* Advance a raw CRC32 / CRC32C register over len zero bytes in O(log len) */
+uint32_t checksum_crc32_raw_zeros(uint32_t crc, uint64_t len);
+uint32_t checksum_crc32c_raw_zeros(uint32_t crc, uint64_t len);
+
+/*
+ * CRC32C (Castagnoli, reflected 0x82f63b78) kernels
+ *
+ * Same register conventions as CRC32. The SSE4.2 kernel uses the crc32
+ * instruction on three interleaved streams.
+ */
+uint32_t checksum_crc32c_raw(uint32_t crc, const unsigned char *data, size_t len);
+uint32_t checksum_crc32c_raw_table(uint32_t crc, const unsigned char *data, size_t len);
+#if CHECKSUM_HAVE_X86_SIMD
+uint32_t checksum_crc32c_raw_sse42(uint32_t crc, const unsigned char *data, size_t len);
+#endif
+
+/*
+ * Generic CRC kernels over a catalog entry's raw register (see
+ * checksum_crc_ctx_t). The PCLMULQDQ kernel only handles reflected
+ * variants and needs CHECKSUM_CPU_PCLMUL and CHECKSUM_CPU_SSE41.
+ */
+uint64_t checksum_crc_raw_table(const checksum_crc_params_t *params, uint64_t crc,
+                                const unsigned char *data, size_t len);
+#if CHECKSUM_HAVE_X86_SIMD
+uint64_t checksum_crc_raw_pclmul(const checksum_crc_params_t *params, uint64_t crc,
+                                 const unsigned char *data, size_t len);
+#endif
+
+/*
+ * Adler-32 kernels
+ *
+ * State is packed as (b << 16) | a, starting from 1. All kernels defer the
+ * modulo to once per NMAX (5552) bytes and produce identical results.
+ */
+uint32_t checksum_adler32_raw(uint32_t adler, const unsigned char *data, size_t len);
+uint32_t checksum_adler32_raw_scalar(uint32_t adler, const unsigned char *data, size_t len);
+#if CHECKSUM_HAVE_X86_SIMD
+uint32_t checksum_adler32_raw_ssse3(uint32_t adler, const unsigned char *data, size_t len);
+uint32_t checksum_adler32_raw_avx2(uint32_t adler, const unsigned char *data, size_t len);
+#endif
+
+/* Adler-32 over len zero bytes: a is unchanged and b grows by len * a */
+uint32_t checksum_adler32_raw_zeros(uint32_t adler, uint64_t len);
+
+/* Compress whole 64-byte blocks into a big-endian word state */
+void checksum_sha256_blocks(uint32_t *state, const unsigned char *data, size_t blocks);
+void checksum_sha256_blocks_scalar(uint32_t *state, const unsigned char *data, size_t blocks);
+void checksum_sha1_blocks(uint32_t *state, const unsigned char *data, size_t blocks);
+void checksum_sha1_blocks_scalar(uint32_t *state, const unsigned char *data, size_t blocks);
+#if CHECKSUM_HAVE_X86_SIMD
+void checksum_sha256_blocks_shani(uint32_t *state, const unsigned char *data, size_t blocks);
+void checksum_sha1_blocks_shani(uint32_t *state, const unsigned char *data, size_t blocks);
+#endif
+
+/*
+ * XXH3 long-input kernels with the default secret layout: accumulate
+ * consecutive 64-byte stripes, advancing the secret by 8 bytes per stripe,
+ * and scramble the eight accumulators at the end of each block
+ */
+void checksum_xxh3_accumulate_scalar(uint64_t acc[8], const unsigned char *input,
+                                     const unsigned char *secret, size_t stripes);
+void checksum_xxh3_scramble_scalar(uint64_t acc[8], const unsigned char *secret);
+#if CHECKSUM_HAVE_X86_SIMD
+void checksum_xxh3_accumulate_sse2(uint64_t acc[8], const unsigned char *input,
+                                   const unsigned char *secret, size_t stripes);
+void checksum_xxh3_scramble_sse2(uint64_t acc[8], const unsigned char *secret);
+void checksum_xxh3_accumulate_avx2(uint64_t acc[8], const unsigned char *input,
+                                   const unsigned char *secret, size_t stripes);
+void checksum_xxh3_scramble_avx2(uint64_t acc[8], const unsigned char *secret);
+#endif
+
+/*
+ * Hash num_inputs equal-length BLAKE3 inputs of `blocks` 64-byte blocks
+ * each, writing one 32-byte chaining value per input to out
+ */
+void checksum_blake3_hash_many(const unsigned char *const *inputs, size_t num_inputs,
+                               size_t blocks, const uint32_t key[8], uint64_t counter,
+                               int increment, uint8_t flags, uint8_t flags_start,
+                               uint8_t flags_end, unsigned char *out);
+void checksum_blake3_hash_many_portable(const unsigned char *const *inputs, size_t num_inputs,
+                                        size_t blocks, const uint32_t key[8], uint64_t counter,
+                                        int increment, uint8_t flags, uint8_t flags_start,
+                                        uint8_t flags_end, unsigned char *out);
+#if CHECKSUM_HAVE_X86_SIMD
+void checksum_blake3_hash_many_sse41(const unsigned char *const *inputs, size_t num_inputs,
+                                     size_t blocks, const uint32_t key[8], uint64_t counter,
+                                     int increment, uint8_t flags, uint8_t flags_start,
+                                     uint8_t flags_end, unsigned char *out);
+void checksum_blake3_hash_many_avx2(const unsigned char *const *inputs, size_t num_inputs,
+                                    size_t blocks, const uint32_t key[8], uint64_t counter,
+                                    int increment, uint8_t flags, uint8_t flags_start,
+                                    uint8_t flags_end, unsigned char *out);
+void checksum_blake3_hash_many_avx512(const unsigned char *const *inputs, size_t num_inputs,
+                                      size_t blocks, const uint32_t key[8], uint64_t counter,
+                                      int increment, uint8_t flags, uint8_t flags_start,
+                                      uint8_t flags_end, unsigned char *out);
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CHECKSUM_KERNELS_H */
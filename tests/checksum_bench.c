@@ -0,0 +1,444 @@
+/*
+ * checksum_bench.c - Throughput benchmark for checksum algorithms and kernels
+ *
+ * Copyright (c) 2025 AnmiTaliDev
+ * Created: 2025-08-09
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Usage: checksum_bench [--max=SIZE] [--align=LIST] [--filter=TEXT] [--time=MS]
+ *
+ * Measures every algorithm through the streaming API ("api/...") and every
+ * kernel variant the CPU supports ("kernel/..."), for buffer sizes from 64
+ * bytes up to SIZE (default 1G) in powers of four, at each byte offset in
+ * LIST (default 0,1,3) from a 64-byte aligned buffer. Each measurement
+ * repeats until MS milliseconds (default 100) have passed and reports the
+ * mean throughput in GB/s (10^9 bytes per second).
+ *
+ * Run with CHECKSUM_CPU_MASK set to see what the "api" rows lose without
+ * a given instruction set.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <getopt.h>
+#include <time.h>
+
+#include "checksum.h"
+#include "checksum_kernels.h"
+
+#define BENCH_MIN_SIZE    64
+#define BENCH_MAX_ALIGNS  16
+
+/* BLAKE3 chunks are hashed in batches so the output buffer stays small */
+#define BLAKE3_CHUNK      1024
+#define BLAKE3_BATCH      16
+
+/* One XXH3 block: 16 stripes of 64 bytes with the 192-byte default secret */
+#define XXH3_STRIPES      16
+#define XXH3_BLOCK        (XXH3_STRIPES * 64)
+
+typedef void (*bench_fn)(const unsigned char *data, size_t len);
+
+typedef struct {
+    const char *name;
+    unsigned int cpu;           /* CHECKSUM_CPU_* flags the kernel needs */
+    bench_fn run;
+} bench_kernel_t;
+
+/* Results land here so the compiler cannot drop the work */
+static volatile uint64_t sink;
+
+static const uint32_t blake3_iv[8] = {
+    0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a,
+    0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19
+};
+
+static unsigned char xxh3_secret[192];
+static const checksum_crc_params_t *crc64;
+
+static void run_api(checksum_type_t type, const unsigned char *data, size_t len) {
+    checksum_ctx_t ctx;
+    checksum_result_t result;
+
+    checksum_init(&ctx, type);
+    checksum_update(&ctx, data, len);
+    checksum_final(&ctx, &result);
+    sink += result.value;
+}
+
+static void api_crc32(const unsigned char *d, size_t n)    { run_api(CHECKSUM_CRC32, d, n); }
+static void api_crc32c(const unsigned char *d, size_t n)   { run_api(CHECKSUM_CRC32C, d, n); }
+static void api_adler32(const unsigned char *d, size_t n)  { run_api(CHECKSUM_ADLER32, d, n); }
+static void api_bsd_sum(const unsigned char *d, size_t n)  { run_api(CHECKSUM_BSD_SUM, d, n); }
+static void api_sha256(const unsigned char *d, size_t n)   { run_api(CHECKSUM_SHA256, d, n); }
+static void api_sha1(const unsigned char *d, size_t n)     { run_api(CHECKSUM_SHA1, d, n); }
+static void api_blake3(const unsigned char *d, size_t n)   { run_api(CHECKSUM_BLAKE3, d, n); }
+static void api_xxh64(const unsigned char *d, size_t n)    { run_api(CHECKSUM_XXH64, d, n); }
+static void api_xxh3(const unsigned char *d, size_t n)     { run_api(CHECKSUM_XXH3_64, d, n); }
+static void api_xxh128(const unsigned char *d, size_t n)   { run_api(CHECKSUM_XXH3_128, d, n); }
+
+static void api_crc64(const unsigned char *d, size_t n) {
+    sink += checksum_crc(crc64, d, n);
+}
+
+static void crc32_table(const unsigned char *d, size_t n) {
+    sink += checksum_crc32_raw_table(0xffffffff, d, n);
+}
+
+static void crc32c_table(const unsigned char *d, size_t n) {
+    sink += checksum_crc32c_raw_table(0xffffffff, d, n);
+}
+
+static void crc64_table(const unsigned char *d, size_t n) {
+    sink += checksum_crc_raw_table(crc64, ~(uint64_t)0, d, n);
+}
+
+static void adler32_scalar(const unsigned char *d, size_t n) {
+    sink += checksum_adler32_raw_scalar(1, d, n);
+}
+
+static void sha256_scalar(const unsigned char *d, size_t n) {
+    uint32_t state[8] = { 0 };
+
+    checksum_sha256_blocks_scalar(state, d, n / 64);
+    sink += state[0];
+}
+
+static void sha1_scalar(const unsigned char *d, size_t n) {
+    uint32_t state[5] = { 0 };
+
+    checksum_sha1_blocks_scalar(state, d, n / 64);
+    sink += state[0];
+}
+
+typedef void (*xxh3_accumulate_fn)(uint64_t acc[8], const unsigned char *input,
+                                   const unsigned char *secret, size_t stripes);
+typedef void (*xxh3_scramble_fn)(uint64_t acc[8], const unsigned char *secret);
+
+static void run_xxh3(xxh3_accumulate_fn accumulate, xxh3_scramble_fn scramble,
+                     const unsigned char *d, size_t n) {
+    uint64_t acc[8] = { 0 };
+
+    for (size_t off = 0; off + XXH3_BLOCK <= n; off += XXH3_BLOCK) {
+        accumulate(acc, d + off, xxh3_secret, XXH3_STRIPES);
+        scramble(acc, xxh3_secret + 128);
+    }
+    sink += acc[0];
+}
+
+static void xxh3_scalar(const unsigned char *d, size_t n) {
+    run_xxh3(checksum_xxh3_accumulate_scalar, checksum_xxh3_scramble_scalar, d, n);
+}
+
+typedef void (*blake3_many_fn)(const unsigned char *const *inputs, size_t num_inputs,
+                               size_t blocks, const uint32_t key[8], uint64_t counter,
+                               int increment, uint8_t flags, uint8_t flags_start,
+                               uint8_t flags_end, unsigned char *out);
+
+static void run_blake3(blake3_many_fn hash_many, const unsigned char *d, size_t n) {
+    const unsigned char *inputs[BLAKE3_BATCH];
+    unsigned char out[BLAKE3_BATCH * 32];
+    size_t chunks = n / BLAKE3_CHUNK;
+
+    for (size_t c = 0; c < chunks; c += BLAKE3_BATCH) {
+        size_t count = chunks - c < BLAKE3_BATCH ? chunks - c : BLAKE3_BATCH;
+
+        for (size_t i = 0; i < count; i++) {
+            inputs[i] = d + (c + i) * BLAKE3_CHUNK;
+        }
+        hash_many(inputs, count, BLAKE3_CHUNK / 64, blake3_iv, c, 1, 0, 1, 2, out);
+        sink += out[0];
+    }
+}
+
+static void blake3_portable(const unsigned char *d, size_t n) {
+    run_blake3(checksum_blake3_hash_many_portable, d, n);
+}
+
+#if CHECKSUM_HAVE_X86_SIMD
+static void crc32_pclmul(const unsigned char *d, size_t n) {
+    sink += checksum_crc32_raw_pclmul(0xffffffff, d, n);
+}
+
+static void crc32_vpclmul(const unsigned char *d, size_t n) {
+    sink += checksum_crc32_raw_vpclmul(0xffffffff, d, n);
+}
+
+static void crc32_vpclmul_avx2(const unsigned char *d, size_t n) {
+    sink += checksum_crc32_raw_vpclmul_avx2(0xffffffff, d, n);
+}
+
+static void crc32c_sse42(const unsigned char *d, size_t n) {
+    sink += checksum_crc32c_raw_sse42(0xffffffff, d, n);
+}
+
+static void crc64_pclmul(const unsigned char *d, size_t n) {
+    sink += checksum_crc_raw_pclmul(crc64, ~(uint64_t)0, d, n);
+}
+
+static void adler32_ssse3(const unsigned char *d, size_t n) {
+    sink += checksum_adler32_raw_ssse3(1, d, n);
+}
+
+static void adler32_avx2(const unsigned char *d, size_t n) {
+    sink += checksum_adler32_raw_avx2(1, d, n);
+}
+
+static void sha256_shani(const unsigned char *d, size_t n) {
+    uint32_t state[8] = { 0 };
+
+    checksum_sha256_blocks_shani(state, d, n / 64);
+    sink += state[0];
+}
+
+static void sha1_shani(const unsigned char *d, size_t n) {
+    uint32_t state[5] = { 0 };
+
+    checksum_sha1_blocks_shani(state, d, n / 64);
+    sink += state[0];
+}
+
+static void xxh3_sse2(const unsigned char *d, size_t n) {
+    run_xxh3(checksum_xxh3_accumulate_sse2, checksum_xxh3_scramble_sse2, d, n);
+}
+
+static void xxh3_avx2(const unsigned char *d, size_t n) {
+    run_xxh3(checksum_xxh3_accumulate_avx2, checksum_xxh3_scramble_avx2, d, n);
+}
+
+static void blake3_sse41(const unsigned char *d, size_t n) {
+    run_blake3(checksum_blake3_hash_many_sse41, d, n);
+}
+
+static void blake3_avx2(const unsigned char *d, size_t n) {
+    run_blake3(checksum_blake3_hash_many_avx2, d, n);
+}
+
+static void blake3_avx512(const unsigned char *d, size_t n) {
+    run_blake3(checksum_blake3_hash_many_avx512, d, n);
+}
+#endif
+
+static const bench_kernel_t kernels[] = {
+    {"api/crc32", 0, api_crc32},
+    {"api/crc32c", 0, api_crc32c},
+    {"api/adler32", 0, api_adler32},
+    {"api/bsd-sum", 0, api_bsd_sum},
+    {"api/sha256", 0, api_sha256},
+    {"api/sha1", 0, api_sha1},
+    {"api/blake3", 0, api_blake3},
+    {"api/xxh64", 0, api_xxh64},
+    {"api/xxh3", 0, api_xxh3},
+    {"api/xxh128", 0, api_xxh128},
+    {"api/crc-64/xz", 0, api_crc64},
+    {"kernel/crc32-table", 0, crc32_table},
+    {"kernel/crc32c-table", 0, crc32c_table},
+    {"kernel/crc-64/xz-table", 0, crc64_table},
+    {"kernel/adler32-scalar", 0, adler32_scalar},
+    {"kernel/sha256-scalar", 0, sha256_scalar},
+    {"kernel/sha1-scalar", 0, sha1_scalar},
+    {"kernel/xxh3-scalar", 0, xxh3_scalar},
+    {"kernel/blake3-portable", 0, blake3_portable},
+#if CHECKSUM_HAVE_X86_SIMD
+    {"kernel/crc32-pclmul", CHECKSUM_CPU_PCLMUL | CHECKSUM_CPU_SSE41, crc32_pclmul},
+    {"kernel/crc32-vpclmul",
+     CHECKSUM_CPU_VPCLMUL | CHECKSUM_CPU_AVX512F | CHECKSUM_CPU_AVX512VL, crc32_vpclmul},
+    {"kernel/crc32-vpclmul-avx2",
+     CHECKSUM_CPU_VPCLMUL | CHECKSUM_CPU_AVX2 | CHECKSUM_CPU_SSE41, crc32_vpclmul_avx2},
+    {"kernel/crc32c-sse42", CHECKSUM_CPU_SSE42, crc32c_sse42},
+    {"kernel/crc-64/xz-pclmul", CHECKSUM_CPU_PCLMUL | CHECKSUM_CPU_SSE41, crc64_pclmul},
+    {"kernel/adler32-ssse3", CHECKSUM_CPU_SSSE3, adler32_ssse3},
+    {"kernel/adler32-avx2", CHECKSUM_CPU_AVX2, adler32_avx2},
+    {"kernel/sha256-shani", CHECKSUM_CPU_SHA | CHECKSUM_CPU_SSE41, sha256_shani},
+    {"kernel/sha1-shani", CHECKSUM_CPU_SHA | CHECKSUM_CPU_SSE41, sha1_shani},
+    {"kernel/xxh3-sse2", CHECKSUM_CPU_SSE2, xxh3_sse2},
+    {"kernel/xxh3-avx2", CHECKSUM_CPU_AVX2, xxh3_avx2},
+    {"kernel/blake3-sse41", CHECKSUM_CPU_SSE41, blake3_sse41},
+    {"kernel/blake3-avx2", CHECKSUM_CPU_SSE41 | CHECKSUM_CPU_AVX2, blake3_avx2},
+    {"kernel/blake3-avx512",
+     CHECKSUM_CPU_SSE41 | CHECKSUM_CPU_AVX2 | CHECKSUM_CPU_AVX512F, blake3_avx512},
+#endif
+};
+
+static uint64_t monotonic_ns(void) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+/* Parse a byte count with an optional K, M or G (binary) suffix */
+static int parse_size(const char *text, size_t *size) {
+    char *end;
+    unsigned long long value = strtoull(text, &end, 10);
+    unsigned int shift = 0;
+
+    if (end == text) {
+        return -1;
+    }
+    switch (*end) {
+        case 'K': case 'k': shift = 10; end++; break;
+        case 'M': case 'm': shift = 20; end++; break;
+        case 'G': case 'g': shift = 30; end++; break;
+        default: break;
+    }
+    if (*end != '\0' || value > (SIZE_MAX >> shift)) {
+        return -1;
+    }
+    *size = (size_t)(value << shift);
+    return 0;
+}
+
+static int parse_aligns(char *text, size_t *aligns, size_t *count) {
+    *count = 0;
+    for (char *item = strtok(text, ","); item; item = strtok(NULL, ",")) {
+        char *end;
+        unsigned long value = strtoul(item, &end, 10);
+
+        if (end == item || *end != '\0' || value >= 64 || *count == BENCH_MAX_ALIGNS) {
+            return -1;
+        }
+        aligns[(*count)++] = value;
+    }
+    return *count > 0 ? 0 : -1;
+}
+
+static void usage(const char *prog) {
+    fprintf(stderr,
+            "Usage: %s [--max=SIZE] [--align=LIST] [--filter=TEXT] [--time=MS]\n"
+            "  --max=SIZE     Largest buffer, e.g. 64M (default 1G)\n"
+            "  --align=LIST   Byte offsets from a 64-byte boundary (default 0,1,3)\n"
+            "  --filter=TEXT  Only run algorithms and kernels whose name contains TEXT\n"
+            "  --time=MS      Minimum time per measurement (default 100)\n",
+            prog);
+}
+
+int main(int argc, char *argv[]) {
+    static const struct option long_options[] = {
+        {"max",    required_argument, 0, 'm'},
+        {"align",  required_argument, 0, 'a'},
+        {"filter", required_argument, 0, 'f'},
+        {"time",   required_argument, 0, 't'},
+        {"help",   no_argument,       0, 'h'},
+        {0, 0, 0, 0}
+    };
+    size_t max_size = (size_t)1 << 30;
+    size_t aligns[BENCH_MAX_ALIGNS] = { 0, 1, 3 };
+    size_t align_count = 3;
+    const char *filter = NULL;
+    uint64_t min_ns = 100 * 1000000ULL;
+    unsigned int cpu = checksum_cpu_features();
+    unsigned char *buf;
+    uint64_t rng = 0x9e3779b97f4a7c15ULL;
+    int opt;
+
+    while ((opt = getopt_long(argc, argv, "h", long_options, NULL)) != -1) {
+        switch (opt) {
+            case 'm':
+                if (parse_size(optarg, &max_size) != 0 || max_size < BENCH_MIN_SIZE) {
+                    fprintf(stderr, "%s: invalid size '%s'\n", argv[0], optarg);
+                    return 1;
+                }
+                break;
+            case 'a':
+                if (parse_aligns(optarg, aligns, &align_count) != 0) {
+                    fprintf(stderr, "%s: invalid alignment list '%s'\n", argv[0], optarg);
+                    return 1;
+                }
+                break;
+            case 'f':
+                filter = optarg;
+                break;
+            case 't': {
+                char *end;
+                unsigned long ms = strtoul(optarg, &end, 10);
+
+                if (end == optarg || *end != '\0' || ms == 0) {
+                    fprintf(stderr, "%s: invalid time '%s'\n", argv[0], optarg);
+                    return 1;
+                }
+                min_ns = (uint64_t)ms * 1000000ULL;
+                break;
+            }
+            case 'h':
+                usage(argv[0]);
+                return 0;
+            default:
+                usage(argv[0]);
+                return 1;
+        }
+    }
+
+    crc64 = checksum_crc_find("CRC-64/XZ");
+    buf = malloc(max_size + 128);
+    if (!crc64 || !buf) {
+        fprintf(stderr, "%s: out of memory\n", argv[0]);
+        free(buf);
+        return 1;
+    }
+
+    /* Random input: some kernels have data-dependent fast paths for zeros */
+    for (size_t i = 0; i < max_size + 128; i++) {
+        rng ^= rng >> 12;
+        rng ^= rng << 25;
+        rng ^= rng >> 27;
+        buf[i] = (unsigned char)((rng * 0x2545f4914f6cdd1dULL) >> 56);
+    }
+    memcpy(xxh3_secret, buf, sizeof(xxh3_secret));
+
+    printf("cpu features: 0x%x\n", cpu);
+    printf("%-26s %12s %6s %10s\n", "name", "size", "align", "GB/s");
+
+    for (size_t k = 0; k < sizeof(kernels) / sizeof(kernels[0]); k++) {
+        const bench_kernel_t *kernel = &kernels[k];
+
+        if ((cpu & kernel->cpu) != kernel->cpu ||
+            (filter && !strstr(kernel->name, filter))) {
+            continue;
+        }
+
+        for (size_t size = BENCH_MIN_SIZE; size <= max_size; size *= 4) {
+            for (size_t a = 0; a < align_count; a++) {
+                /* Offset from the first 64-byte boundary inside the buffer */
+                const unsigned char *data = buf + ((64 - (uintptr_t)buf % 64) % 64) + aligns[a];
+                uint64_t start = monotonic_ns();
+                uint64_t elapsed;
+                uint64_t reps = 0;
+
+                do {
+                    kernel->run(data, size);
+                    reps++;
+                    elapsed = monotonic_ns() - start;
+                } while (elapsed < min_ns);
+
+                printf("%-26s %12zu %6zu %10.2f\n", kernel->name, size, aligns[a],
+                       (double)size * (double)reps / (double)elapsed);
+                fflush(stdout);
+            }
+            if (size > max_size / 4) {
+                break;
+            }
+        }
+    }
+
+    free(buf);
+    return 0;
+}
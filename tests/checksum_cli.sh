@@ -0,0 +1,85 @@
+#!/bin/sh
+#
+# checksum_cli.sh - Output format checks for the checksum command
+#
+# Copyright (c) 2025 AnmiTaliDev
+# Created: 2025-08-09
+#
+# This program is free software: you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation, either version 3 of the License, or
+# (at your option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program.  If not, see <https://www.gnu.org/licenses/>.
+#
+# Usage: checksum_cli.sh CHECKSUM_BINARY
+
+checksum=$1
+dir=$(mktemp -d) || exit 1
+trap 'rm -rf "$dir"' EXIT
+failures=0
+
+fail() {
+    echo "FAIL: $*" >&2
+    failures=$((failures + 1))
+}
+
+inode() {
+    ls -i "$1" | awk '{ print $1 }'
+}
+
+# 10000 bytes: two full 4 KiB blocks and a short one
+i=0
+while [ $i -lt 1000 ]; do
+    printf '0123456789'
+    i=$((i + 1))
+done > "$dir/data"
+
+# --blocks: the header names the file and precedes the digest lines
+"$checksum" --crc32 --blocks=4K "$dir/data" > "$dir/map" || fail "--blocks exited with $?"
+header=$(sed -n 1p "$dir/map")
+[ "$header" = "#blocks CRC32 4096 10000  $dir/data" ] || fail "--blocks header: '$header'"
+[ "$(wc -l < "$dir/map")" -eq 4 ] || fail "--blocks: expected 4 lines, got $(wc -l < "$dir/map")"
+[ "$(sed -n 2p "$dir/map" | wc -c)" -eq 9 ] || fail "--blocks digest line: '$(sed -n 2p "$dir/map")'"
+
+# The map round-trips through --compare
+"$checksum" --compare="$dir/map" "$dir/data" > "$dir/compare" || fail "--compare exited with $?"
+[ "$(cat "$dir/compare")" = "$dir/data: OK" ] || fail "--compare: '$(cat "$dir/compare")'"
+
+# A header promising more blocks than the map holds is rejected
+printf '#blocks CRC32 1 18446744073709551615  x\n00000000\n' > "$dir/bad"
+"$checksum" --compare="$dir/bad" "$dir/data" > /dev/null 2>&1 && fail "--compare accepted a short map"
+
+# -v with several algorithms on several threads reports in list order
+cp "$dir/data" "$dir/copy"
+"$checksum" -A sha256,crc32 "$dir/data" "$dir/copy" > "$dir/list" || fail "-A exited with $?"
+"$checksum" -A sha256,crc32 -j 2 -v "$dir/list" > "$dir/verify" 2> /dev/null ||
+    fail "-v exited with $?"
+[ "$(cat "$dir/verify")" = "$dir/data: OK
+$dir/copy: OK" ] || fail "-v: '$(cat "$dir/verify")'"
+printf 'x' >> "$dir/copy"
+"$checksum" -A sha256,crc32 -q -v "$dir/list" > "$dir/verify" 2> /dev/null &&
+    fail "-v accepted a changed file"
+[ "$(cat "$dir/verify")" = "$dir/copy: FAILED" ] || fail "-v -q: '$(cat "$dir/verify")'"
+
+# --find-dups --link=hard joins duplicates and leaves same-size files alone
+mkdir "$dir/dups"
+printf 'same contents' > "$dir/dups/a"
+printf 'same contents' > "$dir/dups/b"
+printf 'diff contents' > "$dir/dups/c"
+"$checksum" -q --find-dups --link=hard "$dir/dups" > /dev/null || fail "--link exited with $?"
+[ "$(inode "$dir/dups/a")" = "$(inode "$dir/dups/b")" ] || fail "--link=hard: a and b not linked"
+[ "$(inode "$dir/dups/a")" != "$(inode "$dir/dups/c")" ] || fail "--link=hard: linked c"
+[ "$(cat "$dir/dups/c")" = "diff contents" ] || fail "--link=hard: c changed"
+
+if [ $failures -ne 0 ]; then
+    echo "$failures check(s) failed" >&2
+    exit 1
+fi
+echo "all checks passed"
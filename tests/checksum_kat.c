@@ -0,0 +1,697 @@
+/*
+ * checksum_kat.c - Known-answer tests for every checksum algorithm
+ *
+ * Copyright (c) 2025 AnmiTaliDev
+ * Created: 2025-08-09
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Each vector is the digest of the first LENGTH bytes of the pattern
+ * 0, 1, ..., 250, 0, 1, ... (byte i is i % 251), as in the BLAKE3 test
+ * vectors. The expected values come from independent implementations
+ * (zlib, OpenSSL, the BLAKE3 and xxHash reference code, bitwise Rocksoft
+ * CRC models), not from this library.
+ *
+ * The lengths straddle every block, lane and chunk boundary the kernels
+ * care about. Run the binary with CHECKSUM_CPU_MASK set to check a
+ * particular kernel set; meson runs it once per instruction set level.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <sys/uio.h>
+
+#include "checksum.h"
+#include "checksum_kernels.h"
+
+#define KAT_LENGTHS 33
+
+static const size_t kat_lengths[KAT_LENGTHS] = {
+    0, 1, 3, 4, 7, 8, 15, 16, 31, 32, 33, 63, 64, 65, 127, 128, 129, 240, 241, 255, 256, 1023,
+    1024, 1025, 2048, 4095, 4096, 5553, 8193, 16384, 65536, 102400, 1048577
+};
+
+typedef struct {
+    checksum_type_t type;
+    const char *hex[KAT_LENGTHS];
+} kat_vector_t;
+
+typedef struct {
+    const char *name;
+    uint64_t value[KAT_LENGTHS];
+} kat_crc_vector_t;
+
+static const kat_vector_t kat_vectors[] = {
+    {CHECKSUM_CRC32, {
+        "00000000",
+        "d202ef8d",
+        "0854897f",
+        "8bb98613",
+        "ad5809f9",
+        "88aa689f",
+        "a06c675e",
+        "cecee288",
+        "4d786d77",
+        "91267e8a",
+        "e4908305",
+        "dbdea683",
+        "100ece8c",
+        "40c06fd8",
+        "dec481aa",
+        "24650d57",
+        "ca91cdf7",
+        "a60b0b66",
+        "cbc8d2f7",
+        "6f7c9956",
+        "5708a3cc",
+        "5a9e0eff",
+        "7be4dfd0",
+        "4e700dfb",
+        "dd34ad61",
+        "d1a3950a",
+        "d465f907",
+        "436df98f",
+        "affb0d4d",
+        "e93e4269",
+        "7faa50d3",
+        "5cc1ce13",
+        "3e8e13cb"
+    }},
+    {CHECKSUM_CRC32C, {
+        "00000000",
+        "527d5351",
+        "92fd4bfa",
+        "d9331aa3",
+        "a359ed4c",
+        "8a2cbc3b",
+        "68ef03f6",
+        "d9c908eb",
+        "e95cabcb",
+        "46dd794e",
+        "9f85a26d",
+        "7a873004",
+        "fb6d36eb",
+        "694420fa",
+        "6c31bd0c",
+        "30d9c515",
+        "f514629f",
+        "9f4f71d6",
+        "54fe7516",
+        "ebbd63b3",
+        "3449f810",
+        "39a4911a",
+        "2af62c0c",
+        "c8d03add",
+        "9f7e33f0",
+        "5e9ee87c",
+        "719077fc",
+        "eaf4b858",
+        "e814309c",
+        "eafca51d",
+        "0daafcde",
+        "7957da17",
+        "760b5254"
+    }},
+    {CHECKSUM_ADLER32, {
+        "00000001",
+        "00010001",
+        "00070004",
+        "000e0007",
+        "003f0016",
+        "005c001d",
+        "023f006a",
+        "02b80079",
+        "137f01d2",
+        "157001f1",
+        "17810211",
+        "a2ff07a2",
+        "aae007e1",
+        "b3010821",
+        "364a1f42",
+        "560b1fc1",
+        "764c2041",
+        "2ad57009",
+        "9bce70f9",
+        "24a77a96",
+        "9f417a9a",
+        "799feaf7",
+        "64b8eb0a",
+        "4fe5eb1e",
+        "9a90d7b2",
+        "40eeb563",
+        "f6a0b5b2",
+        "19f28ab2",
+        "609d8512",
+        "7130294b",
+        "7332fc3c",
+        "fdfe57a2",
+        "52ef5817"
+    }},
+    {CHECKSUM_BSD_SUM, {
+        "00000000",
+        "00000000",
+        "00008002",
+        "00004004",
+        "0000080a",
+        "0000040c",
+        "00000022",
+        "00000020",
+        "00000042",
+        "00000040",
+        "00000040",
+        "00000082",
+        "00000080",
+        "00000080",
+        "00000102",
+        "00000100",
+        "00000100",
+        "000001e0",
+        "000001e0",
+        "0000602b",
+        "0000b019",
+        "00002361",
+        "000091c3",
+        "0000c8f5",
+        "00004b05",
+        "00008083",
+        "0000c090",
+        "00005a6e",
+        "0000e937",
+        "00000889",
+        "0000f9d5",
+        "00006eed",
+        "00005008"
+    }},
+    {CHECKSUM_SHA256, {
+        "e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855",
+        "6e340b9cffb37a989ca544e6bb780a2c78901d3fb33738768511a30617afa01d",
+        "ae4b3280e56e2faf83f414a6e3dabe9d5fbe18976544c05fed121accb85b53fc",
+        "054edec1d0211f624fed0cbca9d4f9400b0e491c43742af2c5b0abebf0c990d8",
+        "57355ac3303c148f11aef7cb179456b9232cde33a818dfda2c2fcb9325749a6b",
+        "8a851ff82ee7048ad09ec3847f1ddf44944104d2cbd17ef4e3db22c6785a0d45",
+        "7071fc3188fde7e7e500d4768f1784bede1a22e991648dcab9dc3219acff1d4c",
+        "be45cb2605bf36bebde684841a28f0fd43c69850a3dce5fedba69928ee3a8991",
+        "4f23c2ca8c5c962e50cd31e221bfb6d0adca19111dca8e0c62598ff146dd19c4",
+        "630dcd2966c4336691125448bbb25b4ff412a49c732db2c8abc1b8581bd710dd",
+        "5d8fcfefa9aeeb711fb8ed1e4b7d5c8a9bafa46e8e76e68aa18adce5a10df6ab",
+        "29af2686fd53374a36b0846694cc342177e428d1647515f078784d69cdb9e488",
+        "fdeab9acf3710362bd2658cdc9a29e8f9c757fcf9811603a8c447cd1d9151108",
+        "4bfd2c8b6f1eec7a2afeb48b934ee4b2694182027e6d0fc075074f2fabb31781",
+        "92ca0fa6651ee2f97b884b7246a562fa71250fedefe5ebf270d31c546bfea976",
+        "471fb943aa23c511f6f72f8d1652d9c880cfa392ad80503120547703e56a2be5",
+        "5099c6a56203f9687f7d33f4bfdf576d31dc91f6b695ecea38b2770c87631135",
+        "abf4bafcddb38bbf3855e47b5e61b75dedbcf42aa44ffd4bb85d0b08d97e2682",
+        "211882aeac8a599b0a55ec280e1a978923edef69cd86541bcbd58db864c45eac",
+        "857df204175f077a9986709897f00ee0bcc0449585248e4b42498337e9329999",
+        "5bc31b283cef0072274e97d74916552954c935794536cab632641e5ea071379d",
+        "1c5e88a585b61754df6137d66632a7348557a88358afc401b0a0a4fc427104a9",
+        "2bce1ba628720664be4b9fdd77aae0678e5f0f3f02fc6ff641ec879094f6a404",
+        "bc0b6b10b89b9487a12fda2a8cc13194e7091c217aabf8b92846274026f4bcd0",
+        "b2a8170614e23194ae2951423d601987f518ce2f11205d7b0b708080103b9f76",
+        "45de2924756389e3ccab98bdaacbef8a81cdeb651b59f916a6d6385b4f7b999d",
+        "d67c656e01756650d77717b0839985a056ec28ffe174601d690fc407a2ceffca",
+        "faec199833036876ac8a1151594ac423c3243c226640620d2bdede86457685cc",
+        "7e3691790cd64b19d4edb1a80e988214515abeb53aa0f34ffbfe4b4bf405d120",
+        "4348e3b98e8a327b34ced39c1da9e67cdb4cd5e48e4d7960607a3ae403d35f0c",
+        "4b640d85ab3ba30fd02c9fc9db4a8928f416322ad27022ea58a65aaee68a4df2",
+        "74588b7f0bcc354ac14d9cf199fa3a20c05f0c7293b9075b2f2e146e718de800",
+        "5769f52bc3eef28afa39c6fc68cadb7d0bd69812ae3a3d71452f519ec3c7aa56"
+    }},
+    {CHECKSUM_SHA1, {
+        "da39a3ee5e6b4b0d3255bfef95601890afd80709",
+        "5ba93c9db0cff93f52b521d7420e43f6eda2784f",
+        "0c7a623fd2bbc05b06423be359e4021d36e721ad",
+        "a02a05b025b928c039cf1ae7e8ee04e7c190c0db",
+        "6dc86f11b8cdbe879bf8ba3832499c2f93c729ba",
+        "67423ebfa8454f19ac6f4686d6c0dc731a3ddd6b",
+        "fb1d9241f67827ce6dd7ac55f1e3c4e4f50caa03",
+        "56178b86a57fac22899a9964185c2cc96e7da589",
+        "43bbacb5f62a0482cbdb564171b04365ca6e27c0",
+        "ae5bd8efea5322c4d9986d06680a781392f9a642",
+        "eb90bce364635c4c23b49f493f0043579bc85c17",
+        "6d942da0c4392b123528f2905c713a3ce28364bd",
+        "c6138d514ffa2135bfce0ed0b8fac65669917ec7",
+        "69bd728ad6e13cd76ff19751fde427b00e395746",
+        "89d7312a903f65cd2b3e34a975e55dbea9033353",
+        "e6434bc401f98603d7eda504790c98c67385d535",
+        "3352e41cc30b40ae80108970492b21014049e625",
+        "f7b8e5e76e6b4cb3dfa7af7070d5560400822b65",
+        "54717f94e8f3ded40b4cc1a470eacb25cb10136f",
+        "47defa228fbd72b6de16bf15fb5ddd0d95f00cab",
+        "d761175408c7032430f9e22f87ce8417be700f73",
+        "1d58257e7e9cecee00473911023732e408e9bee3",
+        "0ac28084ff74933d05123496dafd3791684d9b53",
+        "ca9fdc040579afc74c0e6314fee7af12bd5c4284",
+        "b473a1c7d3ec7fa9036b3158a979dc0c65ab6d98",
+        "2981e06893e00f71bb3aecb4337cf741b91bfc6e",
+        "92ca8f2b4163e64a1b53e0fde263ad56cbdb75fc",
+        "2719c4ea4eec596e26575c056af67921ce9333df",
+        "c7fac2a2751ad1552813f366c3daef8eba512436",
+        "68f3b81a11de1e1629e81555b4e70aed955d1140",
+        "fefb71740a82b94a2da3bcd2fd72fc64a7fb8666",
+        "f18b928d893ae172a000efa19b80e1c04fb36414",
+        "ffbc30b06f6bd51da52f9640804c9d0c4f6e2af2"
+    }},
+    {CHECKSUM_BLAKE3, {
+        "af1349b9f5f9a1a6a0404dea36dcc9499bcb25c9adc112b7cc9a93cae41f3262",
+        "2d3adedff11b61f14c886e35afa036736dcd87a74d27b5c1510225d0f592e213",
+        "e1be4d7a8ab5560aa4199eea339849ba8e293d55ca0a81006726d184519e647f",
+        "f30f5ab28fe047904037f77b6da4fea1e27241c5d132638d8bedce9d40494f32",
+        "3f8770f387faad08faa9d8414e9f449ac68e6ff0417f673f602a646a891419fe",
+        "2351207d04fc16ade43ccab08600939c7c1fa70a5c0aaca76063d04c3228eaeb",
+        "163475fc98871015d19097d29536653bdeac6a9c3a18ad4b3a629cfaa1bbf32e",
+        "a6a492965517a830cb75fdb713465aa465f2f098233896fea44c1d98268bf9e3",
+        "bda80c7fe2db38be6387b35c870bd7728d67b7b6cc5eb9b0e5c7dcb21ea754c2",
+        "e528e95798037df410543d9f31e396ecdd458d71b157d6014398bae32fb56c65",
+        "4f4e6c1dffd3a6c9959876d15aa96b5fb0da8632b995f6ca2e30503f2829fa29",
+        "e9bc37a594daad83be9470df7f7b3798297c3d834ce80ba85d6e207627b7db7b",
+        "4eed7141ea4a5cd4b788606bd23f46e212af9cacebacdc7d1f4c6dc7f2511b98",
+        "de1e5fa0be70df6d2be8fffd0e99ceaa8eb6e8c93a63f2d8d1c30ecb6b263dee",
+        "d81293fda863f008c09e92fc382a81f5a0b4a1251cba1634016a0f86a6bd640d",
+        "f17e570564b26578c33bb7f44643f539624b05df1a76c81f30acd548c44b45ef",
+        "683aaae9f3c5ba37eaaf072aed0f9e30bac0865137bae68b1fde4ca2aebdcb12",
+        "45e1a0dc23dbe51733d7269a3c0f519c2a63b0718835b2b537677eba734db0d8",
+        "749b36ae651c22e8567db692a6876e0ca4fd3daeb7aa8fa3ab2f642ccc69a8f6",
+        "cb97b80a66306dd2d4f1ab7ff9fd17d3d62d88c974e8daf0ea9fbd0b1ae1b1c1",
+        "f462b63aae56ed9fb899ad8eb93aa35d3dd62773fda9c33bfe20f9dab5d3df5f",
+        "10108970eeda3eb932baac1428c7a2163b0e924c9a9e25b35bba72b28f70bd11",
+        "42214739f095a406f3fc83deb889744ac00df831c10daa55189b5d121c855af7",
+        "d00278ae47eb27b34faecf67b4fe263f82d5412916c1ffd97c8cb7fb814b8444",
+        "e776b6028c7cd22a4d0ba182a8bf62205d2ef576467e838ed6f2529b85fba24a",
+        "0cdbdde4d038f0509412a5d1c3b1fb767d5e8c8a0eb2aae963fd36d1f544791a",
+        "015094013f57a5277b59d8475c0501042c0b642e531b0a1c8f58d2163229e969",
+        "f1265c58824e1dc34b8a00127c7d485d76ae8d88254363759e026f0702a18007",
+        "bab6c09cb8ce8cf459261398d2e7aef35700bf488116ceb94a36d0f5f1b7bc3b",
+        "f875d6646de28985646f34ee13be9a576fd515f76b5b0a26bb324735041ddde4",
+        "68d647e619a930e7b1082f74f334b0c65a315725569bdc123f0ee11881717bfe",
+        "bc3e3d41a1146b069abffad3c0d44860cf664390afce4d9661f7902e7943e085",
+        "2f053cd7472cf0cd2f9adaf45c1180255b91b9a865404a63671a0ee5f792ed33"
+    }},
+    {CHECKSUM_XXH64, {
+        "ef46db3751d8e999",
+        "e934a84adb052768",
+        "e5c7bb4533bc65dd",
+        "ffced8604453cc1e",
+        "14cc643f630c72d2",
+        "884a173614b81b8d",
+        "a948f5f0f6abac2d",
+        "44b6ef2fb84169f7",
+        "c346d2b59b4d8ee1",
+        "cbf59c5116ff32b4",
+        "0c535d1acafb8ead",
+        "e26aa9e2a95f8e4f",
+        "f7c67301db6713f0",
+        "c31eb63b2ae4465b",
+        "464d085810ce0199",
+        "7a7fe14647b9ab92",
+        "0ba25dfd6e891fcf",
+        "012947f0da6a27b1",
+        "8d643f23bf2808e1",
+        "566d96b832b967c1",
+        "f33944343ee85824",
+        "d66738f081c25cf4",
+        "138e26c65048ce29",
+        "cfd73aedd2d6a39d",
+        "a69e05a7eff57800",
+        "e6ace0d29750f209",
+        "122a8c8d994ad3ec",
+        "8dc418a0ad1a5db0",
+        "755e4befd10cccf4",
+        "05773fb9ae5fe381",
+        "316c40df46fe2584",
+        "eb1adcdd9e1369a6",
+        "e886e5e68d330119"
+    }},
+    {CHECKSUM_XXH3_64, {
+        "2d06800538d394c2",
+        "c44bdff4074eecdb",
+        "5f4299fc161c9cbb",
+        "60dab036a58211f2",
+        "0cd2084a62406b69",
+        "3a1c2d7c85af88f8",
+        "55ecedc2b87bb042",
+        "8355e3a6f61770db",
+        "4f36db8e4df378fd",
+        "3523581fe96e4c05",
+        "e68c56ba88991e58",
+        "aaa5f0fb98a36ae8",
+        "6187eb9089b0ed55",
+        "6928c76ce90422d0",
+        "120b9787f8425f2f",
+        "85c6174c7ff4c46b",
+        "ec7642b431ba3e5a",
+        "375a384d957fe865",
+        "02e8cd95421c6d02",
+        "074191baf9c49567",
+        "44f5d90dacde463a",
+        "d3d91d80ac495685",
+        "e5d78bafa45b2aa5",
+        "e95c42288f28186e",
+        "25339063db861586",
+        "a541030d777f5abe",
+        "7135ffa504f1bc71",
+        "d3e96ff3d9bf0425",
+        "d6735a2b792cf505",
+        "168f7fb4781d0831",
+        "aaae63800707a868",
+        "1428e17f1cac2837",
+        "47a84c196fd973df"
+    }},
+    {CHECKSUM_XXH3_128, {
+        "99aa06d3014798d86001c324468d497f",
+        "a6cd5e9392000f6ac44bdff4074eecdb",
+        "e3b55f57945a17cf5f4299fc161c9cbb",
+        "eb70bf5fc779e9e6a6111d53e80a3db5",
+        "61ce291bc3a4357ddbb207821e6d5efe",
+        "e1e4432a62217fe4cfd50c61c8bb98c1",
+        "301a9f754e8f569a0017ea4be19bc787",
+        "72950631827607e2842812cc870dcae2",
+        "4ed3946d393b687bb54de3993874ed20",
+        "25e7c9b3424ceed2457d9566b6fcd697",
+        "02175c3aabb00637e08d84951339de86",
+        "bb8d4c458fac1f120302a39b74a9cf52",
+        "9c6e140a465545e590c1971ddb04ce74",
+        "ebedf05eeadc28f11aee64a1615de88f",
+        "d5add870c9c9e00f060c2e3ddf0f2fb9",
+        "14792fc3af88dc6c05321a0b64d67b41",
+        "dd5e74ac6b45f54ebc30b63382b09a3b",
+        "65b5be86da5540e7c92b68e16f83bbb6",
+        "1da1cb61bcb8a2a102e8cd95421c6d02",
+        "65652759c081c563074191baf9c49567",
+        "96c36c85d00e5bc544f5d90dacde463a",
+        "4325711b0ed4d742d3d91d80ac495685",
+        "d0ac1f7b93bf57b9e5d78bafa45b2aa5",
+        "2882ebca04ec915ce95c42288f28186e",
+        "a5141efedfefc1af25339063db861586",
+        "c586959432953ea5a541030d777f5abe",
+        "e12cd72144990fe57135ffa504f1bc71",
+        "d63b53d01c8d2305d3e96ff3d9bf0425",
+        "eaa446aa30f78391d6735a2b792cf505",
+        "89f77cad30e7b59d168f7fb4781d0831",
+        "f5e7bc5d3d8675bfaaae63800707a868",
+        "ecd387d36185351b1428e17f1cac2837",
+        "3db0e7620b0d635947a84c196fd973df"
+    }}
+};
+
+static const kat_crc_vector_t kat_crc_vectors[] = {
+    {"CRC-8/SMBUS", {
+        0x0, 0x0, 0x1b, 0x48, 0x2f, 0xd8, 0x14, 0x41, 0xc7, 0x6, 0xf2, 0xbe, 0x8e, 0x64, 0x31,
+        0xed, 0x4, 0x1d, 0x8d, 0x7f, 0x66, 0x86, 0xe2, 0xcc, 0x12, 0x10, 0x9a, 0xda, 0x71, 0x85,
+        0xad, 0x67, 0x5a
+    }},
+    {"CRC-8/MAXIM-DOW", {
+        0x0, 0x0, 0x78, 0xd8, 0x80, 0xf, 0x21, 0x3c, 0xc8, 0xd4, 0x15, 0x3c, 0xe2, 0x13, 0xd,
+        0x44, 0xab, 0x56, 0x72, 0xce, 0xb4, 0xda, 0x56, 0xfa, 0xa, 0xba, 0x4b, 0x5d, 0x3a, 0x2a,
+        0xae, 0xa2, 0x82
+    }},
+    {"CRC-12/UMTS", {
+        0x0, 0x0, 0x285, 0x8a1, 0x1ee, 0xa6c, 0x1b0, 0x880, 0x5dc, 0x16d, 0x39b, 0x92e, 0x73d,
+        0x181, 0x679, 0x530, 0xbee, 0x85b, 0x801, 0x1c9, 0xc9a, 0xaa2, 0x38e, 0x47f, 0x437,
+        0x307, 0x641, 0x7bb, 0xc6c, 0x40c, 0xb4d, 0xbc0, 0x9e1
+    }},
+    {"CRC-16/ARC", {
+        0x0, 0x0, 0x5180, 0xa110, 0xc6ba, 0x7106, 0xca3a, 0x170a, 0x6b1b, 0xc36a, 0xf742,
+        0x994b, 0x2799, 0x9ae6, 0xe522, 0xf924, 0xbbf8, 0x6c93, 0x292c, 0x3778, 0xe136, 0x6705,
+        0xcee6, 0x854f, 0xb71e, 0xf48b, 0x93f5, 0x2e9e, 0xdf54, 0x8e4c, 0xd9aa, 0xf0df, 0x89a8
+    }},
+    {"CRC-16/MODBUS", {
+        0xffff, 0x40bf, 0x91f1, 0x8510, 0xc6a1, 0x7a46, 0x757a, 0xe7b4, 0xebd5, 0x576b, 0x3717,
+        0x5921, 0x8d9, 0x6ac8, 0x5a79, 0x2da, 0x3b82, 0x63d2, 0x19e3, 0x8f6, 0x8589, 0x1834,
+        0x1a58, 0xf51b, 0x285f, 0x8ba1, 0x4c0b, 0x52d7, 0x9f7b, 0xc5b3, 0x69ab, 0x30e6, 0x49fd
+    }},
+    {"CRC-16/IBM-3740", {
+        0xffff, 0xe1f0, 0xdfef, 0xe5f1, 0x28c2, 0x178d, 0xd551, 0x3b37, 0xc109, 0x23b3, 0x8363,
+        0xfc14, 0xfd2f, 0x5976, 0x7f18, 0x1800, 0x2b1, 0x7eaf, 0xdf46, 0xfef0, 0xbe55, 0xdd1,
+        0x22ff, 0xa995, 0x7bc3, 0x6e2e, 0x1a43, 0xbc60, 0x5f6a, 0x8262, 0xfa10, 0x6597, 0xf05a
+    }},
+    {"CRC-16/XMODEM", {
+        0x0, 0x0, 0x1373, 0x6131, 0xd90c, 0x26b3, 0x9b92, 0x513d, 0x121, 0xd2ff, 0x305d, 0x6f71,
+        0x2bf5, 0x28cd, 0x3141, 0xe80a, 0xe7ae, 0x27de, 0x659a, 0x182c, 0xffbd, 0x8a87, 0x9590,
+        0x11a9, 0xbe47, 0x5236, 0xf59c, 0x78c8, 0xe8c9, 0x8c7d, 0xe71f, 0xec8e, 0x4364
+    }},
+    {"CRC-16/KERMIT", {
+        0x0, 0x0, 0x3aca, 0x5bf7, 0x4f81, 0xe171, 0x8326, 0xbc40, 0x4d25, 0x9e94, 0xf331,
+        0x6fe4, 0x6831, 0x6266, 0xace3, 0x5e49, 0x5b93, 0xbf94, 0x259d, 0xab1e, 0xbf70, 0x517b,
+        0xef1f, 0xbe3c, 0x3090, 0xba47, 0x8cf2, 0x8b7c, 0xe564, 0x873e, 0xff3d, 0x7dab, 0x8cf2
+    }},
+    {"CRC-16/IBM-SDLC", {
+        0x0, 0xf078, 0xfc06, 0xa729, 0xc3f1, 0x6202, 0xbfab, 0x13e9, 0xa6d9, 0x53e4, 0x7003,
+        0x36d2, 0xcca5, 0x4017, 0xc96e, 0xf1b9, 0x5ccb, 0xcef1, 0xe13f, 0x6f86, 0x570d, 0xc465,
+        0xe60d, 0x7dde, 0xeecc, 0x5d84, 0x88fa, 0x61a0, 0xdf76, 0x80b1, 0xf07a, 0x1ac5, 0xfc0
+    }},
+    {"CRC-24/OPENPGP", {
+        0xb704ce, 0x6169d3, 0xc9b567, 0xb4d742, 0xdb039b, 0xde5627, 0xbce9e1, 0x1fa032,
+        0xa2ec02, 0xa2f1e7, 0x4875a9, 0x5fba16, 0xaf643b, 0x7cf0b1, 0x3b2f37, 0xa57233,
+        0x6b48f3, 0xe1dc67, 0x9f6572, 0x908a7d, 0xef92cc, 0x9c33d, 0x2d27bd, 0xc9efa2, 0x4e5cf,
+        0x356bf9, 0x909186, 0xf95b88, 0xfa278b, 0xdc09d7, 0x3f159a, 0xf0cd9f, 0xd019c3
+    }},
+    {"CRC-32/ISO-HDLC", {
+        0x0, 0xd202ef8d, 0x854897f, 0x8bb98613, 0xad5809f9, 0x88aa689f, 0xa06c675e, 0xcecee288,
+        0x4d786d77, 0x91267e8a, 0xe4908305, 0xdbdea683, 0x100ece8c, 0x40c06fd8, 0xdec481aa,
+        0x24650d57, 0xca91cdf7, 0xa60b0b66, 0xcbc8d2f7, 0x6f7c9956, 0x5708a3cc, 0x5a9e0eff,
+        0x7be4dfd0, 0x4e700dfb, 0xdd34ad61, 0xd1a3950a, 0xd465f907, 0x436df98f, 0xaffb0d4d,
+        0xe93e4269, 0x7faa50d3, 0x5cc1ce13, 0x3e8e13cb
+    }},
+    {"CRC-32/ISCSI", {
+        0x0, 0x527d5351, 0x92fd4bfa, 0xd9331aa3, 0xa359ed4c, 0x8a2cbc3b, 0x68ef03f6, 0xd9c908eb,
+        0xe95cabcb, 0x46dd794e, 0x9f85a26d, 0x7a873004, 0xfb6d36eb, 0x694420fa, 0x6c31bd0c,
+        0x30d9c515, 0xf514629f, 0x9f4f71d6, 0x54fe7516, 0xebbd63b3, 0x3449f810, 0x39a4911a,
+        0x2af62c0c, 0xc8d03add, 0x9f7e33f0, 0x5e9ee87c, 0x719077fc, 0xeaf4b858, 0xe814309c,
+        0xeafca51d, 0xdaafcde, 0x7957da17, 0x760b5254
+    }},
+    {"CRC-32/BZIP2", {
+        0x0, 0xb1f7404b, 0x9300784d, 0x949236d5, 0x1d67596e, 0xb53523ed, 0x6d4255bd, 0x568500b2,
+        0x91940b66, 0x707e66af, 0xb706444c, 0x55719aa7, 0x4342f70a, 0xfe436c92, 0xbd3518a4,
+        0xd0e74fbc, 0x2e2f574c, 0xea8a31f9, 0x585db4ed, 0x1db0653d, 0x6f4a5634, 0x430d3f9,
+        0xd372323e, 0x8008bed7, 0xaca638b6, 0xcc1c5719, 0xc9ef9f7c, 0xcd4c7eaf, 0x285443a6,
+        0xaa4277c3, 0xbbc3dc82, 0x5885a6d5, 0x3de00f7e
+    }},
+    {"CRC-32/MPEG-2", {
+        0xffffffff, 0x4e08bfb4, 0x6cff87b2, 0x6b6dc92a, 0xe298a691, 0x4acadc12, 0x92bdaa42,
+        0xa97aff4d, 0x6e6bf499, 0x8f819950, 0x48f9bbb3, 0xaa8e6558, 0xbcbd08f5, 0x1bc936d,
+        0x42cae75b, 0x2f18b043, 0xd1d0a8b3, 0x1575ce06, 0xa7a24b12, 0xe24f9ac2, 0x90b5a9cb,
+        0xfbcf2c06, 0x2c8dcdc1, 0x7ff74128, 0x5359c749, 0x33e3a8e6, 0x36106083, 0x32b38150,
+        0xd7abbc59, 0x55bd883c, 0x443c237d, 0xa77a592a, 0xc21ff081
+    }},
+    {"CRC-64/ECMA-182", {
+        0x0ULL, 0x0ULL, 0x2ae4e9bc005ab22fULL, 0xf805609ece1ecbf3ULL, 0xa3d19996a0f71554ULL,
+        0xa22ae4daa5a6c7ccULL, 0x8518b9c70c99ccfbULL, 0xf9c42d91abaf3b55ULL,
+        0xd5e4d8db4a066c61ULL, 0xdfa033c2de63807aULL, 0x3acf24f8ad05cf07ULL,
+        0x34659b91cdb8183fULL, 0x30ec7f7b5ea3bd0bULL, 0x9c3df04bf8f3a41eULL,
+        0x8851fea2af7853bdULL, 0x59648803aa53d1b9ULL, 0xfedcb1e1e1018620ULL,
+        0x714005859e1e936bULL, 0xf40f81b5ca4b295eULL, 0xf68f365d3fa1fa93ULL,
+        0x8c6ff03dd45225f5ULL, 0x10208b2211927649ULL, 0xe79a002d684812b5ULL,
+        0xdba9618194503566ULL, 0xa813f2d04cac3728ULL, 0x8567da14708f31dULL,
+        0x25ae72b16e38b45ULL, 0x79d500326e6de9bcULL, 0xf18ac57a8242455ULL,
+        0x285d0a831415c2f7ULL, 0xd9ed9db76c519f0fULL, 0x5849abe836521c39ULL,
+        0x5bb5e367a993c773ULL
+    }},
+    {"CRC-64/XZ", {
+        0x0ULL, 0x1fada17364673f59ULL, 0x4a94100384498a10ULL, 0x25d6eeb29d37efaeULL,
+        0xf8a7e1bc0d4384bdULL, 0x53b00311abe6c579ULL, 0xedb6371293e5b0caULL,
+        0x7a64e421b6985356ULL, 0x2f051dae1dfb1c4ULL, 0x7fe571a587084d10ULL,
+        0x997ea74a32b59dcfULL, 0x1272c116cffa2aabULL, 0xd098e69b0b93f24bULL,
+        0xaf76c475ab95eff9ULL, 0xfdf18b596bb90ea0ULL, 0x4cab3fbfb0d759cULL,
+        0xee438e75ce3eb630ULL, 0x8c887e47209c279fULL, 0x4b7b7ed3c194f52cULL,
+        0x54a4a93ef9eb987fULL, 0x4de830b816f1bae9ULL, 0x84b74967e2d3c30cULL,
+        0xa9698966f9c097b2ULL, 0xa20b28cc20b0c276ULL, 0xfa45657424637129ULL,
+        0xd17231400e7c4438ULL, 0xc11ca2ad6897cf60ULL, 0x147938b88d4568daULL,
+        0xf21bd645661e95a1ULL, 0xf627c372ab67b475ULL, 0x27d13bb91868639ULL,
+        0x4b11c0d1c0580595ULL, 0xa0cb47ec92409880ULL
+    }},
+    {"CRC-64/NVME", {
+        0x0ULL, 0xd5da5047efec8728ULL, 0x3f3990291e6454d7ULL, 0x29513a0b0028dea8ULL,
+        0x1614f266082ec7a3ULL, 0x7703cc98ac9209d7ULL, 0x555fd71d5814a5e7ULL,
+        0xcf6454c75df95620ULL, 0x20e642a37cca18aeULL, 0xb9d9d4a8492cbd7fULL,
+        0x9414b48a157e3a0aULL, 0x5e1746b5d43bc84ULL, 0xe13ddeba8972d85cULL,
+        0xc2a59b652d8ed28bULL, 0x81de5ecc9327565cULL, 0xa5296136625de4f7ULL,
+        0xc3d556fcf23d6a24ULL, 0x717e94e4fd87236dULL, 0x2737bbceef8467bcULL,
+        0xb68bbaca86fa640fULL, 0xf2c326111d2018b2ULL, 0xdd84e1fef491ac87ULL,
+        0xfee95dc7adac063fULL, 0x34aba81017791d2ULL, 0xf56105130fc05790ULL,
+        0x477932bcf5bbaa48ULL, 0x9d4cdd5e9b061186ULL, 0x7cdbd675d8a165d9ULL,
+        0xf21100d16c4d3446ULL, 0x3a4cdfef6ad77029ULL, 0xcbea378c7879f505ULL,
+        0x741e1f9c969a9d67ULL, 0x2abb49282d8ffc80ULL
+    }},
+    {"CRC-64/GO-ISO", {
+        0x0ULL, 0x6f90000000000000ULL, 0x6c9e4f9000000000ULL, 0x6d2c9e4f90000000ULL,
+        0x6a58893d2c9e4f90ULL, 0xa8ea58893d2c9e4fULL, 0xeb4f50a76c988728ULL,
+        0x5d6b4f50a76c9887ULL, 0xd4af964bea78445ULL, 0x167d4af964bea784ULL,
+        0x87467d4af964bea7ULL, 0x198eed98cf2ec70aULL, 0x45f98eed98cf2ec7ULL,
+        0xb3c5f98eed98cf2eULL, 0xf110f096387b8c7aULL, 0x681110f096387b8cULL,
+        0x64b81110f096387bULL, 0xfa61795ba91cb92bULL, 0xcf3a61795ba91cb9ULL,
+        0xd48aa4d10c07dd51ULL, 0x1f348aa4d10c07ddULL, 0xa8b6ce7d4e15d735ULL,
+        0x5c98b6ce7d4e15d7ULL, 0xd91c98b6ce7d4e15ULL, 0x871c628840f22570ULL,
+        0x40ca079f1fc556b8ULL, 0xf2c0ca079f1fc556ULL, 0xb531d7c5e2eded3eULL,
+        0x69b7f4f1a5872aa0ULL, 0xf7418f2913a8176dULL, 0x58d5cbe5f4e1b369ULL,
+        0x7a05a265fad6c875ULL, 0xee688ed69a016154ULL
+    }}
+};
+
+#define KAT_MAX_LEN    1048577
+#define KAT_MAX_ALIGN  3
+
+/* Misaligned copies catch kernels that assume aligned loads */
+static const size_t kat_aligns[] = { 0, 1, KAT_MAX_ALIGN };
+
+/* Streaming piece sizes, cycled so pieces cross every internal boundary */
+static const size_t kat_pieces[] = { 1, 3, 64, 127, 1000, 4096, 65599 };
+
+static int failures = 0;
+
+static void to_hex(const unsigned char *digest, size_t len, char *hex) {
+    static const char digits[] = "0123456789abcdef";
+
+    for (size_t i = 0; i < len; i++) {
+        hex[2 * i] = digits[digest[i] >> 4];
+        hex[2 * i + 1] = digits[digest[i] & 0xf];
+    }
+    hex[2 * len] = '\0';
+}
+
+static void expect_hex(const char *how, checksum_type_t type, size_t len, size_t align,
+                       const checksum_result_t *result, const char *expected) {
+    char hex[2 * CHECKSUM_MAX_DIGEST + 1];
+
+    to_hex(result->digest, result->digest_len, hex);
+    if (strcmp(hex, expected) != 0 || result->bytes_processed != len) {
+        fprintf(stderr, "FAIL: %s %s len=%zu align=%zu: got %s, expected %s\n",
+                checksum_name(type), how, len, align, hex, expected);
+        failures++;
+    }
+}
+
+static void test_vector(const kat_vector_t *vector, const unsigned char *data, size_t len,
+                        size_t align, const char *expected) {
+    checksum_ctx_t ctx;
+    checksum_result_t result;
+    struct iovec iov[3];
+    size_t done = 0;
+
+    checksum_init(&ctx, vector->type);
+    checksum_update(&ctx, data, len);
+    checksum_final(&ctx, &result);
+    expect_hex("one-shot", vector->type, len, align, &result, expected);
+
+    checksum_init(&ctx, vector->type);
+    for (size_t k = 0; done < len; k++) {
+        size_t piece = kat_pieces[k % (sizeof(kat_pieces) / sizeof(kat_pieces[0]))];
+
+        if (piece > len - done) {
+            piece = len - done;
+        }
+        checksum_update(&ctx, data + done, piece);
+        done += piece;
+    }
+    checksum_final(&ctx, &result);
+    expect_hex("streamed", vector->type, len, align, &result, expected);
+
+    iov[0].iov_base = (void *)data;
+    iov[0].iov_len = len / 3;
+    iov[1].iov_base = (void *)(data + len / 3);
+    iov[1].iov_len = len / 2 - len / 3;
+    iov[2].iov_base = (void *)(data + len / 2);
+    iov[2].iov_len = len - len / 2;
+    if (checksum_buffers(vector->type, iov, 3, &result) != CHECKSUM_SUCCESS) {
+        fprintf(stderr, "FAIL: %s checksum_buffers len=%zu\n", checksum_name(vector->type), len);
+        failures++;
+        return;
+    }
+    expect_hex("iovec", vector->type, len, align, &result, expected);
+}
+
+static void test_crc_vector(const kat_crc_vector_t *vector, const unsigned char *data, size_t len,
+                            size_t align, uint64_t expected) {
+    const checksum_crc_params_t *params = checksum_crc_find(vector->name);
+    checksum_crc_ctx_t ctx;
+    uint64_t value;
+    size_t done = 0;
+
+    if (!params) {
+        fprintf(stderr, "FAIL: %s missing from the catalog\n", vector->name);
+        failures++;
+        return;
+    }
+
+    value = checksum_crc(params, data, len);
+    if (value != expected) {
+        fprintf(stderr, "FAIL: %s one-shot len=%zu align=%zu: got 0x%llx, expected 0x%llx\n",
+                vector->name, len, align, (unsigned long long)value,
+                (unsigned long long)expected);
+        failures++;
+    }
+
+    checksum_crc_init(&ctx, params);
+    for (size_t k = 0; done < len; k++) {
+        size_t piece = kat_pieces[k % (sizeof(kat_pieces) / sizeof(kat_pieces[0]))];
+
+        if (piece > len - done) {
+            piece = len - done;
+        }
+        checksum_crc_update(&ctx, data + done, piece);
+        done += piece;
+    }
+    value = checksum_crc_final(&ctx);
+    if (value != expected) {
+        fprintf(stderr, "FAIL: %s streamed len=%zu align=%zu: got 0x%llx, expected 0x%llx\n",
+                vector->name, len, align, (unsigned long long)value,
+                (unsigned long long)expected);
+        failures++;
+    }
+}
+
+int main(void) {
+    unsigned char *buf = malloc(KAT_MAX_LEN + KAT_MAX_ALIGN);
+    size_t vectors = sizeof(kat_vectors) / sizeof(kat_vectors[0]);
+    size_t crc_vectors = sizeof(kat_crc_vectors) / sizeof(kat_crc_vectors[0]);
+
+    if (!buf) {
+        fprintf(stderr, "checksum_kat: out of memory\n");
+        return 1;
+    }
+
+    printf("cpu features: 0x%x\n", checksum_cpu_features());
+
+    for (size_t a = 0; a < sizeof(kat_aligns) / sizeof(kat_aligns[0]); a++) {
+        size_t align = kat_aligns[a];
+        unsigned char *data = buf + align;
+
+        for (size_t i = 0; i < KAT_MAX_LEN; i++) {
+            data[i] = (unsigned char)(i % 251);
+        }
+
+        for (size_t n = 0; n < KAT_LENGTHS; n++) {
+            for (size_t v = 0; v < vectors; v++) {
+                test_vector(&kat_vectors[v], data, kat_lengths[n], align, kat_vectors[v].hex[n]);
+            }
+            for (size_t v = 0; v < crc_vectors; v++) {
+                test_crc_vector(&kat_crc_vectors[v], data, kat_lengths[n], align,
+                                kat_crc_vectors[v].value[n]);
+            }
+        }
+    }
+
+    free(buf);
+
+    if (failures) {
+        fprintf(stderr, "%d check(s) failed\n", failures);
+        return 1;
+    }
+    printf("all %zu vectors passed\n", (vectors + crc_vectors) * KAT_LENGTHS);
+    return 0;
+}
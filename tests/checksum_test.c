@@ -0,0 +1,888 @@
+/*
+ * checksum_test.c - Cross-checks for checksum kernels
+ *
+ * Copyright (c) 2025 AnmiTaliDev
+ * Created: 2025-08-09
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#include "checksum.h"
+#include "checksum_kernels.h"
+
+/* Largest random buffer exercised by the cross-checks */
+#define TEST_MAX_LEN  (64 * 1024)
+#define TEST_ROUNDS   2000
+
+static int failures = 0;
+static uint64_t rng_state = 0x9e3779b97f4a7c15ULL;
+
+static uint64_t rng_next(void) {
+    /* xorshift64* - deterministic so failures are reproducible */
+    rng_state ^= rng_state >> 12;
+    rng_state ^= rng_state << 25;
+    rng_state ^= rng_state >> 27;
+    return rng_state * 0x2545f4914f6cdd1dULL;
+}
+
+static size_t rng_length(void) {
+    /* Bias towards short inputs where the kernel tails live */
+    switch (rng_next() % 4) {
+        case 0:  return rng_next() % 64;
+        case 1:  return rng_next() % 1024;
+        default: return rng_next() % TEST_MAX_LEN;
+    }
+}
+
+#define CHECK(cond, ...) do { \
+    if (!(cond)) { \
+        fprintf(stderr, "FAIL: " __VA_ARGS__); \
+        fputc('\n', stderr); \
+        failures++; \
+    } \
+} while (0)
+
+static void test_crc32_check_value(void) {
+    const unsigned char check[] = "123456789";
+
+    CHECK(checksum_crc32(check, 9) == 0xcbf43926u, "crc32 check value");
+    CHECK(checksum_crc32(check, 0) == 0, "crc32 of empty input");
+}
+
+static void test_crc32_kernels(const unsigned char *buf) {
+    unsigned int cpu = checksum_cpu_features();
+    (void)cpu;
+
+    for (int round = 0; round < TEST_ROUNDS; round++) {
+        size_t align = rng_next() % 64;
+        size_t len = rng_length();
+        uint32_t seed = (uint32_t)rng_next();
+        const unsigned char *p = buf + align;
+        uint32_t expect = checksum_crc32_raw_table(seed, p, len);
+
+        CHECK(checksum_crc32_raw(seed, p, len) == expect,
+              "crc32 dispatch len=%zu align=%zu", len, align);
+#if CHECKSUM_HAVE_X86_SIMD
+        if ((cpu & (CHECKSUM_CPU_PCLMUL | CHECKSUM_CPU_SSE41)) ==
+            (CHECKSUM_CPU_PCLMUL | CHECKSUM_CPU_SSE41)) {
+            CHECK(checksum_crc32_raw_pclmul(seed, p, len) == expect,
+                  "crc32 pclmul len=%zu align=%zu", len, align);
+        }
+        if ((cpu & (CHECKSUM_CPU_VPCLMUL | CHECKSUM_CPU_AVX512F | CHECKSUM_CPU_AVX512VL)) ==
+            (CHECKSUM_CPU_VPCLMUL | CHECKSUM_CPU_AVX512F | CHECKSUM_CPU_AVX512VL)) {
+            CHECK(checksum_crc32_raw_vpclmul(seed, p, len) == expect,
+                  "crc32 vpclmul len=%zu align=%zu", len, align);
+        }
+        if ((cpu & (CHECKSUM_CPU_VPCLMUL | CHECKSUM_CPU_AVX2 | CHECKSUM_CPU_SSE41)) ==
+            (CHECKSUM_CPU_VPCLMUL | CHECKSUM_CPU_AVX2 | CHECKSUM_CPU_SSE41)) {
+            CHECK(checksum_crc32_raw_vpclmul_avx2(seed, p, len) == expect,
+                  "crc32 vpclmul-avx2 len=%zu align=%zu", len, align);
+        }
+#endif
+    }
+}
+
+static void test_crc32c_check_value(void) {
+    const unsigned char check[] = "123456789";
+
+    CHECK(checksum_crc32c(check, 9) == 0xe3069283u, "crc32c check value");
+    CHECK(checksum_crc32c(check, 0) == 0, "crc32c of empty input");
+}
+
+static void test_crc32c_kernels(const unsigned char *buf) {
+    unsigned int cpu = checksum_cpu_features();
+    (void)cpu;
+
+    for (int round = 0; round < TEST_ROUNDS; round++) {
+        size_t align = rng_next() % 64;
+        size_t len = rng_length();
+        uint32_t seed = (uint32_t)rng_next();
+        const unsigned char *p = buf + align;
+        uint32_t expect = checksum_crc32c_raw_table(seed, p, len);
+
+        CHECK(checksum_crc32c_raw(seed, p, len) == expect,
+              "crc32c dispatch len=%zu align=%zu", len, align);
+#if CHECKSUM_HAVE_X86_SIMD
+        if (cpu & CHECKSUM_CPU_SSE42) {
+            CHECK(checksum_crc32c_raw_sse42(seed, p, len) == expect,
+                  "crc32c sse4.2 len=%zu align=%zu", len, align);
+        }
+#endif
+    }
+}
+
+static uint32_t adler32_reference(uint32_t adler, const unsigned char *buf, size_t len) {
+    uint32_t a = adler & 0xffff, b = adler >> 16;
+
+    for (size_t i = 0; i < len; i++) {
+        a = (a + buf[i]) % 65521;
+        b = (b + a) % 65521;
+    }
+    return (b << 16) | a;
+}
+
+static void test_adler32_check_value(void) {
+    const unsigned char check[] = "123456789";
+    unsigned char *ones = malloc(1 << 20);
+
+    CHECK(checksum_adler32(check, 9) == 0x091e01deu, "adler32 check value");
+    CHECK(checksum_adler32(check, 0) == 1, "adler32 of empty input");
+
+    /* All-0xff input stresses the deferred modulo bounds */
+    if (ones) {
+        memset(ones, 0xff, 1 << 20);
+        CHECK(checksum_adler32(ones, 1 << 20) == adler32_reference(1, ones, 1 << 20),
+              "adler32 of 1 MiB of 0xff");
+        free(ones);
+    }
+}
+
+static void test_adler32_kernels(const unsigned char *buf) {
+    unsigned int cpu = checksum_cpu_features();
+    (void)cpu;
+
+    for (int round = 0; round < TEST_ROUNDS; round++) {
+        size_t align = rng_next() % 64;
+        size_t len = rng_length();
+        uint32_t a = (uint32_t)(rng_next() % 65521);
+        uint32_t b = (uint32_t)(rng_next() % 65521);
+        uint32_t seed = (b << 16) | a;
+        const unsigned char *p = buf + align;
+        uint32_t expect = adler32_reference(seed, p, len);
+
+        CHECK(checksum_adler32_raw_scalar(seed, p, len) == expect,
+              "adler32 scalar len=%zu align=%zu", len, align);
+        CHECK(checksum_adler32_raw(seed, p, len) == expect,
+              "adler32 dispatch len=%zu align=%zu", len, align);
+#if CHECKSUM_HAVE_X86_SIMD
+        if (cpu & CHECKSUM_CPU_SSSE3) {
+            CHECK(checksum_adler32_raw_ssse3(seed, p, len) == expect,
+                  "adler32 ssse3 len=%zu align=%zu", len, align);
+        }
+        if (cpu & CHECKSUM_CPU_AVX2) {
+            CHECK(checksum_adler32_raw_avx2(seed, p, len) == expect,
+                  "adler32 avx2 len=%zu align=%zu", len, align);
+        }
+#endif
+    }
+}
+
+/* Compare a digest against its expected hex spelling */
+static int digest_is(const unsigned char *digest, size_t len, const char *hex) {
+    char text[2 * CHECKSUM_MAX_DIGEST + 1];
+
+    for (size_t i = 0; i < len; i++) {
+        snprintf(text + 2 * i, 3, "%02x", digest[i]);
+    }
+    return strlen(hex) == 2 * len && memcmp(text, hex, 2 * len) == 0;
+}
+
+static void test_sha_check_values(void) {
+    /* FIPS 180 examples: one block, two blocks, and a million 'a's */
+    const char *two_blocks = "abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq";
+    unsigned char digest[CHECKSUM_MAX_DIGEST];
+    unsigned char *million = malloc(1000000);
+    checksum_sha256_ctx_t ctx;
+
+    checksum_sha256((const unsigned char *)"abc", 3, digest);
+    CHECK(digest_is(digest, 32, "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad"),
+          "sha256 of \"abc\"");
+    checksum_sha256((const unsigned char *)"", 0, digest);
+    CHECK(digest_is(digest, 32, "e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855"),
+          "sha256 of empty input");
+    checksum_sha256((const unsigned char *)two_blocks, strlen(two_blocks), digest);
+    CHECK(digest_is(digest, 32, "248d6a61d20638b8e5c026930c3e6039a33ce45964ff2167f6ecedd419db06c1"),
+          "sha256 of two blocks");
+
+    checksum_sha1((const unsigned char *)"abc", 3, digest);
+    CHECK(digest_is(digest, 20, "a9993e364706816aba3e25717850c26c9cd0d89d"), "sha1 of \"abc\"");
+    checksum_sha1((const unsigned char *)two_blocks, strlen(two_blocks), digest);
+    CHECK(digest_is(digest, 20, "84983e441c3bd26ebaae4aa1f95129e5e54670f1"), "sha1 of two blocks");
+
+    if (million) {
+        memset(million, 'a', 1000000);
+        checksum_sha256(million, 1000000, digest);
+        CHECK(digest_is(digest, 32, "cdc76e5c9914fb9281a1c7e284d73e67f1809a48a497200e046d39ccc7112cd0"),
+              "sha256 of a million 'a'");
+        /* Odd-sized updates exercise the partial-block buffering */
+        checksum_sha256_init(&ctx);
+        for (size_t done = 0; done < 1000000; done += 997) {
+            checksum_sha256_update(&ctx, million + done, done + 997 < 1000000 ? 997 : 1000000 - done);
+        }
+        checksum_sha256_final(&ctx, digest);
+        CHECK(digest_is(digest, 32, "cdc76e5c9914fb9281a1c7e284d73e67f1809a48a497200e046d39ccc7112cd0"),
+              "sha256 of a million 'a' in pieces");
+        checksum_sha1(million, 1000000, digest);
+        CHECK(digest_is(digest, 20, "34aa973cd4c4daa4f61eeb2bdbad27316534016f"),
+              "sha1 of a million 'a'");
+        free(million);
+    }
+}
+
+static void test_sha_kernels(const unsigned char *buf) {
+    unsigned int cpu = checksum_cpu_features();
+    (void)cpu;
+
+    for (int round = 0; round < TEST_ROUNDS / 10; round++) {
+        size_t align = rng_next() % 64;
+        size_t blocks = rng_length() / 64;
+        const unsigned char *p = buf + align;
+        uint32_t seed[8], expect[8], got[8];
+
+        for (int i = 0; i < 8; i++) {
+            seed[i] = (uint32_t)rng_next();
+        }
+
+        memcpy(expect, seed, sizeof(seed));
+        checksum_sha256_blocks_scalar(expect, p, blocks);
+        memcpy(got, seed, sizeof(seed));
+        checksum_sha256_blocks(got, p, blocks);
+        CHECK(memcmp(got, expect, sizeof(got)) == 0, "sha256 dispatch blocks=%zu", blocks);
+#if CHECKSUM_HAVE_X86_SIMD
+        if ((cpu & CHECKSUM_CPU_SHA) && (cpu & CHECKSUM_CPU_SSE41)) {
+            memcpy(got, seed, sizeof(seed));
+            checksum_sha256_blocks_shani(got, p, blocks);
+            CHECK(memcmp(got, expect, sizeof(got)) == 0, "sha256 shani blocks=%zu", blocks);
+        }
+#endif
+
+        memcpy(expect, seed, sizeof(seed));
+        checksum_sha1_blocks_scalar(expect, p, blocks);
+        memcpy(got, seed, sizeof(seed));
+        checksum_sha1_blocks(got, p, blocks);
+        CHECK(memcmp(got, expect, 5 * sizeof(*got)) == 0, "sha1 dispatch blocks=%zu", blocks);
+#if CHECKSUM_HAVE_X86_SIMD
+        if ((cpu & CHECKSUM_CPU_SHA) && (cpu & CHECKSUM_CPU_SSE41)) {
+            memcpy(got, seed, sizeof(seed));
+            checksum_sha1_blocks_shani(got, p, blocks);
+            CHECK(memcmp(got, expect, 5 * sizeof(*got)) == 0, "sha1 shani blocks=%zu", blocks);
+        }
+#endif
+    }
+}
+
+static void test_blake3_check_values(void) {
+    /* Official test vectors: input byte i is i % 251 */
+    static const struct {
+        size_t len;
+        const char *hex;
+    } vectors[] = {
+        {0, "af1349b9f5f9a1a6a0404dea36dcc9499bcb25c9adc112b7cc9a93cae41f3262"},
+        {1, "2d3adedff11b61f14c886e35afa036736dcd87a74d27b5c1510225d0f592e213"},
+        {1023, "10108970eeda3eb932baac1428c7a2163b0e924c9a9e25b35bba72b28f70bd11"},
+        {1024, "42214739f095a406f3fc83deb889744ac00df831c10daa55189b5d121c855af7"},
+        {1025, "d00278ae47eb27b34faecf67b4fe263f82d5412916c1ffd97c8cb7fb814b8444"},
+        {2048, "e776b6028c7cd22a4d0ba182a8bf62205d2ef576467e838ed6f2529b85fba24a"},
+        {2049, "5f4d72f40d7a5f82b15ca2b2e44b1de3c2ef86c426c95c1af0b6879522563030"},
+        {8193, "bab6c09cb8ce8cf459261398d2e7aef35700bf488116ceb94a36d0f5f1b7bc3b"},
+        {31744, "62b6960e1a44bcc1eb1a611a8d6235b6b4b78f32e7abc4fb4c6cdcce94895c47"},
+        {102400, "bc3e3d41a1146b069abffad3c0d44860cf664390afce4d9661f7902e7943e085"},
+    };
+    unsigned char *input = malloc(102400);
+    unsigned char digest[CHECKSUM_BLAKE3_DIGEST];
+
+    if (!input) {
+        return;
+    }
+    for (size_t i = 0; i < 102400; i++) {
+        input[i] = (unsigned char)(i % 251);
+    }
+
+    for (size_t v = 0; v < sizeof(vectors) / sizeof(vectors[0]); v++) {
+        size_t len = vectors[v].len;
+        checksum_blake3_ctx_t ctx;
+
+        checksum_blake3(input, len, digest);
+        CHECK(digest_is(digest, 32, vectors[v].hex), "blake3 len=%zu", len);
+
+        /* Odd-sized pieces take the chunk-state path at every boundary */
+        checksum_blake3_init(&ctx);
+        for (size_t done = 0; done < len; done += 1000) {
+            checksum_blake3_update(&ctx, input + done, done + 1000 < len ? 1000 : len - done);
+        }
+        checksum_blake3_final(&ctx, digest);
+        CHECK(digest_is(digest, 32, vectors[v].hex), "blake3 pieces len=%zu", len);
+
+        checksum_blake3_init(&ctx);
+        checksum_blake3_update_parallel(&ctx, input, len, 4);
+        checksum_blake3_final(&ctx, digest);
+        CHECK(digest_is(digest, 32, vectors[v].hex), "blake3 parallel len=%zu", len);
+    }
+
+    free(input);
+}
+
+static void test_blake3_kernels(const unsigned char *buf) {
+    unsigned int cpu = checksum_cpu_features();
+    (void)cpu;
+
+    for (int round = 0; round < TEST_ROUNDS / 10; round++) {
+        const unsigned char *inputs[40];
+        unsigned char expect[40 * 32], got[40 * 32];
+        uint32_t key[8];
+        size_t count = rng_next() % 40;
+        size_t blocks = 1 + rng_next() % 16;
+        uint64_t counter = rng_next() >> (rng_next() % 64);
+        int increment = (int)(rng_next() & 1);
+        uint8_t flags = (uint8_t)(rng_next() & 0x0f);
+
+        for (int i = 0; i < 8; i++) {
+            key[i] = (uint32_t)rng_next();
+        }
+        for (size_t i = 0; i < count; i++) {
+            inputs[i] = buf + rng_next() % (TEST_MAX_LEN - blocks * 64);
+        }
+
+        checksum_blake3_hash_many_portable(inputs, count, blocks, key, counter, increment, flags,
+                                           1, 2, expect);
+        checksum_blake3_hash_many(inputs, count, blocks, key, counter, increment, flags, 1, 2, got);
+        CHECK(memcmp(got, expect, count * 32) == 0, "blake3 dispatch inputs=%zu blocks=%zu",
+              count, blocks);
+#if CHECKSUM_HAVE_X86_SIMD
+        if (cpu & CHECKSUM_CPU_SSE41) {
+            checksum_blake3_hash_many_sse41(inputs, count, blocks, key, counter, increment, flags,
+                                            1, 2, got);
+            CHECK(memcmp(got, expect, count * 32) == 0, "blake3 sse41 inputs=%zu blocks=%zu",
+                  count, blocks);
+        }
+        if ((cpu & CHECKSUM_CPU_SSE41) && (cpu & CHECKSUM_CPU_AVX2)) {
+            checksum_blake3_hash_many_avx2(inputs, count, blocks, key, counter, increment, flags,
+                                           1, 2, got);
+            CHECK(memcmp(got, expect, count * 32) == 0, "blake3 avx2 inputs=%zu blocks=%zu",
+                  count, blocks);
+        }
+        if ((cpu & CHECKSUM_CPU_SSE41) && (cpu & CHECKSUM_CPU_AVX2) && (cpu & CHECKSUM_CPU_AVX512F)) {
+            checksum_blake3_hash_many_avx512(inputs, count, blocks, key, counter, increment, flags,
+                                             1, 2, got);
+            CHECK(memcmp(got, expect, count * 32) == 0, "blake3 avx512 inputs=%zu blocks=%zu",
+                  count, blocks);
+        }
+#endif
+    }
+}
+
+static void test_xxhash_check_values(void) {
+    /* Reference values from xxHash 0.8; input byte i is i % 251 */
+    static const struct {
+        size_t len;
+        uint64_t xxh64;
+        uint64_t xxh3;
+        const char *xxh128;
+    } vectors[] = {
+        {0, 0xef46db3751d8e999ULL, 0x2d06800538d394c2ULL, "99aa06d3014798d86001c324468d497f"},
+        {3, 0xe5c7bb4533bc65ddULL, 0x5f4299fc161c9cbbULL, "e3b55f57945a17cf5f4299fc161c9cbb"},
+        {8, 0x884a173614b81b8dULL, 0x3a1c2d7c85af88f8ULL, "e1e4432a62217fe4cfd50c61c8bb98c1"},
+        {16, 0x44b6ef2fb84169f7ULL, 0x8355e3a6f61770dbULL, "72950631827607e2842812cc870dcae2"},
+        {100, 0x6ac1e58032166597ULL, 0x004e4f921a64bd1cULL, "da95ef16fd9566f329b20ba5f03ec01e"},
+        {200, 0x50dc1079b99e879cULL, 0xf42a8864feaf0703ULL, "cb0395310643ba0edd97e9af3609d9f5"},
+        {240, 0x012947f0da6a27b1ULL, 0x375a384d957fe865ULL, "65b5be86da5540e7c92b68e16f83bbb6"},
+        {241, 0x8d643f23bf2808e1ULL, 0x02e8cd95421c6d02ULL, "1da1cb61bcb8a2a102e8cd95421c6d02"},
+        {1024, 0x138e26c65048ce29ULL, 0xe5d78bafa45b2aa5ULL, "d0ac1f7b93bf57b9e5d78bafa45b2aa5"},
+        {1025, 0xcfd73aedd2d6a39dULL, 0xe95c42288f28186eULL, "2882ebca04ec915ce95c42288f28186e"},
+        {102400, 0xeb1adcdd9e1369a6ULL, 0x1428e17f1cac2837ULL, "ecd387d36185351b1428e17f1cac2837"},
+    };
+    unsigned char *input = malloc(102400);
+    unsigned char digest[CHECKSUM_XXH128_DIGEST];
+
+    if (!input) {
+        return;
+    }
+    for (size_t i = 0; i < 102400; i++) {
+        input[i] = (unsigned char)(i % 251);
+    }
+
+    for (size_t v = 0; v < sizeof(vectors) / sizeof(vectors[0]); v++) {
+        size_t len = vectors[v].len;
+        checksum_xxh64_ctx_t ctx64;
+        checksum_xxh3_ctx_t ctx3;
+
+        CHECK(checksum_xxh64(input, len) == vectors[v].xxh64, "xxh64 len=%zu", len);
+        CHECK(checksum_xxh3_64(input, len) == vectors[v].xxh3, "xxh3 len=%zu", len);
+        checksum_xxh3_128(input, len, digest);
+        CHECK(digest_is(digest, 16, vectors[v].xxh128), "xxh128 len=%zu", len);
+
+        /* Pieces straddle the 32-byte XXH64 stripes and the 256-byte XXH3 buffer */
+        checksum_xxh64_init(&ctx64);
+        checksum_xxh3_init(&ctx3);
+        for (size_t done = 0; done < len; done += 1000) {
+            size_t n = done + 1000 < len ? 1000 : len - done;
+
+            checksum_xxh64_update(&ctx64, input + done, n);
+            checksum_xxh3_update(&ctx3, input + done, n);
+        }
+        CHECK(checksum_xxh64_final(&ctx64) == vectors[v].xxh64, "xxh64 pieces len=%zu", len);
+        CHECK(checksum_xxh3_64_final(&ctx3) == vectors[v].xxh3, "xxh3 pieces len=%zu", len);
+        checksum_xxh3_128_final(&ctx3, digest);
+        CHECK(digest_is(digest, 16, vectors[v].xxh128), "xxh128 pieces len=%zu", len);
+    }
+
+    free(input);
+}
+
+static void test_xxh3_kernels(const unsigned char *buf) {
+    unsigned int cpu = checksum_cpu_features();
+    (void)cpu;
+
+    for (int round = 0; round < TEST_ROUNDS / 10; round++) {
+        /* Any 192 bytes of the buffer serve as a secret */
+        const unsigned char *secret = buf + rng_next() % (TEST_MAX_LEN - 192);
+        size_t stripes = rng_next() % 17;
+        const unsigned char *input = buf + rng_next() % (TEST_MAX_LEN - stripes * 64);
+        uint64_t expect[8], got[8], start[8];
+
+        for (int i = 0; i < 8; i++) {
+            start[i] = rng_next();
+        }
+
+        memcpy(expect, start, sizeof(start));
+        checksum_xxh3_accumulate_scalar(expect, input, secret, stripes);
+        checksum_xxh3_scramble_scalar(expect, secret + 128);
+#if CHECKSUM_HAVE_X86_SIMD
+        if (cpu & CHECKSUM_CPU_SSE2) {
+            memcpy(got, start, sizeof(start));
+            checksum_xxh3_accumulate_sse2(got, input, secret, stripes);
+            checksum_xxh3_scramble_sse2(got, secret + 128);
+            CHECK(memcmp(got, expect, sizeof(got)) == 0, "xxh3 sse2 stripes=%zu", stripes);
+        }
+        if (cpu & CHECKSUM_CPU_AVX2) {
+            memcpy(got, start, sizeof(start));
+            checksum_xxh3_accumulate_avx2(got, input, secret, stripes);
+            checksum_xxh3_scramble_avx2(got, secret + 128);
+            CHECK(memcmp(got, expect, sizeof(got)) == 0, "xxh3 avx2 stripes=%zu", stripes);
+        }
+#else
+        (void)got;
+#endif
+    }
+}
+
+static void test_combine(const unsigned char *buf) {
+    for (int round = 0; round < TEST_ROUNDS / 10; round++) {
+        size_t len = rng_length();
+        size_t split = len ? rng_next() % (len + 1) : 0;
+        const unsigned char *b = buf + split;
+        size_t len2 = len - split;
+
+        CHECK(checksum_crc32_combine(checksum_crc32(buf, split), checksum_crc32(b, len2), len2) ==
+              checksum_crc32(buf, len), "crc32 combine len=%zu split=%zu", len, split);
+        CHECK(checksum_crc32c_combine(checksum_crc32c(buf, split), checksum_crc32c(b, len2), len2) ==
+              checksum_crc32c(buf, len), "crc32c combine len=%zu split=%zu", len, split);
+        CHECK(checksum_adler32_combine(checksum_adler32(buf, split), checksum_adler32(b, len2), len2) ==
+              checksum_adler32(buf, len), "adler32 combine len=%zu split=%zu", len, split);
+    }
+}
+
+static void test_update_zeros(const unsigned char *buf) {
+    static const checksum_type_t types[] = {
+        CHECKSUM_CRC32, CHECKSUM_CRC32C, CHECKSUM_ADLER32, CHECKSUM_BSD_SUM,
+        CHECKSUM_SHA256, CHECKSUM_XXH3_64
+    };
+    unsigned char *zeros = calloc(1, TEST_MAX_LEN);
+
+    if (!zeros) {
+        CHECK(0, "update_zeros: out of memory");
+        return;
+    }
+    for (size_t t = 0; t < sizeof(types) / sizeof(types[0]); t++) {
+        for (int round = 0; round < 100; round++) {
+            size_t head = rng_next() % 200, hole = rng_length();
+            checksum_ctx_t folded, read;
+            checksum_result_t a, b;
+
+            checksum_init(&folded, types[t]);
+            checksum_update(&folded, buf, head);
+            checksum_update_zeros(&folded, hole);
+            checksum_update(&folded, buf + head, 100);
+            checksum_final(&folded, &a);
+
+            checksum_init(&read, types[t]);
+            checksum_update(&read, buf, head);
+            checksum_update(&read, zeros, hole);
+            checksum_update(&read, buf + head, 100);
+            checksum_final(&read, &b);
+
+            CHECK(a.bytes_processed == b.bytes_processed &&
+                  memcmp(a.digest, b.digest, a.digest_len) == 0,
+                  "%s zeros head=%zu hole=%zu", checksum_name(types[t]), head, hole);
+        }
+    }
+    free(zeros);
+}
+
+static void test_adler32_roll(const unsigned char *buf) {
+    for (int round = 0; round < TEST_ROUNDS / 10; round++) {
+        size_t window = 1 + rng_next() % 8192;
+        uint32_t rolled = checksum_adler32(buf, window);
+
+        for (size_t pos = 1; pos + window <= TEST_MAX_LEN && pos < 300; pos++) {
+            rolled = checksum_adler32_roll(rolled, buf[pos - 1], buf[pos + window - 1], window);
+            if (rolled != checksum_adler32(buf + pos, window)) {
+                CHECK(0, "adler32 roll window=%zu pos=%zu", window, pos);
+                break;
+            }
+        }
+    }
+}
+
+typedef struct {
+    unsigned char *data;
+    size_t len, capacity;
+} sink_t;
+
+static int sink_write(void *ctx, const void *data, size_t len) {
+    sink_t *sink = ctx;
+
+    if (sink->len + len > sink->capacity) {
+        size_t capacity = (sink->len + len) * 2;
+        unsigned char *grown = realloc(sink->data, capacity);
+
+        if (!grown) {
+            return -1;
+        }
+        sink->data = grown;
+        sink->capacity = capacity;
+    }
+    memcpy(sink->data + sink->len, data, len);
+    sink->len += len;
+    return 0;
+}
+
+/* Apply a few random inserts, deletes and overwrites to base */
+static size_t mutate(const unsigned char *base, size_t len, unsigned char *out) {
+    size_t out_len = 0, pos = 0;
+    int edits = (int)(rng_next() % 4);
+
+    for (int e = 0; e < edits && pos < len; e++) {
+        size_t at = pos + rng_next() % (len - pos);
+        size_t n = 1 + rng_next() % 100;
+
+        memcpy(out + out_len, base + pos, at - pos);
+        out_len += at - pos;
+        pos = at;
+        switch (rng_next() % 3) {
+            case 0:
+                for (size_t i = 0; i < n; i++) {
+                    out[out_len++] = (unsigned char)rng_next();
+                }
+                break;
+            case 1:
+                pos += n < len - pos ? n : len - pos;
+                break;
+            default:
+                for (size_t i = 0; i < n && pos < len; i++, pos++) {
+                    out[out_len++] = (unsigned char)~base[pos];
+                }
+                break;
+        }
+    }
+    memcpy(out + out_len, base + pos, len - pos);
+    return out_len + len - pos;
+}
+
+static void test_delta(const unsigned char *buf) {
+    unsigned char *changed = malloc(TEST_MAX_LEN + 400);
+
+    if (!changed) {
+        CHECK(0, "delta: out of memory");
+        return;
+    }
+
+    for (int round = 0; round < 200; round++) {
+        size_t len = rng_length();
+        uint32_t block_size = round % 2 ? 0 : (uint32_t)(1 + rng_next() % 2048);
+        size_t changed_len = mutate(buf, len, changed);
+        checksum_signature_t sig, loaded;
+        sink_t encoded = {0}, delta = {0}, again = {0}, patched = {0};
+
+        CHECK(checksum_signature_build(&sig, buf, len, block_size) == CHECKSUM_SUCCESS,
+              "signature len=%zu", len);
+        CHECK(checksum_signature_write(&sig, sink_write, &encoded) == CHECKSUM_SUCCESS &&
+              checksum_signature_load(&loaded, encoded.data, encoded.len) == CHECKSUM_SUCCESS,
+              "signature round trip len=%zu", len);
+
+        CHECK(checksum_delta(&sig, changed, changed_len, sink_write, &delta) == CHECKSUM_SUCCESS &&
+              checksum_delta(&loaded, changed, changed_len, sink_write, &again) == CHECKSUM_SUCCESS &&
+              delta.len == again.len && memcmp(delta.data, again.data, delta.len) == 0,
+              "delta len=%zu changed=%zu", len, changed_len);
+        CHECK(checksum_patch(buf, len, delta.data, delta.len, sink_write, &patched) ==
+              CHECKSUM_SUCCESS && patched.len == changed_len &&
+              (changed_len == 0 || memcmp(patched.data, changed, changed_len) == 0),
+              "patch len=%zu changed=%zu bs=%u", len, changed_len, sig.block_size);
+
+        /* An unchanged file is all copies: header, one 'C' op and 'E' */
+        again.len = 0;
+        checksum_delta(&sig, buf, len, sink_write, &again);
+        CHECK(len == 0 || again.len == 60 + 17 + 1, "identity delta len=%zu size=%zu",
+              len, again.len);
+
+        if (len > 0) {
+            patched.len = 0;
+            CHECK(checksum_patch(buf, len - 1, delta.data, delta.len, sink_write, &patched) ==
+                  CHECKSUM_ERROR_DATA, "patch rejects another base");
+            delta.data[delta.len - 2] ^= 1;
+            patched.len = 0;
+            CHECK(checksum_patch(buf, len, delta.data, delta.len, sink_write, &patched) ==
+                  CHECKSUM_ERROR_DATA, "patch rejects a corrupt delta");
+        }
+        checksum_signature_free(&loaded);
+        CHECK(checksum_signature_load(&loaded, encoded.data, encoded.len - 1) ==
+              CHECKSUM_ERROR_DATA, "truncated signature rejected");
+
+        checksum_signature_free(&sig);
+        free(encoded.data);
+        free(delta.data);
+        free(again.data);
+        free(patched.data);
+    }
+    free(changed);
+}
+
+static void test_cdc(const unsigned char *buf) {
+    size_t cuts[TEST_MAX_LEN / 256 + 1], ncuts = 0, pos = 0;
+    checksum_cdc_t cdc;
+    size_t shared = 0;
+
+    CHECK(checksum_cdc_init(&cdc, 32, 1024, 8192) == CHECKSUM_ERROR_ARG, "cdc rejects min < 64");
+    CHECK(checksum_cdc_init(&cdc, 4096, 1024, 8192) == CHECKSUM_ERROR_ARG, "cdc rejects min > avg");
+    CHECK(checksum_cdc_init(&cdc, 256, 1024, 8192) == CHECKSUM_SUCCESS, "cdc init");
+
+    /* Chunks tile the input and respect the size bounds */
+    while (pos < TEST_MAX_LEN) {
+        size_t len = checksum_cdc_next(&cdc, buf + pos, TEST_MAX_LEN - pos);
+
+        CHECK(len > 0 && len <= 8192 && (len >= 256 || pos + len == TEST_MAX_LEN),
+              "cdc chunk bounds pos=%zu len=%zu", pos, len);
+        if (len == 0) {
+            break;
+        }
+        pos += len;
+        cuts[ncuts++] = pos;
+    }
+    CHECK(pos == TEST_MAX_LEN, "cdc chunks cover the input");
+    CHECK(ncuts > TEST_MAX_LEN / 4096 && ncuts < TEST_MAX_LEN / 512,
+          "cdc average chunk size %zu", TEST_MAX_LEN / (ncuts ? ncuts : 1));
+
+    /* Dropping the first bytes only moves boundaries near the start */
+    pos = 100;
+    for (size_t c = 0; pos < TEST_MAX_LEN;) {
+        pos += checksum_cdc_next(&cdc, buf + pos, TEST_MAX_LEN - pos);
+        while (c < ncuts && cuts[c] < pos) {
+            c++;
+        }
+        if (c < ncuts && cuts[c] == pos) {
+            shared++;
+        }
+    }
+    CHECK(shared + 4 >= ncuts, "cdc resynchronizes: %zu of %zu boundaries kept", shared, ncuts);
+    CHECK(checksum_cdc_next(&cdc, buf, 0) == 0 && checksum_cdc_next(&cdc, buf, 200) == 200,
+          "cdc short input");
+}
+
+/* Bit-at-a-time Rocksoft model CRC, independent of the generated tables */
+static uint64_t crc_reference(const checksum_crc_params_t *p, const unsigned char *buf,
+                              size_t len) {
+    uint64_t top = 1ULL << (p->width - 1);
+    uint64_t mask = top | (top - 1);
+    uint64_t crc = p->init;
+
+    for (size_t i = 0; i < len; i++) {
+        for (int bit = 0; bit < 8; bit++) {
+            int in = p->refin ? (buf[i] >> bit) & 1 : (buf[i] >> (7 - bit)) & 1;
+            int out = (crc & top) != 0;
+
+            crc = (crc << 1) & mask;
+            if (in ^ out) {
+                crc ^= p->poly;
+            }
+        }
+    }
+    if (p->refout) {
+        uint64_t r = 0;
+
+        for (unsigned int bit = 0; bit < p->width; bit++) {
+            r = (r << 1) | ((crc >> bit) & 1);
+        }
+        crc = r;
+    }
+    return (crc ^ p->xorout) & mask;
+}
+
+static void test_crc_catalog(const unsigned char *buf) {
+    const unsigned char check[] = "123456789";
+    size_t count;
+    const checksum_crc_params_t *catalog = checksum_crc_catalog(&count);
+
+    CHECK(count > 0, "crc catalog is empty");
+    for (size_t i = 0; i < count; i++) {
+        const checksum_crc_params_t *p = &catalog[i];
+        checksum_crc_ctx_t ctx;
+        size_t len = rng_length(), cut = len ? rng_next() % len : 0;
+
+        CHECK(checksum_crc(p, check, 9) == p->check, "%s check value", p->name);
+        CHECK(crc_reference(p, check, 9) == p->check, "%s reference check value", p->name);
+        CHECK(checksum_crc_find(p->name) == p, "%s lookup", p->name);
+        CHECK(!p->alias || checksum_crc_find(p->alias) == p, "%s alias lookup", p->name);
+
+        checksum_crc_init(&ctx, p);
+        checksum_crc_update(&ctx, buf, cut);
+        checksum_crc_update(&ctx, buf + cut, len - cut);
+        CHECK(checksum_crc_final(&ctx) == crc_reference(p, buf, len),
+              "%s streaming len=%zu cut=%zu", p->name, len, cut);
+    }
+
+    CHECK(checksum_crc_find("crc-16/arc") == checksum_crc_find("16/ARC"), "crc lookup prefix");
+    CHECK(checksum_crc_find("CRC-16/NOPE") == NULL, "crc lookup unknown");
+    CHECK(checksum_crc(checksum_crc_find("CRC-32"), buf, 4096) == checksum_crc32(buf, 4096),
+          "generic CRC-32 matches crc32");
+    CHECK(checksum_crc(checksum_crc_find("CRC-32C"), buf, 4096) == checksum_crc32c(buf, 4096),
+          "generic CRC-32C matches crc32c");
+}
+
+static void test_crc_kernels(const unsigned char *buf) {
+    unsigned int cpu = checksum_cpu_features();
+    size_t count;
+    const checksum_crc_params_t *catalog = checksum_crc_catalog(&count);
+    (void)cpu;
+
+    for (int round = 0; round < TEST_ROUNDS; round++) {
+        const checksum_crc_params_t *p = &catalog[rng_next() % count];
+        size_t align = rng_next() % 64;
+        size_t len = rng_length();
+        const unsigned char *data = buf + align;
+        checksum_crc_ctx_t ctx;
+        uint64_t expect;
+
+        /* Any register value within the variant's width is a valid start */
+        checksum_crc_init(&ctx, p);
+        ctx.crc = rng_next() >> (64 - p->width);
+        if (!p->refin) {
+            ctx.crc <<= 64 - p->width;
+        }
+        expect = checksum_crc_raw_table(p, ctx.crc, data, len);
+#if CHECKSUM_HAVE_X86_SIMD
+        if ((cpu & (CHECKSUM_CPU_PCLMUL | CHECKSUM_CPU_SSE41)) ==
+            (CHECKSUM_CPU_PCLMUL | CHECKSUM_CPU_SSE41)) {
+            CHECK(checksum_crc_raw_pclmul(p, ctx.crc, data, len) == expect,
+                  "%s pclmul len=%zu align=%zu", p->name, len, align);
+        }
+#endif
+        checksum_crc_update(&ctx, data, len);
+        CHECK(ctx.crc == expect, "%s dispatch len=%zu align=%zu", p->name, len, align);
+    }
+}
+
+static void test_streaming_api(const unsigned char *buf) {
+    static const checksum_type_t types[] = {
+        CHECKSUM_CRC32, CHECKSUM_CRC32C, CHECKSUM_ADLER32, CHECKSUM_BSD_SUM,
+        CHECKSUM_SHA256, CHECKSUM_SHA1, CHECKSUM_BLAKE3, CHECKSUM_XXH64, CHECKSUM_XXH3_64,
+        CHECKSUM_XXH3_128
+    };
+
+    for (size_t t = 0; t < sizeof(types) / sizeof(types[0]); t++) {
+        for (int round = 0; round < 100; round++) {
+            size_t len = rng_length();
+            size_t split = len ? rng_next() % (len + 1) : 0;
+            struct iovec iov[3];
+            checksum_ctx_t ctx;
+            checksum_result_t whole, pieces, scattered;
+
+            CHECK(checksum_init(&ctx, types[t]) == CHECKSUM_SUCCESS, "init %s", checksum_name(types[t]));
+            checksum_update(&ctx, buf, len);
+            checksum_final(&ctx, &whole);
+
+            checksum_init(&ctx, types[t]);
+            checksum_update(&ctx, buf, split);
+            checksum_update(&ctx, buf + split, len - split);
+            checksum_final(&ctx, &pieces);
+
+            iov[0].iov_base = (void *)buf;
+            iov[0].iov_len = split;
+            iov[1].iov_base = NULL;
+            iov[1].iov_len = 0;
+            iov[2].iov_base = (void *)(buf + split);
+            iov[2].iov_len = len - split;
+            CHECK(checksum_buffers(types[t], iov, 3, &scattered) == CHECKSUM_SUCCESS,
+                  "buffers %s", checksum_name(types[t]));
+
+            CHECK(whole.value == pieces.value && whole.value == scattered.value &&
+                  whole.digest_len == checksum_digest_size(types[t]) &&
+                  memcmp(whole.digest, pieces.digest, whole.digest_len) == 0 &&
+                  memcmp(whole.digest, scattered.digest, whole.digest_len) == 0 &&
+                  whole.bytes_processed == len && scattered.bytes_processed == len,
+                  "%s streaming len=%zu split=%zu", checksum_name(types[t]), len, split);
+        }
+    }
+
+    CHECK(checksum_bsd_sum((const unsigned char *)"123456789", 9) == 0xd16f, "bsd sum check value");
+    CHECK(checksum_init(&(checksum_ctx_t){0}, (checksum_type_t)99) == CHECKSUM_ERROR_ARG,
+          "init rejects unknown type");
+
+    for (size_t t = 0; t < sizeof(types) / sizeof(types[0]); t++) {
+        checksum_type_t parsed;
+
+        CHECK(checksum_type_from_name(checksum_name(types[t]), &parsed) == CHECKSUM_SUCCESS &&
+              parsed == types[t], "name round trip %s", checksum_name(types[t]));
+    }
+    CHECK(checksum_type_from_name("crc", &(checksum_type_t){0}) == CHECKSUM_ERROR_ARG,
+          "unknown name rejected");
+}
+
+int main(void) {
+    unsigned char *buf = malloc(TEST_MAX_LEN + 64);
+
+    if (!buf) {
+        fprintf(stderr, "checksum_test: out of memory\n");
+        return 1;
+    }
+    for (size_t i = 0; i < TEST_MAX_LEN + 64; i++) {
+        buf[i] = (unsigned char)rng_next();
+    }
+
+    printf("cpu features: 0x%x\n", checksum_cpu_features());
+
+    test_crc32_check_value();
+    test_crc32_kernels(buf);
+    test_crc32c_check_value();
+    test_crc32c_kernels(buf);
+    test_adler32_check_value();
+    test_adler32_kernels(buf);
+    test_sha_check_values();
+    test_sha_kernels(buf);
+    test_blake3_check_values();
+    test_blake3_kernels(buf);
+    test_xxhash_check_values();
+    test_xxh3_kernels(buf);
+    test_combine(buf);
+    test_update_zeros(buf);
+    test_adler32_roll(buf);
+    test_delta(buf);
+    test_cdc(buf);
+    test_crc_catalog(buf);
+    test_crc_kernels(buf);
+    test_streaming_api(buf);
+
+    free(buf);
+
+    if (failures) {
+        fprintf(stderr, "%d check(s) failed\n", failures);
+        return 1;
+    }
+    printf("all checks passed\n");
+    return 0;
+}